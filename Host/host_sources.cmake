@@ -0,0 +1,60 @@
+# 主机构建的源文件和头文件目录
+#
+# 包含前设置 FIRMWARE_ROOT 为仓库根目录；
+# 本文件在 ${CMAKE_BINARY_DIR}/case_alias 生成小写文件名的转发头文件，并定义:
+#   HOST_HEADER_DIRS   固件头文件目录
+#   HOST_CASE_DIR      转发头文件目录
+#   FIRMWARE_SOURCES   被测模块（与Keil工程中的文件相同）
+#   HOST_SHIM_SOURCES  外设替身
+
+# 固件源码按Windows习惯大小写混用（"oled.h" 实为 OLED.h），
+# 在构建目录生成小写文件名的转发头文件
+set(HOST_HEADER_DIRS
+    ${FIRMWARE_ROOT}/User
+    ${FIRMWARE_ROOT}/User/max30102
+    ${FIRMWARE_ROOT}/User/oled
+    ${FIRMWARE_ROOT}/User/esp01s
+    ${FIRMWARE_ROOT}/User/ad8232
+    ${FIRMWARE_ROOT}/User/module/display
+    ${FIRMWARE_ROOT}/User/module/transmit)
+set(HOST_CASE_DIR ${CMAKE_BINARY_DIR}/case_alias)
+file(MAKE_DIRECTORY ${HOST_CASE_DIR})
+foreach(dir ${HOST_HEADER_DIRS})
+    file(GLOB headers ${dir}/*.h)
+    foreach(header ${headers})
+        get_filename_component(name ${header} NAME)
+        string(TOLOWER ${name} lower)
+        if(NOT lower STREQUAL name)
+            file(WRITE ${HOST_CASE_DIR}/${lower} "#include \"${header}\"\n")
+        endif()
+    endforeach()
+endforeach()
+
+# 被测模块（与Keil工程中的文件相同）
+set(FIRMWARE_SOURCES
+    ${FIRMWARE_ROOT}/User/max30102/max30102.c
+    ${FIRMWARE_ROOT}/User/max30102/max30102_fir.c
+    ${FIRMWARE_ROOT}/User/max30102/max30102_hr.c
+    ${FIRMWARE_ROOT}/User/max30102/max30102_spo2.c
+    ${FIRMWARE_ROOT}/User/ad8232/AD8232.c
+    ${FIRMWARE_ROOT}/User/ad8232/ecg_qrs.c
+    ${FIRMWARE_ROOT}/User/module/transmit/transmit.c
+    ${FIRMWARE_ROOT}/User/module/transmit/ecg_frame.c
+    ${FIRMWARE_ROOT}/User/module/display/display.c
+    ${FIRMWARE_ROOT}/User/module/ring/ring.c
+    ${FIRMWARE_ROOT}/User/module/scheduler/scheduler.c
+    ${FIRMWARE_ROOT}/User/module/trace/trace.c
+    ${FIRMWARE_ROOT}/User/module/irqstat/irqstat.c
+    ${FIRMWARE_ROOT}/User/oled/OLED.c
+    ${FIRMWARE_ROOT}/User/oled/OLED_Data.c
+    ${FIRMWARE_ROOT}/User/esp01s/Key.c
+    ${FIRMWARE_ROOT}/User/esp01s/esp8266.c)
+
+# 外设替身
+set(HOST_SHIM_SOURCES
+    ${FIRMWARE_ROOT}/Host/shim/hal_gpio.c
+    ${FIRMWARE_ROOT}/Host/shim/hal_adc.c
+    ${FIRMWARE_ROOT}/Host/shim/hal_i2c.c
+    ${FIRMWARE_ROOT}/Host/shim/hal_uart.c
+    ${FIRMWARE_ROOT}/Host/shim/hal_debug_usart.c
+    ${FIRMWARE_ROOT}/Host/shim/hal_timer.c)
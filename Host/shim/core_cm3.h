@@ -0,0 +1,139 @@
+/**
+  ******************************************************************************
+  * @file    core_cm3.h
+  * @brief   主机构建用Cortex-M3内核头文件替身
+  *
+  * @details stm32f10x.h 和 arm_math.h 经 #include "core_cm3.h" 引入内核定义，
+  *          主机构建时本目录排在CMSIS之前，以本文件代替:
+  *          - 内核外设（SysTick等）指向主机内存中的结构体，而不是固定地址
+  *          - 内存屏障、开关中断等内联汇编换成编译器内建函数或空操作
+  *          只提供被编译模块用到的部分，新模块用到其他定义时在此补充
+  ******************************************************************************
+  */
+
+#ifndef __CORE_CM3_H_GENERIC
+#define __CORE_CM3_H_GENERIC
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================ 编译器相关 ============================*/
+
+#define __CM3_CMSIS_VERSION_MAIN  (5U)
+#define __CM3_CMSIS_VERSION_SUB   (0U)
+#define __CORTEX_M                (3U)
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#ifndef __ASM
+#define __ASM               __asm
+#endif
+#ifndef __INLINE
+#define __INLINE            inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE     static inline
+#endif
+
+/*============================ 内核外设 ============================*/
+
+/**
+  * @brief  SysTick寄存器
+  */
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t LOAD;
+    __IOM uint32_t VAL;
+    __IM  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Pos  16U
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_CLKSOURCE_Pos  2U
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << SysTick_CTRL_CLKSOURCE_Pos)
+#define SysTick_CTRL_TICKINT_Pos    1U
+#define SysTick_CTRL_TICKINT_Msk    (1UL << SysTick_CTRL_TICKINT_Pos)
+#define SysTick_CTRL_ENABLE_Pos     0U
+#define SysTick_CTRL_ENABLE_Msk     (1UL)
+
+extern SysTick_Type Host_SysTick;   /**< 见 hal_gpio.c */
+
+#define SysTick             (&Host_SysTick)
+
+/**
+  * @brief  DWT寄存器（只有周期计数相关的部分）
+  */
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+} DWT_Type;
+
+#define DWT_CTRL_NOCYCCNT_Pos       25U
+#define DWT_CTRL_NOCYCCNT_Msk       (1UL << DWT_CTRL_NOCYCCNT_Pos)
+#define DWT_CTRL_CYCCNTENA_Pos      0U
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL)
+
+/**
+  * @brief  CoreDebug寄存器
+  */
+typedef struct
+{
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Pos  24U
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+extern DWT_Type       Host_DWT;         /**< 见 hal_timer.c，CYCCNT随模拟时间推进 */
+extern CoreDebug_Type Host_CoreDebug;
+
+#define DWT                 (&Host_DWT)
+#define CoreDebug           (&Host_CoreDebug)
+
+/*============================ 内核函数 ============================*/
+
+__STATIC_INLINE void __NOP(void)         { }
+__STATIC_INLINE void __enable_irq(void)  { }
+__STATIC_INLINE void __disable_irq(void) { }
+
+/* 主机上生产者/消费者可能在不同线程，屏障保留为完整的内存栅栏 */
+__STATIC_INLINE void __DMB(void)         { __sync_synchronize(); }
+__STATIC_INLINE void __DSB(void)         { __sync_synchronize(); }
+__STATIC_INLINE void __ISB(void)         { __sync_synchronize(); }
+
+__STATIC_INLINE uint32_t __REV(uint32_t value)  { return __builtin_bswap32(value); }
+__STATIC_INLINE uint8_t  __CLZ(uint32_t value)  { return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value); }
+
+__STATIC_INLINE int32_t __SSAT(int32_t val, uint32_t sat)
+{
+    const int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    const int32_t min = -1 - max;
+
+    return (val > max) ? max : ((val < min) ? min : val);
+}
+
+__STATIC_INLINE uint32_t __USAT(int32_t val, uint32_t sat)
+{
+    const uint32_t max = (1U << sat) - 1U;
+
+    return (val < 0) ? 0U : (((uint32_t)val > max) ? max : (uint32_t)val);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CORE_CM3_H_GENERIC */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    hal_adc.c
+  * @brief   ECG采集 (AD.h) 的主机替身
+  *
+  * @details 板上由TIM2触发ADC、DMA写入双缓冲，半满/全满中断各处理半个缓冲；
+  *          这里每送入一个采样点写入当前半缓冲，凑满 AD_DMA_HALF_LEN 点后
+  *          在调用中执行与DMA中断相同的处理
+  ******************************************************************************
+  */
+
+#include "AD.h"
+#include "ad8232.h"
+#include "host_hal.h"
+
+/*============================ 私有变量 ============================*/
+
+static uint16_t AD_DMABuf[AD_DMA_BUF_LEN];  /**< 双缓冲，与板上相同 */
+static uint16_t AD_WritePos = 0;            /**< 下一个采样点的位置 */
+static uint16_t AD_LastValue = 0;           /**< 最近一块的最后一个采样点 */
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  AD初始化
+  */
+void AD_Init(void)
+{
+    AD_WritePos = 0;
+    AD_LastValue = 0;
+}
+
+/**
+  * @brief  获取AD转换的值
+  * @retval 最近一次“DMA中断”时的采样值
+  */
+uint16_t AD_GetValue(void)
+{
+    return AD_LastValue;
+}
+
+/**
+  * @brief  送入一个ECG采样点
+  * @param  sample: 12位ADC值
+  */
+void Host_ADC_Push(uint16_t sample)
+{
+    AD_DMABuf[AD_WritePos++] = sample;
+
+    if (AD_WritePos == AD_DMA_HALF_LEN)
+    {
+        AD_LastValue = sample;
+        ECG_ProcessBlock(&AD_DMABuf[0], AD_DMA_HALF_LEN);
+    }
+    else if (AD_WritePos == AD_DMA_BUF_LEN)
+    {
+        AD_WritePos = 0;
+        AD_LastValue = sample;
+        ECG_ProcessBlock(&AD_DMABuf[AD_DMA_HALF_LEN], AD_DMA_HALF_LEN);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    hal_debug_usart.c
+  * @brief   调试串口驱动 (bsp_debug_usart.h) 的主机替身
+  *
+  * @details 只实现记录器 (ENABLE_TRACE_RECORD) 用到的DMA发送:
+  *          数据在 Usart_SendDMA 中立即交给接收回调，
+  *          Usart_TxBusy 在按波特率发完这些字节之前返回1，
+  *          与板上一样限制记录器的输出速度，队列来不及发出时由记录器丢弃计数。
+  *          printf 在主机上直接输出到标准输出，不经本替身
+  ******************************************************************************
+  */
+
+#include "./usart/bsp_debug_usart.h"
+#include "Timer2.h"
+#include "host_hal.h"
+
+/*============================ 私有变量 ============================*/
+
+#define HOST_DEBUG_USART_BYTE_TICKS (10 * TIM3_COUNTER_FREQ)   /**< 除以波特率得每字节时间 (10us)，8N1 */
+
+static void (*host_debug_sink)(const uint8_t *data, uint16_t len) = NULL;
+static uint32_t host_debug_start = 0;   /**< 本次发送开始时刻 (10us) */
+static uint32_t host_debug_ticks = 0;   /**< 本次发送所需时间 (10us) */
+
+/*============================ bsp_debug_usart接口 ============================*/
+
+void DEBUG_USART_Config(void)
+{
+    host_debug_ticks = 0;
+}
+
+/**
+  * @brief  以DMA发送一段数据
+  * @retval 0: 已启动, 1: 上一次发送未完成
+  */
+uint8_t Usart_SendDMA(const uint8_t *buf, uint16_t len)
+{
+    if (Usart_TxBusy())
+    {
+        return 1;
+    }
+
+    host_debug_start = Timer3_GetTick();
+    host_debug_ticks = (uint32_t)(((uint64_t)len * HOST_DEBUG_USART_BYTE_TICKS + DEBUG_USART_BAUDRATE - 1)
+                                  / DEBUG_USART_BAUDRATE);
+    if (host_debug_sink != NULL)
+    {
+        host_debug_sink(buf, len);
+    }
+    return 0;
+}
+
+/**
+  * @brief  DMA发送是否未完成
+  * @retval 1: 发送中, 0: 空闲
+  */
+uint8_t Usart_TxBusy(void)
+{
+    return (uint32_t)(Timer3_GetTick() - host_debug_start) < host_debug_ticks;
+}
+
+/*============================ 主机控制接口 ============================*/
+
+/**
+  * @brief  设置接收回调
+  */
+void Host_DebugUsart_SetSink(void (*sink)(const uint8_t *data, uint16_t len))
+{
+    host_debug_sink = sink;
+}
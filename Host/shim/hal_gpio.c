@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    hal_gpio.c
+  * @brief   GPIO/RCC/EXTI/NVIC库函数的主机替身
+  *
+  * @details 外设指针 (GPIOA等) 仍是芯片上的固定地址，只用来区分端口，从不解引用。
+  *          每个端口在内存中保存输入电平、输出电平和哪些引脚配置为输出:
+  *          - 读输入: 输出引脚读回输出电平，其余读输入电平
+  *          - 上拉/下拉输入初始化时按上下拉设置输入电平，
+  *            已由 Host_GPIO_SetInput 设置过的引脚保持外部给定的电平
+  *          时钟、EXTI和NVIC配置在主机上没有作用，只接受调用
+  ******************************************************************************
+  */
+
+#include "stm32f10x.h"
+#include "host_hal.h"
+
+/*============================ 私有变量 ============================*/
+
+#define HOST_GPIO_PORTS     3   /**< GPIOA ~ GPIOC */
+
+typedef struct
+{
+    uint16_t idr;           /**< 外部输入电平 */
+    uint16_t odr;           /**< 输出电平 */
+    uint16_t output;        /**< 配置为输出的引脚 */
+    uint16_t driven;        /**< 由 Host_GPIO_SetInput 给定电平的引脚 */
+} Host_GPIO_Port_t;
+
+static Host_GPIO_Port_t host_ports[HOST_GPIO_PORTS];
+static Host_GPIO_Port_t host_port_invalid;  /**< 未模拟的端口，写入丢弃 */
+
+/*============================ 内核与系统 ============================*/
+
+SysTick_Type Host_SysTick;
+uint32_t SystemCoreClock = SYSTEM_CLOCK_HZ;
+
+void SystemInit(void)
+{
+}
+
+void SystemCoreClockUpdate(void)
+{
+}
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  外设指针换成模拟端口
+  */
+static Host_GPIO_Port_t *Host_GPIO_Port(GPIO_TypeDef *GPIOx)
+{
+    if (GPIOx == GPIOA)
+    {
+        return &host_ports[0];
+    }
+    if (GPIOx == GPIOB)
+    {
+        return &host_ports[1];
+    }
+    if (GPIOx == GPIOC)
+    {
+        return &host_ports[2];
+    }
+    return &host_port_invalid;
+}
+
+/**
+  * @brief  引脚当前电平（输出引脚为输出电平）
+  */
+static uint16_t Host_GPIO_Level(const Host_GPIO_Port_t *port)
+{
+    return (uint16_t)((port->odr & port->output) | (port->idr & ~port->output));
+}
+
+/*============================ GPIO ============================*/
+
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    Host_GPIO_Port_t *port = Host_GPIO_Port(GPIOx);
+    uint16_t pins = GPIO_InitStruct->GPIO_Pin;
+    uint16_t pull = pins & ~port->driven;
+
+    if (GPIO_InitStruct->GPIO_Mode & 0x10)
+    {
+        port->output |= pins;
+        return;
+    }
+
+    port->output &= ~pins;
+    if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPU)
+    {
+        port->idr |= pull;
+    }
+    else if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPD)
+    {
+        port->idr &= ~pull;
+    }
+}
+
+void GPIO_StructInit(GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    GPIO_InitStruct->GPIO_Pin = GPIO_Pin_All;
+    GPIO_InitStruct->GPIO_Speed = GPIO_Speed_2MHz;
+    GPIO_InitStruct->GPIO_Mode = GPIO_Mode_IN_FLOATING;
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (Host_GPIO_Level(Host_GPIO_Port(GPIOx)) & GPIO_Pin) ? Bit_SET : Bit_RESET;
+}
+
+uint16_t GPIO_ReadInputData(GPIO_TypeDef *GPIOx)
+{
+    return Host_GPIO_Level(Host_GPIO_Port(GPIOx));
+}
+
+uint8_t GPIO_ReadOutputDataBit(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (Host_GPIO_Port(GPIOx)->odr & GPIO_Pin) ? Bit_SET : Bit_RESET;
+}
+
+uint16_t GPIO_ReadOutputData(GPIO_TypeDef *GPIOx)
+{
+    return Host_GPIO_Port(GPIOx)->odr;
+}
+
+void GPIO_SetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    Host_GPIO_Port(GPIOx)->odr |= GPIO_Pin;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    Host_GPIO_Port(GPIOx)->odr &= ~GPIO_Pin;
+}
+
+void GPIO_WriteBit(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, BitAction BitVal)
+{
+    if (BitVal != Bit_RESET)
+    {
+        GPIO_SetBits(GPIOx, GPIO_Pin);
+    }
+    else
+    {
+        GPIO_ResetBits(GPIOx, GPIO_Pin);
+    }
+}
+
+void GPIO_Write(GPIO_TypeDef *GPIOx, uint16_t PortVal)
+{
+    Host_GPIO_Port(GPIOx)->odr = PortVal;
+}
+
+void GPIO_PinRemapConfig(uint32_t GPIO_Remap, FunctionalState NewState)
+{
+    (void)GPIO_Remap;
+    (void)NewState;
+}
+
+void GPIO_EXTILineConfig(uint8_t GPIO_PortSource, uint8_t GPIO_PinSource)
+{
+    (void)GPIO_PortSource;
+    (void)GPIO_PinSource;
+}
+
+/*============================ RCC / EXTI / NVIC ============================*/
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState)
+{
+    (void)RCC_AHBPeriph;
+    (void)NewState;
+}
+
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+    (void)RCC_APB2Periph;
+    (void)NewState;
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState)
+{
+    (void)RCC_APB1Periph;
+    (void)NewState;
+}
+
+void EXTI_Init(EXTI_InitTypeDef *EXTI_InitStruct)
+{
+    (void)EXTI_InitStruct;
+}
+
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+    (void)NVIC_PriorityGroup;
+}
+
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct)
+{
+    (void)NVIC_InitStruct;
+}
+
+/*============================ 主机控制接口 ============================*/
+
+/**
+  * @brief  设置输入引脚电平
+  * @param  GPIOx: GPIOA ~ GPIOC
+  * @param  GPIO_Pin: 一个或多个引脚
+  * @param  level: 0/1
+  */
+void Host_GPIO_SetInput(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint8_t level)
+{
+    Host_GPIO_Port_t *port = Host_GPIO_Port(GPIOx);
+
+    port->driven |= GPIO_Pin;
+    if (level)
+    {
+        port->idr |= GPIO_Pin;
+    }
+    else
+    {
+        port->idr &= ~GPIO_Pin;
+    }
+}
+
+/**
+  * @brief  读取输出引脚电平
+  * @retval 0/1
+  */
+uint8_t Host_GPIO_GetOutput(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (Host_GPIO_Port(GPIOx)->odr & GPIO_Pin) ? 1 : 0;
+}
@@ -0,0 +1,277 @@
+/**
+  ******************************************************************************
+  * @file    hal_i2c.c
+  * @brief   I2C主机驱动 (bsp_i2c.h) 的主机替身，总线上挂一个MAX30102模型
+  *
+  * @details 传输在 i2c_submit 中同步完成，随后立即调用完成回调（板上在中断中调用），
+  *          回调中再提交的传输同样立即完成。
+  *
+  *          MAX30102模型只实现驱动用到的行为:
+  *          - 寄存器读写地址自动递增，FIFO_DATA除外（连续读出FIFO）
+  *          - 32级FIFO，满时不覆盖（FIFO_ROLLOVER_EN=0），丢弃的点计入OVF_COUNTER，
+  *            读出一个完整采样点后OVF_COUNTER清零
+  *          - 未读点数达到 32 - FIFO_A_FULL 时置A_FULL并拉低INT，读INTERRUPT_STATUS1后释放
+  *          - MODE_CONFIGURATION写入复位位时清空FIFO和寄存器
+  ******************************************************************************
+  */
+
+#include "./i2c/bsp_i2c.h"
+#include "max30102.h"
+#include "host_hal.h"
+#include <string.h>
+
+/*============================ 私有变量 ============================*/
+
+#define MAX30102_PART_ID        0x15
+#define MAX30102_INT_A_FULL     0x80    /**< INTERRUPT_STATUS1: FIFO将满 */
+#define MAX30102_MODE_RESET     0x40    /**< MODE_CONFIGURATION: 复位 */
+
+uint32_t i2c_error_count = 0;
+uint32_t i2c_recover_count = 0;
+
+static uint8_t  max_regs[256];                                          /**< 寄存器 */
+static uint8_t  max_fifo[MAX30102_FIFO_DEPTH][MAX30102_SAMPLE_BYTES];   /**< FIFO */
+static uint8_t  max_fifo_byte = 0;      /**< 当前采样点已读出的字节数 */
+static uint8_t  max_reg_ptr = 0;        /**< 寄存器地址指针 */
+static uint8_t  max_fifo_full = 0;      /**< FIFO已满（满与空时读写指针相同，以此区分） */
+
+/*============================ MAX30102模型 ============================*/
+
+/**
+  * @brief  未读点数
+  */
+static uint8_t Max_Unread(void)
+{
+    return (uint8_t)((max_regs[FIFO_WR_POINTER] - max_regs[FIFO_RD_POINTER]) & (MAX30102_FIFO_DEPTH - 1));
+}
+
+/**
+  * @brief  按中断状态更新INT引脚（开漏，低有效）
+  */
+static void Max_UpdateInt(void)
+{
+    uint8_t active = (max_regs[INTERRUPT_STATUS1] & max_regs[INTERRUPT_ENABLE1]) != 0;
+
+    Host_GPIO_SetInput(MAX30102_INT_GPIO_Port, MAX30102_INT_Pin, active ? 0 : 1);
+}
+
+/**
+  * @brief  复位
+  */
+static void Max_Reset(void)
+{
+    memset(max_regs, 0, sizeof(max_regs));
+    max_regs[PART_ID] = MAX30102_PART_ID;
+    max_fifo_byte = 0;
+    max_fifo_full = 0;
+    max_reg_ptr = 0;
+    Max_UpdateInt();
+}
+
+/**
+  * @brief  写一个寄存器
+  */
+static void Max_Write(uint8_t reg, uint8_t value)
+{
+    if (reg == MODE_CONFIGURATION && (value & MAX30102_MODE_RESET))
+    {
+        Max_Reset();
+        return;
+    }
+
+    max_regs[reg] = value;
+    if (reg == FIFO_WR_POINTER || reg == FIFO_RD_POINTER)
+    {
+        max_regs[reg] &= MAX30102_FIFO_DEPTH - 1;
+        max_fifo_full = 0;
+        max_fifo_byte = 0;
+    }
+    else if (reg == INTERRUPT_ENABLE1)
+    {
+        Max_UpdateInt();
+    }
+}
+
+/**
+  * @brief  读一个寄存器
+  */
+static uint8_t Max_Read(uint8_t reg)
+{
+    uint8_t value;
+
+    if (reg != FIFO_DATA)
+    {
+        value = max_regs[reg];
+        if (reg == INTERRUPT_STATUS1)
+        {
+            max_regs[INTERRUPT_STATUS1] = 0;    /* 读后清除，INT释放 */
+            Max_UpdateInt();
+        }
+        return value;
+    }
+
+    /* FIFO为空时读到的是旧数据，与芯片一致，不推进指针 */
+    if (Max_Unread() == 0 && !max_fifo_full)
+    {
+        return max_fifo[max_regs[FIFO_RD_POINTER]][max_fifo_byte];
+    }
+
+    value = max_fifo[max_regs[FIFO_RD_POINTER]][max_fifo_byte];
+    if (++max_fifo_byte == MAX30102_SAMPLE_BYTES)
+    {
+        max_fifo_byte = 0;
+        max_fifo_full = 0;
+        max_regs[FIFO_RD_POINTER] = (max_regs[FIFO_RD_POINTER] + 1) & (MAX30102_FIFO_DEPTH - 1);
+        max_regs[FIFO_OV_COUNTER] = 0;
+    }
+    return value;
+}
+
+/**
+  * @brief  一次总线传输: 先写（首字节为寄存器地址），再读
+  */
+static uint8_t Max_Transfer(const uint8_t *tx_buf, uint16_t tx_len, uint8_t *rx_buf, uint16_t rx_len)
+{
+    uint16_t i;
+
+    if (tx_len > 0)
+    {
+        max_reg_ptr = tx_buf[0];
+        for (i = 1; i < tx_len; i++)
+        {
+            Max_Write(max_reg_ptr, tx_buf[i]);
+            if (max_reg_ptr != FIFO_DATA)
+            {
+                max_reg_ptr++;
+            }
+        }
+    }
+
+    for (i = 0; i < rx_len; i++)
+    {
+        rx_buf[i] = Max_Read(max_reg_ptr);
+        if (max_reg_ptr != FIFO_DATA)
+        {
+            max_reg_ptr++;
+        }
+    }
+
+    return I2C_XFER_OK;
+}
+
+/*============================ bsp_i2c接口 ============================*/
+
+void I2cMaster_Init(void)
+{
+    Max_Reset();
+}
+
+/**
+  * @brief  提交传输，立即完成
+  * @retval 0: 已完成（结果在 xfer->status）
+  */
+uint8_t i2c_submit(I2C_Xfer_t *xfer)
+{
+    if (xfer->addr != I2C_WRITE_ADDR)
+    {
+        xfer->status = I2C_XFER_NACK;
+        i2c_error_count++;
+    }
+    else
+    {
+        xfer->status = Max_Transfer(xfer->tx_buf, xfer->tx_len, xfer->rx_buf, xfer->rx_len);
+    }
+
+    if (xfer->callback != NULL)
+    {
+        xfer->callback(xfer);
+    }
+    return 0;
+}
+
+uint8_t i2c_is_idle(void)
+{
+    return 1;
+}
+
+void i2c_poll(void)
+{
+}
+
+uint8_t i2c_write_read(uint8_t addr, const uint8_t *tx_buf, uint16_t tx_len, uint8_t *rx_buf, uint16_t rx_len)
+{
+    I2C_Xfer_t xfer;
+
+    xfer.addr = addr;
+    xfer.tx_buf = tx_buf;
+    xfer.tx_len = tx_len;
+    xfer.rx_buf = rx_buf;
+    xfer.rx_len = rx_len;
+    xfer.callback = NULL;
+    i2c_submit(&xfer);
+    return xfer.status;
+}
+
+uint8_t i2c_transmit(uint8_t *pdata, uint8_t data_size)
+{
+    return i2c_write_read(I2C_WRITE_ADDR, pdata, data_size, NULL, 0);
+}
+
+uint8_t i2c_receive(uint8_t *pdata, uint8_t data_size)
+{
+    return i2c_write_read(I2C_WRITE_ADDR, NULL, 0, pdata, data_size);
+}
+
+void delay_ms(uint16_t ms)
+{
+    (void)ms;   /* 只在初始化时使用，主机上不必等待 */
+}
+
+/*============================ 主机控制接口 ============================*/
+
+/**
+  * @brief  MAX30102产生一个采样点
+  * @param  ir, red: 18位原始值
+  */
+void Host_MAX30102_Push(int32_t ir, int32_t red)
+{
+    uint8_t *p;
+    uint8_t threshold = MAX30102_FIFO_DEPTH - (max_regs[FIFO_CONFIGURATION] & 0x0F);
+
+    if (max_fifo_full)
+    {
+        if (max_regs[FIFO_OV_COUNTER] < 0x1F)
+        {
+            max_regs[FIFO_OV_COUNTER]++;
+        }
+        return;
+    }
+
+    p = max_fifo[max_regs[FIFO_WR_POINTER]];
+    p[0] = (uint8_t)(ir >> 16) & 0x03;
+    p[1] = (uint8_t)(ir >> 8);
+    p[2] = (uint8_t)ir;
+    p[3] = (uint8_t)(red >> 16) & 0x03;
+    p[4] = (uint8_t)(red >> 8);
+    p[5] = (uint8_t)red;
+
+    max_regs[FIFO_WR_POINTER] = (max_regs[FIFO_WR_POINTER] + 1) & (MAX30102_FIFO_DEPTH - 1);
+    if (Max_Unread() == 0)
+    {
+        max_fifo_full = 1;
+    }
+
+    if (max_fifo_full || Max_Unread() >= threshold)
+    {
+        max_regs[INTERRUPT_STATUS1] |= MAX30102_INT_A_FULL;
+        Max_UpdateInt();
+    }
+}
+
+/**
+  * @brief  FIFO中未读的采样点数
+  */
+uint8_t Host_MAX30102_Unread(void)
+{
+    return max_fifo_full ? MAX30102_FIFO_DEPTH : Max_Unread();
+}
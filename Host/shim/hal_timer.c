@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    hal_timer.c
+  * @brief   定时器3驱动 (Timer2.h) 的主机替身
+  *
+  * @details 10us时间戳只由 Host_Timer_Advance 推进，任务执行本身不消耗时间，
+  *          因此处理速度只受主机限制。推进时跨过的每个100Hz节拍，
+  *          按顺序执行与 TIM3_IRQHandler CC3分支相同的工作。
+  *          DWT周期计数器使能后按 SYSTEM_CLOCK_HZ 随时间推进，任务执行同样不计周期
+  ******************************************************************************
+  */
+
+#include "Timer2.h"
+#include "ad8232.h"
+#include "key.h"
+#include "module/transmit/transmit.h"
+#include "host_hal.h"
+
+/*============================ 全局变量 ============================*/
+
+DWT_Type       Host_DWT;
+CoreDebug_Type Host_CoreDebug;
+
+/*============================ 私有变量 ============================*/
+
+#define HOST_CYCLES_PER_TICK    (SYSTEM_CLOCK_HZ / TIM3_COUNTER_FREQ)
+
+static uint32_t host_tick = 0;          /**< 当前时间戳 (10us) */
+static uint32_t base_next = 0;          /**< 下一个100Hz节拍时刻 */
+static uint16_t base_counter = 0;       /**< 1Hz分频计数 */
+static uint8_t  timer_running = 0;      /**< Timer3_Init 之后节拍才开始 */
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  100Hz节拍，与 TIM3_IRQHandler 的CC3分支相同
+  */
+static void Host_Timer_Base(void)
+{
+    base_counter++;
+
+    Key_Scan();
+
+    if (base_counter >= SCHED_BASE_FREQ)
+    {
+        base_counter = 0;
+        test++;
+        Transmit_TimerCallback();
+    }
+}
+
+/**
+  * @brief  时间推进到 tick，期间排空串口发送、推进周期计数器
+  */
+static void Host_Timer_MoveTo(uint32_t tick)
+{
+    Host_UART_Tick(tick - host_tick);
+    if (Host_DWT.CTRL & DWT_CTRL_CYCCNTENA_Msk)
+    {
+        Host_DWT.CYCCNT += (tick - host_tick) * HOST_CYCLES_PER_TICK;
+    }
+    host_tick = tick;
+}
+
+/*============================ 函数实现 ============================*/
+
+void Timer3_Init(void)
+{
+    base_next = host_tick + TIM3_BASE_PERIOD;
+    base_counter = 0;
+    timer_running = 1;
+}
+
+uint32_t Timer3_GetTick(void)
+{
+    return host_tick;
+}
+
+/**
+  * @brief  推进时间
+  * @param  ticks: 推进量 (10us)
+  */
+void Host_Timer_Advance(uint32_t ticks)
+{
+    uint32_t target = host_tick + ticks;
+
+    while (timer_running && (int32_t)(target - base_next) >= 0)
+    {
+        Host_Timer_MoveTo(base_next);
+        base_next += TIM3_BASE_PERIOD;
+        Host_Timer_Base();
+    }
+    Host_Timer_MoveTo(target);
+}
@@ -0,0 +1,302 @@
+/**
+  ******************************************************************************
+  * @file    hal_uart.c
+  * @brief   USART2驱动 (usart2.h) 的主机替身
+  *
+  * @details 发送队列、接收队列和按行取出与 usart2.c 相同，只是收发两端换成主机:
+  *
+  *          u2_printf ──> USART2_TxRing ──Host_UART_Tick按波特率排空──> 行拼接 ──> 接收回调
+  *                                                                        └──> ESP8266模型
+  *          Host_UART_Receive ──> USART2_RxRing ──> USART2_ReadLine
+  *
+  *          ESP8266模型对发送的每条AT指令立即回复OK（AT+CWJAP先回复GOT IP，
+  *          AT+RST再回复ready），
+  *          足以让 esp8266.c 的连接脚本走完并进入在线状态
+  ******************************************************************************
+  */
+
+#include "usart2.h"
+#include "host_hal.h"
+#include <stdarg.h>
+#include <string.h>
+
+/*============================ 全局变量 ============================*/
+
+static uint8_t USART2_TX_BUF[USART2_MAX_SEND_LEN];
+
+static uint8_t USART2_TxQueue[USART2_TX_QUEUE_SIZE];
+Ring_t USART2_TxRing;
+
+uint32_t USART2_TxDropCount = 0;
+
+static uint8_t USART2_RxBuf[USART2_RX_BUF_SIZE];
+static Ring_t USART2_RxRing;
+static uint32_t USART2_RxScan = 0;
+
+uint32_t USART2_RxOverflow = 0;
+
+/*============================ 私有变量 ============================*/
+
+#define HOST_UART_TICK_NUM      (HOST_UART_BAUD / 10)   /**< 每秒发送字节数（8N1） */
+
+static void (*host_sink)(const char *line) = NULL;
+static uint8_t host_modem = 0;
+static char    host_line[HOST_UART_LINE_MAX];   /**< 正在拼接的发送行 */
+static uint16_t host_line_len = 0;
+static uint64_t host_byte_credit = 0;           /**< 未满一个字节的发送时间累计 (10us * 字节/秒) */
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  ESP8266模型: 回复一条指令
+  */
+static void Host_UART_ModemReply(const char *line)
+{
+    if (strncmp(line, "AT", 2) != 0)
+    {
+        return;
+    }
+    if (strncmp(line, "AT+CWJAP=", 9) == 0)
+    {
+        Host_UART_Receive("WIFI CONNECTED\r\nWIFI GOT IP\r\n");
+    }
+    Host_UART_Receive("OK\r\n");
+    if (strcmp(line, "AT+RST") == 0)
+    {
+        Host_UART_Receive("ready\r\n");
+    }
+}
+
+/**
+  * @brief  发送出一个字节
+  */
+static void Host_UART_Output(uint8_t byte)
+{
+    if (byte == '\r')
+    {
+        return;
+    }
+    if (byte != '\n')
+    {
+        if (host_line_len < HOST_UART_LINE_MAX - 1)
+        {
+            host_line[host_line_len++] = (char)byte;
+        }
+        return;
+    }
+
+    host_line[host_line_len] = '\0';
+    host_line_len = 0;
+    if (host_sink != NULL)
+    {
+        host_sink(host_line);
+    }
+    if (host_modem)
+    {
+        Host_UART_ModemReply(host_line);
+    }
+}
+
+/*============================ usart2接口 ============================*/
+
+void usart2_init(uint32_t bound)
+{
+    (void)bound;
+    Ring_Init(&USART2_TxRing, USART2_TxQueue, 1, USART2_TX_QUEUE_SIZE);
+    Ring_Init(&USART2_RxRing, USART2_RxBuf, 1, USART2_RX_BUF_SIZE);
+    USART2_RxScan = 0;
+    host_line_len = 0;
+    host_byte_credit = 0;
+}
+
+uint8_t USART2_ReadLine(USART2_Line_t *line)
+{
+    uint32_t head = USART2_RxRing.head;
+    uint32_t start, end;
+    uint16_t offset, len;
+
+    if (Ring_Count(&USART2_RxRing) > USART2_RX_BUF_SIZE)
+    {
+        USART2_RxOverflow++;
+        Ring_Flush(&USART2_RxRing);
+        USART2_RxScan = USART2_RxRing.tail;
+        return 0;
+    }
+
+    while (USART2_RxScan != head)
+    {
+        if (*(uint8_t *)Ring_At(&USART2_RxRing, USART2_RxScan++) != '\n')
+        {
+            continue;
+        }
+
+        start = USART2_RxRing.tail;
+        end = USART2_RxScan - 1;
+        if (end != start && *(uint8_t *)Ring_At(&USART2_RxRing, end - 1) == '\r')
+        {
+            end--;
+        }
+        Ring_Skip(&USART2_RxRing, USART2_RxScan - start);
+
+        if (end == start)
+        {
+            continue;
+        }
+
+        offset = start & (USART2_RX_BUF_SIZE - 1);
+        len = end - start;
+        line->seg1 = (const uint8_t *)Ring_At(&USART2_RxRing, start);
+        if (offset + len <= USART2_RX_BUF_SIZE)
+        {
+            line->len1 = len;
+            line->seg2 = 0;
+            line->len2 = 0;
+        }
+        else
+        {
+            line->len1 = USART2_RX_BUF_SIZE - offset;
+            line->seg2 = &USART2_RxBuf[0];
+            line->len2 = len - line->len1;
+        }
+        return 1;
+    }
+
+    if (USART2_RxScan - USART2_RxRing.tail >= USART2_RX_BUF_SIZE)
+    {
+        USART2_RxOverflow++;
+        Ring_Skip(&USART2_RxRing, USART2_RxScan - USART2_RxRing.tail);
+    }
+
+    return 0;
+}
+
+uint8_t USART2_LineAt(const USART2_Line_t *line, uint16_t i)
+{
+    return (i < line->len1) ? line->seg1[i] : line->seg2[i - line->len1];
+}
+
+int16_t USART2_LineFind(const USART2_Line_t *line, const char *str)
+{
+    uint16_t total = line->len1 + line->len2;
+    uint16_t n = strlen(str);
+    uint16_t i, j;
+
+    if (n == 0 || n > total)
+    {
+        return (n == 0) ? 0 : -1;
+    }
+
+    for (i = 0; i + n <= total; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            if (USART2_LineAt(line, i + j) != (uint8_t)str[j])
+            {
+                break;
+            }
+        }
+        if (j == n)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void USART2_RxFlush(void)
+{
+    Ring_Flush(&USART2_RxRing);
+    USART2_RxScan = USART2_RxRing.tail;
+}
+
+uint16_t USART2_TxFree(void)
+{
+    return Ring_Free(&USART2_TxRing);
+}
+
+uint8_t USART2_Send(const uint8_t *data, uint16_t len)
+{
+    if (len > Ring_Free(&USART2_TxRing))
+    {
+        USART2_TxDropCount++;
+        return 1;
+    }
+
+    Ring_PutN(&USART2_TxRing, data, len);
+    return 0;
+}
+
+uint8_t u2_printf(char *fmt, ...)
+{
+    int len;
+    va_list ap;
+
+    va_start(ap, fmt);
+    len = vsnprintf((char *)USART2_TX_BUF, USART2_MAX_SEND_LEN, fmt, ap);
+    va_end(ap);
+
+    if (len < 0)
+    {
+        return 1;
+    }
+    if (len >= USART2_MAX_SEND_LEN)
+    {
+        /* 与 usart2.c 相同，超长整条丢弃 */
+        USART2_TxDropCount++;
+        return 1;
+    }
+
+    return USART2_Send(USART2_TX_BUF, (uint16_t)len);
+}
+
+/*============================ 主机控制接口 ============================*/
+
+/**
+  * @brief  设置接收回调
+  */
+void Host_UART_SetSink(void (*sink)(const char *line))
+{
+    host_sink = sink;
+}
+
+/**
+  * @brief  使能ESP8266模型
+  */
+void Host_UART_SetModem(uint8_t enable)
+{
+    host_modem = enable;
+}
+
+/**
+  * @brief  模块发来数据
+  * @note   与RXNE中断相同，不检查空间，来不及取出时由 USART2_ReadLine 计入溢出
+  */
+void Host_UART_Receive(const char *text)
+{
+    while (*text != '\0')
+    {
+        Ring_PutOverwrite(&USART2_RxRing, text++);
+    }
+}
+
+/**
+  * @brief  按经过的时间排空发送队列
+  * @param  ticks: 经过的时间 (10us)
+  */
+void Host_UART_Tick(uint32_t ticks)
+{
+    uint8_t byte;
+
+    host_byte_credit += (uint64_t)ticks * HOST_UART_TICK_NUM;
+    while (host_byte_credit >= TIM3_COUNTER_FREQ)
+    {
+        if (!Ring_Get(&USART2_TxRing, &byte))
+        {
+            host_byte_credit = 0;   /* 空闲时间不能攒下来 */
+            return;
+        }
+        host_byte_credit -= TIM3_COUNTER_FREQ;
+        Host_UART_Output(byte);
+    }
+}
@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file    host_hal.h
+  * @brief   主机构建的硬件替身控制接口
+  *
+  * @details 固件模块按原样编译，外设驱动换成主机上的替身:
+  *
+  *          固件模块 ──SPL/驱动接口──> 替身 (hal_*.c) <──Host_xxx── 测试/基准程序
+  *
+  *          - hal_gpio.c : GPIO/RCC/EXTI/NVIC库函数，引脚电平保存在内存中
+  *          - hal_adc.c  : AD.h，按DMA半缓冲凑满一块后交给 ECG_ProcessBlock
+  *          - hal_i2c.c  : bsp_i2c.h，总线上挂一个MAX30102寄存器/FIFO模型
+  *          - hal_uart.c : usart2.h，发送按波特率排空，可选一个只回OK的ESP8266模型
+  *          - hal_debug_usart.c: bsp_debug_usart.h，记录器的DMA发送，按波特率计忙
+  *          - hal_timer.c: Timer2.h，时间只由 Host_Timer_Advance 推进，
+  *                         跨过100Hz节拍时执行与TIM3 CC3中断相同的工作；
+  *                         DWT周期计数器 (core_cm3.h) 随时间推进
+  *
+  *          替身都是同步的: I2C传输在提交时立即完成并调用回调，
+  *          相当于所有中断都在调用点执行完毕
+  *
+  *          kconfig开关: MAX30102_HIGH_RATE、ENABLE_TRACE_RECORD、ENABLE_IRQ_STAT、
+  *          ENABLE_UART_DEBUG 及各功能开关均可在主机上编译；
+  *          OLED_USE_HW_I2C 的I2C1事件中断和DMA发送没有替身，只能用于设备
+  ******************************************************************************
+  */
+
+#ifndef __HOST_HAL_H
+#define __HOST_HAL_H
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "kconfig.h"
+
+#ifdef OLED_USE_HW_I2C
+#error "OLED_USE_HW_I2C is device-only: the host build has no I2C1/DMA1 channel 6 stand-in"
+#endif
+
+/*============================ 宏定义 ============================*/
+
+/** MAX30102 FIFO中采样点产生的速率 (sps) */
+#ifdef MAX30102_HIGH_RATE
+#define HOST_PPG_FIFO_SPS       MAX30102_RAW_SPS
+#else
+#define HOST_PPG_FIFO_SPS       PPG_SAMPLE_FREQ
+#endif
+
+#define HOST_UART_BAUD          115200      /**< USART2波特率，决定发送排空速度 */
+#define HOST_UART_LINE_MAX      640         /**< 交给接收回调的最长一行 (字节) */
+
+/*============================ GPIO ============================*/
+
+/**
+  * @brief  设置输入引脚电平（按键、电极脱落、MAX30102 INT等）
+  * @param  GPIOx: GPIOA ~ GPIOC
+  * @param  GPIO_Pin: 一个或多个引脚
+  * @param  level: 0/1
+  */
+void Host_GPIO_SetInput(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint8_t level);
+
+/**
+  * @brief  读取输出引脚电平（LED等）
+  */
+uint8_t Host_GPIO_GetOutput(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+/*============================ ADC ============================*/
+
+/**
+  * @brief  送入一个ECG采样点（相当于一次TIM2触发的ADC转换）
+  * @note   凑满一个DMA半缓冲后在调用中执行 ECG_ProcessBlock
+  */
+void Host_ADC_Push(uint16_t sample);
+
+/*============================ MAX30102 ============================*/
+
+/**
+  * @brief  MAX30102产生一个采样点，写入FIFO
+  * @param  ir, red: 18位原始值
+  * @note   FIFO满时丢弃并累加溢出计数；达到将满阈值时拉低INT引脚 (PB5)
+  */
+void Host_MAX30102_Push(int32_t ir, int32_t red);
+
+/**
+  * @brief  FIFO中未读的采样点数
+  */
+uint8_t Host_MAX30102_Unread(void);
+
+/*============================ UART ============================*/
+
+/**
+  * @brief  设置接收回调，发送出的每一行（去掉\r\n）交给它
+  * @param  sink: 回调，NULL为不接收
+  */
+void Host_UART_SetSink(void (*sink)(const char *line));
+
+/**
+  * @brief  使能ESP8266模型
+  * @param  enable: 1: 对发送的每条AT指令回复OK（入网、复位另有相应回复），
+  *                 模块因此很快进入在线状态; 0: 不回复
+  */
+void Host_UART_SetModem(uint8_t enable);
+
+/**
+  * @brief  模块发来数据，放入接收队列
+  */
+void Host_UART_Receive(const char *text);
+
+/**
+  * @brief  按经过的时间排空发送队列（由 Host_Timer_Advance 调用）
+  * @param  ticks: 经过的时间 (10us)
+  */
+void Host_UART_Tick(uint32_t ticks);
+
+/*============================ 调试串口 ============================*/
+
+/**
+  * @brief  设置接收回调，DMA发送的每段数据交给它
+  * @param  sink: 回调，NULL为丢弃
+  */
+void Host_DebugUsart_SetSink(void (*sink)(const uint8_t *data, uint16_t len));
+
+/*============================ 定时器 ============================*/
+
+/**
+  * @brief  推进时间
+  * @param  ticks: 推进量 (10us)
+  * @note   跨过的每个100Hz节拍按顺序执行按键扫描和1Hz计时，
+  *         并按经过的时间排空串口发送
+  */
+void Host_Timer_Advance(uint32_t ticks);
+
+#endif /* __HOST_HAL_H */
@@ -0,0 +1,18 @@
+/**
+  ******************************************************************************
+  * @file    system_stm32f10x.h
+  * @brief   主机构建用系统时钟头文件替身
+  ******************************************************************************
+  */
+
+#ifndef __SYSTEM_STM32F10X_H
+#define __SYSTEM_STM32F10X_H
+
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;    /**< 固定为 SYSTEM_CLOCK_HZ，见 hal_gpio.c */
+
+void SystemInit(void);
+void SystemCoreClockUpdate(void);
+
+#endif /* __SYSTEM_STM32F10X_H */
@@ -0,0 +1,234 @@
+/**
+  ******************************************************************************
+  * @file    test_fixed_point.c
+  * @brief   定点滤波与血氧换算的回归测试
+  *
+  * @details 用法: test_fixed_point（由 ctest 运行，全部通过返回0）
+  *
+  *          - PPG低通: max30102_fir_block 与按 arm_fir_f32 方式计算的单精度浮点FIR比较，
+  *            输入为PPG样波形和满量程18位随机数，块长1~40（含超过一块的分块和原地滤波），
+  *            误差不超过 FIR_TOLERANCE_LSB
+  *          - 标定多项式: MAX30102_SpO2_FromRatio 与浮点多项式比较，
+  *            R 取 (0, 3] 内全部Q10值，误差不超过 SPO2_POLY_TOLERANCE (0.001%)
+  *          - 血氧链路: 已知R的合成PPG经FIR和 MAX30102_SpO2_Update，
+  *            结果与浮点多项式之差小于1%（输出为整数百分比）
+  ******************************************************************************
+  */
+
+#include "max30102_fir.h"
+#include "max30102_spo2.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*============================ 宏定义 ============================*/
+
+#define FIR_TAPS                29
+#define FIR_TOLERANCE_LSB       1.03    /**< 定点FIR与浮点FIR之差上限 (LSB) */
+#define SPO2_POLY_TOLERANCE     50      /**< 定点多项式与浮点之差上限 (0.001%) */
+
+#define TEST_SAMPLES            20000   /**< 每种输入的采样点组数 */
+#define TEST_BLOCK_MAX          40      /**< 最大块长，超过 MAX30102_FIR_BLOCK_MAX 以覆盖分块 */
+#define TEST_PI                 3.14159265358979
+#define TEST_FS                 PPG_SAMPLE_FREQ
+#define TEST_HR_BPM             72.0
+
+/*============================ 浮点参考 ============================*/
+
+/** 原 arm_fir_f32 使用的系数表（fdatool生成） */
+static const float ref_coeffs[FIR_TAPS] = {
+    -0.001542701735f, -0.002211477375f, -0.003286228748f, -0.00442651147f,  -0.004758632276f,
+    -0.003007677384f,  0.002192312852f,  0.01188309677f,   0.02637642808f,   0.04498152807f,
+     0.06596207619f,   0.0867607221f,    0.1044560149f,    0.1163498312f,    0.1205424443f,
+     0.1163498312f,    0.1044560149f,    0.0867607221f,    0.06596207619f,   0.04498152807f,
+     0.02637642808f,   0.01188309677f,   0.002192312852f, -0.003007677384f, -0.004758632276f,
+    -0.00442651147f,  -0.003286228748f, -0.002211477375f, -0.001542701735f
+};
+
+/**
+  * @brief  单通道浮点FIR，与 arm_fir_f32 相同: 零初始状态，单精度逐项累加
+  */
+typedef struct
+{
+    float x[FIR_TAPS];      /**< x[0]为当前点 */
+} Ref_Fir_t;
+
+static float Ref_FirStep(Ref_Fir_t *f, float in)
+{
+    float acc = 0.0f;
+    int k;
+
+    memmove(&f->x[1], &f->x[0], (FIR_TAPS - 1) * sizeof(float));
+    f->x[0] = in;
+    for (k = 0; k < FIR_TAPS; k++)
+    {
+        acc += ref_coeffs[k] * f->x[k];
+    }
+    return acc;
+}
+
+static double Ref_SpO2(double r)
+{
+    double spo2 = -45.060 * r * r + 30.354 * r + 94.845;
+
+    return (spo2 < 0.0) ? 0.0 : ((spo2 > 100.0) ? 100.0 : spo2);
+}
+
+/*============================ 输入 ============================*/
+
+static uint32_t test_rand_state = 1;
+
+static uint32_t Test_Rand(void)
+{
+    test_rand_state = test_rand_state * 1664525u + 1013904223u;
+    return test_rand_state >> 8;
+}
+
+/** PPG样波形: 直流 + 心搏 + 呼吸基线 + 噪声，18位范围内 */
+static int32_t Test_Ppg(uint32_t n, double dc, double ac)
+{
+    double t = (double)n / TEST_FS;
+    double beat = sin(2.0 * TEST_PI * TEST_HR_BPM / 60.0 * t);
+    double breath = sin(2.0 * TEST_PI * 0.25 * t);
+
+    return (int32_t)(dc + ac * beat + 0.01 * dc * breath + (double)(Test_Rand() % 64) - 32.0);
+}
+
+/*============================ 测试 ============================*/
+
+/**
+  * @brief  定点FIR与浮点FIR逐点比较
+  * @param  kind: 0 PPG样波形, 1 满量程随机数
+  * @retval 最大误差 (LSB)
+  */
+static double Test_Fir(int kind)
+{
+    static int32_t buf[TEST_BLOCK_MAX * 2];
+    static float ref[TEST_BLOCK_MAX * 2];
+    Ref_Fir_t ref_ir, ref_red;
+    double err, max_err = 0.0;
+    uint32_t n = 0;
+    uint16_t blk, i;
+
+    memset(&ref_ir, 0, sizeof(ref_ir));
+    memset(&ref_red, 0, sizeof(ref_red));
+    max30102_fir_init();
+
+    while (n < TEST_SAMPLES)
+    {
+        blk = (uint16_t)(1 + Test_Rand() % TEST_BLOCK_MAX);
+        for (i = 0; i < blk; i++)
+        {
+            if (kind == 0)
+            {
+                buf[i * 2]     = Test_Ppg(n + i, 120000.0, 1500.0);
+                buf[i * 2 + 1] = Test_Ppg(n + i, 90000.0, 900.0);
+            }
+            else
+            {
+                buf[i * 2]     = (int32_t)(Test_Rand() & 0x3FFFF);
+                buf[i * 2 + 1] = (int32_t)(Test_Rand() & 0x3FFFF);
+            }
+        }
+
+        /* 参考先取输入，被测原地滤波 */
+        for (i = 0; i < blk; i++)
+        {
+            ref[i * 2]     = Ref_FirStep(&ref_ir, (float)buf[i * 2]);
+            ref[i * 2 + 1] = Ref_FirStep(&ref_red, (float)buf[i * 2 + 1]);
+        }
+        max30102_fir_block(buf, buf, blk);
+
+        for (i = 0; i < blk * 2; i++)
+        {
+            err = fabs((double)buf[i] - ref[i]);
+            max_err = (err > max_err) ? err : max_err;
+        }
+        n += blk;
+    }
+    return max_err;
+}
+
+/**
+  * @brief  定点多项式与浮点多项式在 (0, 3] 内逐个Q10值比较
+  * @retval 最大误差 (0.001%)
+  */
+static double Test_SpO2Poly(void)
+{
+    double err, max_err = 0.0;
+    uint16_t r;
+
+    for (r = 1; r <= (3 << 10); r++)
+    {
+        err = fabs((double)MAX30102_SpO2_FromRatio(r) - Ref_SpO2(r / 1024.0) * 1000.0);
+        max_err = (err > max_err) ? err : max_err;
+    }
+    return max_err;
+}
+
+/**
+  * @brief  已知R的合成PPG经FIR和逐拍血氧计算
+  * @param  r: 设定的 (AC_ir/DC_ir) / (AC_red/DC_red)
+  * @retval 血氧结果与浮点多项式之差 (%)
+  */
+static double Test_SpO2Path(double r)
+{
+    const double dc_ir = 120000.0, dc_red = 90000.0;
+    const double ac_ir = dc_ir * 0.02;
+    const double ac_red = dc_red * 0.02 / r;
+    const double period = TEST_FS * 60.0 / TEST_HR_BPM;
+    int32_t buf[2];
+    uint32_t n;
+    double phase;
+
+    max30102_fir_init();
+    MAX30102_SpO2_Reset();
+
+    for (n = 0; n < TEST_FS * 30; n++)
+    {
+        phase = 2.0 * TEST_PI * n / period;
+        buf[0] = (int32_t)(dc_ir + ac_ir * sin(phase));
+        buf[1] = (int32_t)(dc_red + ac_red * sin(phase));
+        max30102_fir_block(buf, buf, 1);
+
+        /* 等滤波器和DC低通稳定后再标心跳，每个周期开始时一次 */
+        MAX30102_SpO2_Update(buf[0], buf[1],
+                             n >= TEST_FS * 5 && (uint32_t)(n / period) != (uint32_t)((n + 1) / period));
+    }
+    return fabs((double)MAX30102_SpO2_Get() - Ref_SpO2(r));
+}
+
+/*============================ 主程序 ============================*/
+
+static int test_failed = 0;
+
+static void Test_Check(const char *name, double value, double limit)
+{
+    int ok = value <= limit;
+
+    printf("%-4s %-14s %8.4f  (limit %g)\n", ok ? "ok" : "FAIL", name, value, limit);
+    if (!ok)
+    {
+        test_failed = 1;
+    }
+}
+
+int main(void)
+{
+    static const double ratios[] = { 0.4, 0.5, 0.7, 1.0 };
+    char name[16];
+    unsigned i;
+
+    Test_Check("fir_ppg", Test_Fir(0), FIR_TOLERANCE_LSB);
+    Test_Check("fir_random", Test_Fir(1), FIR_TOLERANCE_LSB);
+    Test_Check("spo2_poly", Test_SpO2Poly(), SPO2_POLY_TOLERANCE);
+    for (i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++)
+    {
+        snprintf(name, sizeof(name), "spo2_r%.1f", ratios[i]);
+        Test_Check(name, Test_SpO2Path(ratios[i]), 1.0);
+    }
+
+    return test_failed;
+}
@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file    test_ppg_startup.c
+  * @brief   PPG心率/血氧首次出值时间的回归测试
+  *
+  * @details 用法: test_ppg_startup（由 ctest 运行，全部通过返回0）
+  *
+  *          合成PPG（72bpm，R = 0.5，血氧约98.8%）按FIFO突发块经 max30102_fir_block
+  *          和 MAX30102_ProcessSample，与 MAX30102_Process 的处理相同，统计手指放上到
+  *          首个非零心率/血氧的时间，并要求首个值接近真值。
+  *          手指放上的时刻在一个心动周期内取 TEST_PHASES 个值，取最坏情况:
+  *          - cold:    上电即放手指，滤波器从零状态开始
+  *          - replace: 先无手指2秒，再放上
+  *          - again:   手指离开1秒后以不同的DC和相位重新放上
+  *          - jump:    测量中DC突变（按压变化），偏差超过限幅，心率中断时间不超过上限
+  ******************************************************************************
+  */
+
+#include "max30102.h"
+#include "max30102_fir.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*============================ 宏定义 ============================*/
+
+#define TEST_FS                 PPG_SAMPLE_FREQ
+#define TEST_HR_BPM             72.0
+#define TEST_SPO2               98.76   /**< R = 0.5 时的标定多项式值 */
+#define TEST_BLOCK              8       /**< 每次取出的采样点组数，与FIFO将满时相近 */
+#define TEST_PHASES             16      /**< 手指放上时刻在一个心动周期内取的点数 */
+#define TEST_SEGMENTS_MAX       4       /**< 每种输入最多的段数 */
+
+#define FIRST_HR_LIMIT          3.6     /**< 手指放上到首个心率的上限 (s): 滤波器稳定、均值预热约1s + 最多3个心动周期 */
+#define FIRST_SPO2_LIMIT        3.0     /**< 手指放上到首个血氧的上限 (s) */
+#define JUMP_GAP_LIMIT          1.0     /**< DC突变后心率为0的最长时间 (s) */
+#define HR_TOLERANCE            3.0     /**< 首个心率与真值之差上限 (bpm) */
+#define SPO2_TOLERANCE          2.0     /**< 首个血氧与真值之差上限 (%) */
+
+/*============================ 输入 ============================*/
+
+static uint32_t test_rand_state = 1;
+
+/** 均匀噪声 [-1, 1) */
+static double Test_Noise(void)
+{
+    test_rand_state = test_rand_state * 1664525u + 1013904223u;
+    return (double)(test_rand_state >> 8) / 8388608.0 - 1.0;
+}
+
+static double Test_Gauss(double t, double center, double width)
+{
+    double x = (t - center) / width;
+
+    return exp(-0.5 * x * x);
+}
+
+/** PPG脉搏波形，收缩峰加重搏波，峰值约1（与 host_bench 相同） */
+static double Test_Pulse(double t)
+{
+    double p = fmod(t, 60.0 / TEST_HR_BPM);
+
+    return Test_Gauss(p, 0.15, 0.06) + 0.35 * Test_Gauss(p, 0.42, 0.08);
+}
+
+/**
+  * @brief  一段输入
+  */
+typedef struct
+{
+    double duration;    /**< 持续时间 (s) */
+    int    finger;      /**< 0: 无手指 */
+    double dc_ir;       /**< IR直流，RED为其0.8倍 */
+    double phase;       /**< 脉搏相位偏移 (s) */
+} Test_Segment_t;
+
+/**
+  * @brief  首次出值统计
+  */
+typedef struct
+{
+    double first_hr;    /**< 最后一次手指放上到首个心率 (s)，没有时为负 */
+    double first_spo2;  /**< 同上，血氧 */
+    uint16_t hr;        /**< 首个心率 */
+    uint16_t spo2;      /**< 首个血氧 */
+    double max_gap;     /**< 首个心率之后心率为0的最长时间 (s) */
+} Test_Result_t;
+
+/**
+  * @brief  按段生成输入并处理，只统计最后一次手指放上之后
+  */
+static void Test_Run(const Test_Segment_t *seg, unsigned nseg, Test_Result_t *res)
+{
+    int32_t raw[TEST_BLOCK * 2];
+    int32_t filtered[TEST_BLOCK * 2];
+    const MAX30102_Data_t *data = MAX30102_GetData();
+    double t = 0.0, seg_start = 0.0, finger_on = -1.0, gap_start = -1.0, pulse;
+    uint32_t n = 0;
+    unsigned s = 0, count, i;
+    int finger = 0;
+
+    res->first_hr = res->first_spo2 = -1.0;
+    res->hr = res->spo2 = 0;
+    res->max_gap = 0.0;
+
+    max30102_fir_init();
+    test_rand_state = 1;
+
+    while (s < nseg)
+    {
+        for (count = 0; count < TEST_BLOCK; count++)
+        {
+            t = (double)n / TEST_FS;
+            while (s < nseg && t >= seg_start + seg[s].duration)
+            {
+                seg_start += seg[s++].duration;
+            }
+            if (s >= nseg)
+            {
+                break;
+            }
+            n++;
+
+            /* 手指放上，重新统计 */
+            if (seg[s].finger && !finger)
+            {
+                finger_on = t;
+                res->first_hr = res->first_spo2 = -1.0;
+                res->max_gap = 0.0;
+                gap_start = -1.0;
+            }
+            finger = seg[s].finger;
+
+            if (finger)
+            {
+                pulse = Test_Pulse(t + seg[s].phase);
+                raw[count * 2]     = (int32_t)(seg[s].dc_ir * (1.0 - 0.01 * pulse) + 20.0 * Test_Noise());
+                raw[count * 2 + 1] = (int32_t)(seg[s].dc_ir * (0.8 - 0.016 * pulse) + 20.0 * Test_Noise());
+            }
+            else
+            {
+                raw[count * 2]     = (int32_t)(3000.0 + 20.0 * Test_Noise());
+                raw[count * 2 + 1] = (int32_t)(2500.0 + 20.0 * Test_Noise());
+            }
+        }
+
+        max30102_fir_block(raw, filtered, (uint16_t)count);
+        for (i = 0; i < count; i++)
+        {
+            MAX30102_ProcessSample(&raw[i * 2], &filtered[i * 2]);
+
+            t = (double)(n - count + i) / TEST_FS;
+            if (!data->finger_detected || t < finger_on)
+            {
+                continue;
+            }
+            if (res->first_hr < 0.0 && data->heart_rate != 0)
+            {
+                res->first_hr = t - finger_on;
+                res->hr = data->heart_rate;
+            }
+            if (res->first_spo2 < 0.0 && data->spo2 != 0)
+            {
+                res->first_spo2 = t - finger_on;
+                res->spo2 = data->spo2;
+            }
+            if (res->first_hr >= 0.0)
+            {
+                if (data->heart_rate == 0 && gap_start < 0.0)
+                {
+                    gap_start = t;
+                }
+                else if (data->heart_rate != 0 && gap_start >= 0.0)
+                {
+                    res->max_gap = fmax(res->max_gap, t - gap_start);
+                    gap_start = -1.0;
+                }
+            }
+        }
+    }
+    if (gap_start >= 0.0)
+    {
+        res->max_gap = fmax(res->max_gap, t - gap_start);
+    }
+}
+
+/*============================ 主程序 ============================*/
+
+static int test_failed = 0;
+
+static void Test_Check(const char *name, double value, double limit)
+{
+    int ok = value <= limit;
+
+    printf("%-4s %-18s %8.2f  (limit %g)\n", ok ? "ok" : "FAIL", name, value, limit);
+    if (!ok)
+    {
+        test_failed = 1;
+    }
+}
+
+/**
+  * @brief  最后一段的脉搏相位取一个周期内 TEST_PHASES 个值，检查最坏情况
+  */
+static void Test_Startup(const char *name, const Test_Segment_t *seg, unsigned nseg)
+{
+    Test_Segment_t sweep[TEST_SEGMENTS_MAX];
+    Test_Result_t res;
+    double first_hr = 0.0, first_spo2 = 0.0, hr_error = 0.0, spo2_error = 0.0;
+    char label[32];
+    unsigned k;
+
+    for (k = 0; k < nseg; k++)
+    {
+        sweep[k] = seg[k];
+    }
+    for (k = 0; k < TEST_PHASES; k++)
+    {
+        sweep[nseg - 1].phase = seg[nseg - 1].phase + k * 60.0 / TEST_HR_BPM / TEST_PHASES;
+        Test_Run(sweep, nseg, &res);
+
+        /* 没有出值记为超限 */
+        first_hr = fmax(first_hr, (res.first_hr < 0.0) ? 1e9 : res.first_hr);
+        first_spo2 = fmax(first_spo2, (res.first_spo2 < 0.0) ? 1e9 : res.first_spo2);
+        hr_error = fmax(hr_error, fabs(res.hr - TEST_HR_BPM));
+        spo2_error = fmax(spo2_error, fabs(res.spo2 - TEST_SPO2));
+    }
+
+    snprintf(label, sizeof(label), "%s_first_hr", name);
+    Test_Check(label, first_hr, FIRST_HR_LIMIT);
+    snprintf(label, sizeof(label), "%s_first_spo2", name);
+    Test_Check(label, first_spo2, FIRST_SPO2_LIMIT);
+    snprintf(label, sizeof(label), "%s_hr_error", name);
+    Test_Check(label, hr_error, HR_TOLERANCE);
+    snprintf(label, sizeof(label), "%s_spo2_error", name);
+    Test_Check(label, spo2_error, SPO2_TOLERANCE);
+}
+
+int main(void)
+{
+    static const Test_Segment_t cold[] = {
+        { 15.0, 1, 150000.0, 0.0 },
+    };
+    static const Test_Segment_t replace[] = {
+        { 2.0, 0, 0.0, 0.0 },
+        { 15.0, 1, 150000.0, 0.0 },
+    };
+    static const Test_Segment_t again[] = {
+        { 10.0, 1, 150000.0, 0.0 },
+        { 1.0, 0, 0.0, 0.0 },
+        { 15.0, 1, 130000.0, 0.37 },
+    };
+    static const Test_Segment_t jump[] = {
+        { 10.0, 1, 150000.0, 0.0 },
+        { 15.0, 1, 230000.0, 0.0 },
+    };
+    Test_Result_t res;
+
+    Test_Startup("cold", cold, sizeof(cold) / sizeof(cold[0]));
+    Test_Startup("replace", replace, sizeof(replace) / sizeof(replace[0]));
+    Test_Startup("again", again, sizeof(again) / sizeof(again[0]));
+
+    Test_Run(jump, sizeof(jump) / sizeof(jump[0]), &res);
+    Test_Check("jump_hr_gap", res.max_gap, JUMP_GAP_LIMIT);
+
+    return test_failed;
+}
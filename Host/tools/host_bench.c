@@ -0,0 +1,406 @@
+/**
+  ******************************************************************************
+  * @file    host_bench.c
+  * @brief   主机基准程序: 合成信号经完整处理链运行，统计各任务耗时
+  *
+  * @details 用法: host_bench [秒数=600] [页面=0] [记录文件]
+  *
+  *          初始化顺序和任务表与 main.c 相同（LED与串口调试任务除外），
+  *          每推进1ms时间:
+  *          1. 按 ECG_SAMPLE_FREQ 送入ECG采样，按 HOST_PPG_FIFO_SPS 写入MAX30102 FIFO
+  *          2. 推进时间（100Hz节拍、串口发送）
+  *          3. 调度若干次，使到期任务全部运行
+  *          合成信号: 72bpm，PPG的 R = 0.5（血氧约98%），ECG为带P/T波的QRS
+  *          结束后输出心率/血氧/ECG心率、MQTT发布条数、各任务主机耗时和实时倍数。
+  *          给出记录文件时，合成的输入同时按设备的记录格式写入该文件，供 host_replay 重放。
+  *          以 -DENABLE_TRACE_RECORD 构建时同时运行设备上的记录器，经调试串口替身
+  *          发出的记录在此解析计数，用于检查记录器的输出速度和丢弃
+  ******************************************************************************
+  */
+
+#include "max30102.h"
+#include "max30102_fir.h"
+#include "ad8232.h"
+#include "ecg_qrs.h"
+#include "AD.h"
+#include "oled.h"
+#include "key.h"
+#include "usart2.h"
+#include "esp8266.h"
+#include "Timer2.h"
+#include "module/display/display.h"
+#include "module/transmit/transmit.h"
+#include "module/scheduler/scheduler.h"
+#include "module/trace/trace.h"
+#ifdef ENABLE_IRQ_STAT
+#include "module/irqstat/irqstat.h"
+#endif
+#include "host_hal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*============================ 宏定义 ============================*/
+
+#define BENCH_STEP_TICKS    (TIM3_COUNTER_FREQ / 1000)  /**< 每步推进1ms */
+#define BENCH_RUNS_PER_STEP 8                           /**< 每步调度次数，大于每毫秒最多到期的任务数 */
+#define BENCH_HR_BPM        72.0
+#define BENCH_PI            3.14159265358979
+
+/*============================ 任务计时 ============================*/
+
+typedef struct
+{
+    const char *name;
+    uint64_t ns;            /**< 主机耗时累计 */
+    uint32_t calls;
+} Bench_Stat_t;
+
+enum { BENCH_ECGUP, BENCH_PPG, BENCH_KEY, BENCH_DISP, BENCH_MQTT, BENCH_ESP, BENCH_ISR, BENCH_COUNT };
+
+static Bench_Stat_t bench_stats[BENCH_COUNT] = {
+    { .name = "ecgup" }, { .name = "ppg" }, { .name = "key" }, { .name = "disp" },
+    { .name = "mqtt" }, { .name = "esp" }, { .name = "isr" },
+};
+
+static uint64_t Bench_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/** 包装任务函数，累计主机耗时 */
+#define BENCH_WRAP(id, func)                        \
+    static void Bench_##func(void)                  \
+    {                                               \
+        uint64_t t0 = Bench_Now();                  \
+        func();                                     \
+        bench_stats[id].ns += Bench_Now() - t0;     \
+        bench_stats[id].calls++;                    \
+    }
+
+BENCH_WRAP(BENCH_ECGUP, Transmit_ECGUploadProcess)
+BENCH_WRAP(BENCH_PPG,   MAX30102_Process)
+BENCH_WRAP(BENCH_KEY,   Key_Process)
+BENCH_WRAP(BENCH_DISP,  Display_Update)
+BENCH_WRAP(BENCH_MQTT,  Transmit_Process)
+BENCH_WRAP(BENCH_ESP,   ESP8266_Process)
+
+/* 与 main.c 相同的任务表 */
+static Sched_Task_t tasks[] = {
+    SCHED_TASK("ecgup", Bench_Transmit_ECGUploadProcess, SCHED_MS(10),                        SCHED_MS(10),                     0),
+    SCHED_TASK("ppg",   Bench_MAX30102_Process,          SCHED_MS(10),                        SCHED_MS(20),                     1),
+    SCHED_TASK("key",   Bench_Key_Process,               SCHED_MS(20),                        SCHED_MS(50),                     2),
+    SCHED_TASK("disp",  Bench_Display_Update,            SCHED_MS(1000 / DISPLAY_TASK_FREQ),  SCHED_MS(1000 / ECG_RENDER_FPS),  3),
+    SCHED_TASK("mqtt",  Bench_Transmit_Process,          SCHED_MS(100),                       SCHED_MS(100),                    4),
+#ifdef ENABLE_TRACE_RECORD
+    SCHED_TASK("trace", Trace_Process,                   SCHED_MS(10),                        SCHED_MS(50),                     7),
+#endif
+    SCHED_TASK("esp",   Bench_ESP8266_Process,           0,                                   SCHED_MS(5),                      9),
+};
+
+/*============================ 合成信号 ============================*/
+
+static uint32_t bench_rand_state = 1;
+
+/** 均匀噪声 [-1, 1) */
+static double Bench_Noise(void)
+{
+    bench_rand_state = bench_rand_state * 1664525u + 1013904223u;
+    return (double)(bench_rand_state >> 8) / 8388608.0 - 1.0;
+}
+
+/** 高斯脉冲 */
+static double Bench_Gauss(double t, double center, double width)
+{
+    double x = (t - center) / width;
+
+    return exp(-0.5 * x * x);
+}
+
+/** 心动周期内的相位 (s) */
+static double Bench_Phase(double t)
+{
+    double period = 60.0 / BENCH_HR_BPM;
+
+    return fmod(t, period);
+}
+
+/** PPG脉搏波形，收缩峰加重搏波，峰值约1 */
+static double Bench_PulseShape(double t)
+{
+    double p = Bench_Phase(t);
+
+    return Bench_Gauss(p, 0.15, 0.06) + 0.35 * Bench_Gauss(p, 0.42, 0.08);
+}
+
+/** ECG波形 (ADC值) */
+static uint16_t Bench_ECGSample(double t)
+{
+    double p = Bench_Phase(t);
+    double v = 2048.0
+             + 60.0 * Bench_Gauss(p, 0.10, 0.020)      /* P */
+             - 80.0 * Bench_Gauss(p, 0.19, 0.006)      /* Q */
+             + 900.0 * Bench_Gauss(p, 0.20, 0.008)     /* R */
+             - 150.0 * Bench_Gauss(p, 0.215, 0.008)    /* S */
+             + 150.0 * Bench_Gauss(p, 0.45, 0.040)     /* T */
+             + 8.0 * Bench_Noise();
+
+    return (uint16_t)v;
+}
+
+/*============================ 输入记录 ============================*/
+
+#define BENCH_TRACE_PPG_BATCH   8       /**< 每条PPG记录的点数，与FIFO将满时一次读出的点数相近 */
+
+/** 每条ECG记录的点数: 一个DMA半缓冲，超过一条记录的长度时分为多条 */
+#if AD_DMA_HALF_LEN > TRACE_ECG_COUNT_MAX
+#define BENCH_TRACE_ECG_BATCH   TRACE_ECG_COUNT_MAX
+#else
+#define BENCH_TRACE_ECG_BATCH   AD_DMA_HALF_LEN
+#endif
+
+static FILE *bench_trace = NULL;
+static uint8_t bench_trace_ppg[BENCH_TRACE_PPG_BATCH * TRACE_PPG_SAMPLE_BYTES];
+static uint8_t bench_trace_ppg_count = 0;
+static uint8_t bench_trace_ecg[1 + BENCH_TRACE_ECG_BATCH * 2];
+static uint16_t bench_trace_ecg_count = 0;
+static uint16_t bench_trace_ecg_block = 0;  /**< 当前DMA半缓冲中的点数 */
+static uint32_t bench_trace_info_tick = 0;
+static uint8_t bench_trace_info_sent = 0;
+
+/** 写入一条记录 */
+static void Bench_TraceWrite(uint8_t type, uint32_t tick, const uint8_t *payload, uint8_t len)
+{
+    uint8_t rec[TRACE_PAYLOAD_MAX + TRACE_OVERHEAD];
+
+    fwrite(rec, 1, Trace_Encode(rec, type, tick, payload, len), bench_trace);
+}
+
+/** 每秒一条INFO记录，与设备相同 */
+static void Bench_TraceInfo(uint32_t tick)
+{
+    Trace_Info_t info = { TRACE_VERSION, 0, ECG_SAMPLE_FREQ, HOST_PPG_FIFO_SPS, current_page };
+    uint8_t payload[TRACE_INFO_LEN];
+
+#ifdef MAX30102_HIGH_RATE
+    info.flags = TRACE_FLAG_PPG_HIGH_RATE;
+#endif
+    if (bench_trace_info_sent && tick - bench_trace_info_tick < TIM3_COUNTER_FREQ)
+    {
+        return;
+    }
+    bench_trace_info_tick = tick;
+    bench_trace_info_sent = 1;
+    Trace_PackInfo(payload, &info);
+    Bench_TraceWrite(TRACE_REC_INFO, tick, payload, TRACE_INFO_LEN);
+}
+
+/** 记录一个PPG采样点，凑满一批写入，时间戳为最后一点的时刻 */
+static void Bench_TracePPG(uint32_t tick, int32_t ir, int32_t red)
+{
+    uint8_t *p = &bench_trace_ppg[bench_trace_ppg_count * TRACE_PPG_SAMPLE_BYTES];
+
+    if (bench_trace == NULL)
+    {
+        return;
+    }
+    p[0] = (uint8_t)(ir >> 16) & 0x03;
+    p[1] = (uint8_t)(ir >> 8);
+    p[2] = (uint8_t)ir;
+    p[3] = (uint8_t)(red >> 16) & 0x03;
+    p[4] = (uint8_t)(red >> 8);
+    p[5] = (uint8_t)red;
+    if (++bench_trace_ppg_count >= BENCH_TRACE_PPG_BATCH)
+    {
+        Bench_TraceInfo(tick);
+        Bench_TraceWrite(TRACE_REC_PPG, tick, bench_trace_ppg, sizeof(bench_trace_ppg));
+        bench_trace_ppg_count = 0;
+    }
+}
+
+/** 记录一个ECG采样点，凑满DMA半缓冲或一条记录的长度时写入 */
+static void Bench_TraceECG(uint32_t tick, uint16_t sample)
+{
+    if (bench_trace == NULL)
+    {
+        return;
+    }
+    bench_trace_ecg[0] = 1;     /* 电极连接 */
+    bench_trace_ecg[1 + bench_trace_ecg_count * 2] = (uint8_t)sample;
+    bench_trace_ecg[2 + bench_trace_ecg_count * 2] = (uint8_t)(sample >> 8);
+    bench_trace_ecg_count++;
+    if (++bench_trace_ecg_block >= AD_DMA_HALF_LEN || bench_trace_ecg_count >= BENCH_TRACE_ECG_BATCH)
+    {
+        Bench_TraceInfo(tick);
+        Bench_TraceWrite(TRACE_REC_ECG, tick, bench_trace_ecg, (uint8_t)(1 + bench_trace_ecg_count * 2));
+        bench_trace_ecg_count = 0;
+        if (bench_trace_ecg_block >= AD_DMA_HALF_LEN)
+        {
+            bench_trace_ecg_block = 0;
+        }
+    }
+}
+
+/*============================ 记录器输出统计 ============================*/
+
+#ifdef ENABLE_TRACE_RECORD
+static Trace_Parser_t bench_rec_parser;
+static uint32_t bench_rec_count[TRACE_REC_LOST + 1];    /**< 各类型记录数 */
+static uint32_t bench_rec_lost = 0;                     /**< LOST记录报告的丢弃记录数 */
+
+static void Bench_DebugSink(const uint8_t *data, uint16_t len)
+{
+    const Trace_Record_t *rec = &bench_rec_parser.rec;
+
+    while (len--)
+    {
+        if (!Trace_ParserFeed(&bench_rec_parser, *data++))
+        {
+            continue;
+        }
+        bench_rec_count[(rec->type <= TRACE_REC_LOST) ? rec->type : 0]++;
+        if (rec->type == TRACE_REC_LOST && rec->len >= TRACE_LOST_LEN)
+        {
+            bench_rec_lost += (uint32_t)(rec->payload[1] | rec->payload[2] << 8);
+        }
+    }
+}
+#endif
+
+/*============================ 串口输出统计 ============================*/
+
+static uint32_t bench_pub_lines = 0;    /**< 发布条数 */
+static uint32_t bench_alarm_lines = 0;  /**< 其中的报警条数 */
+
+static void Bench_UartSink(const char *line)
+{
+    if (strncmp(line, "AT+MQTTPUB", 10) == 0)
+    {
+        bench_pub_lines++;
+        if (strstr(line, "alarm") != NULL)
+        {
+            bench_alarm_lines++;
+        }
+    }
+}
+
+/*============================ 主函数 ============================*/
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 600;
+    uint8_t page = (argc > 2) ? (uint8_t)strtoul(argv[2], NULL, 0) : PAGE_HEARTRATE;
+    uint32_t steps = seconds * 1000;
+    uint32_t next_ecg = 0, next_ppg = 0;
+    uint32_t step, i;
+    uint64_t wall_start, wall_ns, isr_t0;
+    double t, pulse;
+    uint16_t ecg;
+    int32_t ir, red;
+    const MAX30102_Data_t *ppg;
+
+    /* 与 main.c 相同的初始化顺序 */
+#ifdef ENABLE_TRACE_RECORD
+    Trace_ParserInit(&bench_rec_parser);
+    Host_DebugUsart_SetSink(Bench_DebugSink);
+    Trace_Init();
+#endif
+#ifdef ENABLE_IRQ_STAT
+    IrqStat_Init();
+#endif
+    max30102_init();
+    max30102_fir_init();
+    OLED_Init();
+    usart2_init(115200);
+    ESP8266_Init();
+    Transmit_Init();
+    AD8232Init();
+    AD_Init();
+    Key_Init();
+    Timer3_Init();
+
+    Host_UART_SetModem(1);
+    Host_UART_SetSink(Bench_UartSink);
+    current_page = (page < PAGE_MAX) ? page : PAGE_HEARTRATE;
+
+    Sched_Init(tasks, sizeof(tasks) / sizeof(tasks[0]));
+
+    if (argc > 3 && (bench_trace = fopen(argv[3], "wb")) == NULL)
+    {
+        perror(argv[3]);
+        return 1;
+    }
+
+    wall_start = Bench_Now();
+    for (step = 0; step < steps; step++)
+    {
+        /* 中断侧: 采样到达 */
+        isr_t0 = Bench_Now();
+        while (next_ecg < BENCH_STEP_TICKS)
+        {
+            t = (step * BENCH_STEP_TICKS + next_ecg) / (double)TIM3_COUNTER_FREQ;
+            ecg = Bench_ECGSample(t);
+            Bench_TraceECG(step * BENCH_STEP_TICKS + next_ecg, ecg);
+            Host_ADC_Push(ecg);
+            next_ecg += TIM3_COUNTER_FREQ / ECG_SAMPLE_FREQ;
+        }
+        while (next_ppg < BENCH_STEP_TICKS)
+        {
+            t = (step * BENCH_STEP_TICKS + next_ppg) / (double)TIM3_COUNTER_FREQ;
+            pulse = Bench_PulseShape(t);
+            ir = (int32_t)(150000.0 - 1500.0 * pulse + 20.0 * Bench_Noise());
+            red = (int32_t)(120000.0 - 2400.0 * pulse + 20.0 * Bench_Noise());
+            Bench_TracePPG(step * BENCH_STEP_TICKS + next_ppg, ir, red);
+            Host_MAX30102_Push(ir, red);
+            next_ppg += TIM3_COUNTER_FREQ / HOST_PPG_FIFO_SPS;
+        }
+        next_ecg -= BENCH_STEP_TICKS;
+        next_ppg -= BENCH_STEP_TICKS;
+
+        Host_Timer_Advance(BENCH_STEP_TICKS);
+        bench_stats[BENCH_ISR].ns += Bench_Now() - isr_t0;
+        bench_stats[BENCH_ISR].calls++;
+
+        /* 主循环侧 */
+        for (i = 0; i < BENCH_RUNS_PER_STEP; i++)
+        {
+            Sched_Run();
+        }
+    }
+    wall_ns = Bench_Now() - wall_start;
+    if (bench_trace != NULL)
+    {
+        fclose(bench_trace);
+    }
+
+    ppg = MAX30102_GetData();
+    printf("simulated   %lu s, page %u\n", (unsigned long)seconds, current_page);
+    printf("ppg         finger %u  hr %u bpm  spo2 %u %%  fifo overflow %lu\n",
+           ppg->finger_detected, ppg->heart_rate, ppg->spo2, (unsigned long)max30102_fifo_overflow);
+    printf("ecg         hr %u bpm\n", ECG_QRS_GetHeartRate());
+    printf("mqtt        link %d  publish %lu  alarm %lu  tx drop %lu\n",
+           (int)ESP8266_GetLink(), (unsigned long)bench_pub_lines,
+           (unsigned long)bench_alarm_lines, (unsigned long)USART2_TxDropCount);
+#ifdef ENABLE_TRACE_RECORD
+    printf("trace       info %lu  ppg %lu  ecg %lu  lost %lu  crc error %lu\n",
+           (unsigned long)bench_rec_count[TRACE_REC_INFO], (unsigned long)bench_rec_count[TRACE_REC_PPG],
+           (unsigned long)bench_rec_count[TRACE_REC_ECG], (unsigned long)bench_rec_lost,
+           (unsigned long)bench_rec_parser.crc_errors);
+#endif
+    printf("\ntask       calls    total ms   avg us\n");
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        printf("%-6s %9lu %11.1f %8.2f\n", bench_stats[i].name, (unsigned long)bench_stats[i].calls,
+               bench_stats[i].ns / 1e6,
+               bench_stats[i].calls ? bench_stats[i].ns / 1e3 / bench_stats[i].calls : 0.0);
+    }
+    printf("\nwall        %.3f s  (%.0fx real time)\n", wall_ns / 1e9, seconds / (wall_ns / 1e9));
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+/**
+  ******************************************************************************
+  * @file    host_replay.c
+  * @brief   主机重放程序: 记录文件经完整处理链运行，输出心率/血氧/报警
+  *
+  * @details 用法: host_replay <记录文件> [页面]
+  *
+  *          记录文件为 ENABLE_TRACE_RECORD 时USART1发出的字节流（或 host_bench 的第3个参数），
+  *          格式见 module/trace/trace.h。
+  *          不给页面时按记录中的页面切换（与录制时相同的处理链）；
+  *          记录没有页面信息（版本1）时固定为心电图页面，ECG的滤波、QRS检测和绘图全部运行。
+  *          1. 读入全部记录，按每个采样点的时间戳展开为PPG和ECG两个序列（见 replay_input.h）
+  *          2. 与 host_bench 相同的初始化和任务表，每推进1ms时间:
+  *             送入到期的采样点（ECG同时设置电极脱落引脚）、推进时间、调度若干次
+  *          3. 页面切换、心率/血氧/ECG心率变化时输出一行，MQTT发布的每一行也带时间输出
+  *          结束后输出首次得到有效结果的时间、吞吐量和实时倍数，
+  *          同一文件重放可比较算法修改前后的输出和处理速度
+  ******************************************************************************
+  */
+
+#include "max30102.h"
+#include "max30102_fir.h"
+#include "ad8232.h"
+#include "ecg_qrs.h"
+#include "AD.h"
+#include "oled.h"
+#include "key.h"
+#include "usart2.h"
+#include "esp8266.h"
+#include "Timer2.h"
+#include "module/display/display.h"
+#include "module/transmit/transmit.h"
+#include "module/scheduler/scheduler.h"
+#include "module/trace/trace.h"
+#ifdef ENABLE_IRQ_STAT
+#include "module/irqstat/irqstat.h"
+#endif
+#include "host_hal.h"
+#include "replay_input.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*============================ 宏定义 ============================*/
+
+#define REPLAY_STEP_TICKS       (TIM3_COUNTER_FREQ / 1000)  /**< 每步推进1ms */
+#define REPLAY_RUNS_PER_STEP    8                           /**< 每步调度次数，与 host_bench 相同 */
+
+/*============================ 私有变量 ============================*/
+
+/* 与 main.c 相同的任务表（LED与串口调试任务除外） */
+static Sched_Task_t tasks[] = {
+    SCHED_TASK("ecgup", Transmit_ECGUploadProcess, SCHED_MS(10),                        SCHED_MS(10),                     0),
+    SCHED_TASK("ppg",   MAX30102_Process,          SCHED_MS(10),                        SCHED_MS(20),                     1),
+    SCHED_TASK("key",   Key_Process,               SCHED_MS(20),                        SCHED_MS(50),                     2),
+    SCHED_TASK("disp",  Display_Update,            SCHED_MS(1000 / DISPLAY_TASK_FREQ),  SCHED_MS(1000 / ECG_RENDER_FPS),  3),
+    SCHED_TASK("mqtt",  Transmit_Process,          SCHED_MS(100),                       SCHED_MS(100),                    4),
+#ifdef ENABLE_TRACE_RECORD
+    SCHED_TASK("trace", Trace_Process,             SCHED_MS(10),                        SCHED_MS(50),                     7),
+#endif
+    SCHED_TASK("esp",   ESP8266_Process,           0,                                   SCHED_MS(5),                      9),
+};
+
+static uint64_t replay_now = 0;         /**< 当前重放时间 (10us) */
+static uint32_t replay_pub_lines = 0;
+static uint32_t replay_alarm_lines = 0;
+
+/*============================ 私有函数 ============================*/
+
+static uint64_t Replay_WallNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static double Replay_Seconds(uint64_t ticks)
+{
+    return ticks / (double)TIM3_COUNTER_FREQ;
+}
+
+static void Replay_UartSink(const char *line)
+{
+    if (strncmp(line, "AT+MQTTPUB", 10) == 0)
+    {
+        replay_pub_lines++;
+        if (strstr(line, "alarm") != NULL)
+        {
+            replay_alarm_lines++;
+        }
+        printf("%10.3f  mqtt  %s\n", Replay_Seconds(replay_now), line);
+    }
+}
+
+/*============================ 主函数 ============================*/
+
+int main(int argc, char **argv)
+{
+    Replay_Stats_t stats;
+    uint64_t wall_start, wall_ns;
+    uint64_t first_hr = 0, first_spo2 = 0, first_ecg_hr = 0;
+    uint8_t last_hr = 0, last_spo2 = 0, last_ecg_hr = 0, last_finger = 0;
+    uint8_t last_page;
+    uint32_t i;
+    const MAX30102_Data_t *ppg;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file> [page]\n", argv[0]);
+        return 2;
+    }
+    if (Replay_Load(argv[1], &stats) != 0)
+    {
+        return 1;
+    }
+
+    /* 与 main.c 相同的初始化顺序 */
+#ifdef ENABLE_TRACE_RECORD
+    Trace_Init();
+#endif
+#ifdef ENABLE_IRQ_STAT
+    IrqStat_Init();
+#endif
+    max30102_init();
+    max30102_fir_init();
+    OLED_Init();
+    usart2_init(115200);
+    ESP8266_Init();
+    Transmit_Init();
+    AD8232Init();
+    AD_Init();
+    Key_Init();
+    Timer3_Init();
+
+    Host_UART_SetModem(1);
+    Host_UART_SetSink(Replay_UartSink);
+    if (argc > 2)
+    {
+        Replay_FixPage((uint8_t)strtoul(argv[2], NULL, 0) % PAGE_MAX);
+    }
+    else if (stats.page == TRACE_PAGE_UNKNOWN)
+    {
+        Replay_FixPage(PAGE_ECG);
+    }
+    else
+    {
+        current_page = stats.page;
+    }
+
+    Sched_Init(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    last_page = current_page;
+
+    printf("      time  event\n");
+    wall_start = Replay_WallNow();
+    for (replay_now = 0; replay_now <= stats.end; replay_now += REPLAY_STEP_TICKS)
+    {
+        Replay_Feed(replay_now + REPLAY_STEP_TICKS);
+        Host_Timer_Advance(REPLAY_STEP_TICKS);
+        for (i = 0; i < REPLAY_RUNS_PER_STEP; i++)
+        {
+            Sched_Run();
+        }
+
+        ppg = MAX30102_GetData();
+        if (current_page != last_page)
+        {
+            last_page = current_page;
+            printf("%10.3f  page   %u\n", Replay_Seconds(replay_now), last_page);
+        }
+        if (ppg->finger_detected != last_finger)
+        {
+            last_finger = ppg->finger_detected;
+            printf("%10.3f  finger %u\n", Replay_Seconds(replay_now), last_finger);
+        }
+        if (ppg->heart_rate != last_hr)
+        {
+            last_hr = ppg->heart_rate;
+            printf("%10.3f  hr     %u\n", Replay_Seconds(replay_now), last_hr);
+            if (first_hr == 0 && last_hr != 0)
+            {
+                first_hr = replay_now;
+            }
+        }
+        if (ppg->spo2 != last_spo2)
+        {
+            last_spo2 = ppg->spo2;
+            printf("%10.3f  spo2   %u\n", Replay_Seconds(replay_now), last_spo2);
+            if (first_spo2 == 0 && last_spo2 != 0)
+            {
+                first_spo2 = replay_now;
+            }
+        }
+        if (ECG_QRS_GetHeartRate() != last_ecg_hr)
+        {
+            last_ecg_hr = ECG_QRS_GetHeartRate();
+            printf("%10.3f  ecghr  %u\n", Replay_Seconds(replay_now), last_ecg_hr);
+            if (first_ecg_hr == 0 && last_ecg_hr != 0)
+            {
+                first_ecg_hr = replay_now;
+            }
+        }
+    }
+    wall_ns = Replay_WallNow() - wall_start;
+
+    printf("\ntrace       %.3f s  info %lu  ppg %lu  ecg %lu  lost %lu records  crc error %lu  skipped %lu B\n",
+           Replay_Seconds(stats.end), (unsigned long)stats.records[TRACE_REC_INFO],
+           (unsigned long)stats.records[TRACE_REC_PPG], (unsigned long)stats.records[TRACE_REC_ECG],
+           (unsigned long)stats.lost, (unsigned long)stats.crc_errors, (unsigned long)stats.skipped);
+    printf("samples     ppg %lu  ecg %lu\n", (unsigned long)stats.ppg_samples, (unsigned long)stats.ecg_samples);
+    if (argc > 2 || stats.page == TRACE_PAGE_UNKNOWN)
+    {
+        printf("page        %u (fixed)\n", current_page);
+    }
+    else
+    {
+        printf("page        %u at start, %lu changes (from trace)\n", stats.page, (unsigned long)stats.page_changes);
+    }
+    printf("first valid hr %.2f s  spo2 %.2f s  ecg hr %.2f s  (0: none)\n",
+           Replay_Seconds(first_hr), Replay_Seconds(first_spo2), Replay_Seconds(first_ecg_hr));
+    printf("final       hr %u  spo2 %u  ecg hr %u  fifo overflow %lu\n",
+           last_hr, last_spo2, last_ecg_hr, (unsigned long)max30102_fifo_overflow);
+    printf("mqtt        publish %lu  alarm %lu\n",
+           (unsigned long)replay_pub_lines, (unsigned long)replay_alarm_lines);
+    printf("wall        %.3f s  (%.0fx real time, %.0f samples/s)\n", wall_ns / 1e9,
+           Replay_Seconds(stats.end) / (wall_ns / 1e9),
+           (stats.ppg_samples + stats.ecg_samples) / (wall_ns / 1e9));
+
+    Replay_Free();
+    return 0;
+}
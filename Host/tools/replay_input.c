@@ -0,0 +1,292 @@
+/**
+  ******************************************************************************
+  * @file    replay_input.c
+  * @brief   记录文件输入: 读入采样记录，按时间送入硬件替身
+  ******************************************************************************
+  */
+
+#include "replay_input.h"
+#include "ad8232.h"
+#include "key.h"
+#include "Timer2.h"
+#include "host_hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*============================ 类型定义 ============================*/
+
+/** 一个采样点，time为相对记录开始的时间 (10us) */
+typedef struct
+{
+    uint64_t time;
+    int32_t  value[2];      /**< PPG: IR/RED; ECG: ADC值/电极状态; 页面: 页面/- */
+} Replay_Sample_t;
+
+typedef struct
+{
+    Replay_Sample_t *buf;
+    size_t count;
+    size_t cap;
+    size_t next;            /**< 下一个待送入的点 */
+} Replay_Seq_t;
+
+/*============================ 私有变量 ============================*/
+
+static Replay_Seq_t replay_ppg;
+static Replay_Seq_t replay_ecg;
+static Replay_Seq_t replay_page;        /**< 页面切换，time为INFO记录时刻 */
+static uint8_t replay_page_fixed = 0;   /**< 1: 不按记录切换页面 */
+
+/*============================ 私有函数 ============================*/
+
+static void Replay_Append(Replay_Seq_t *seq, uint64_t time, int32_t v0, int32_t v1)
+{
+    if (seq->count == seq->cap)
+    {
+        seq->cap = seq->cap ? seq->cap * 2 : 4096;
+        seq->buf = realloc(seq->buf, seq->cap * sizeof(Replay_Sample_t));
+        if (seq->buf == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    seq->buf[seq->count].time = time;
+    seq->buf[seq->count].value[0] = v0;
+    seq->buf[seq->count].value[1] = v1;
+    seq->count++;
+}
+
+/** 按时间排序 */
+static int Replay_Compare(const void *a, const void *b)
+{
+    const Replay_Sample_t *x = a, *y = b;
+
+    return (x->time > y->time) - (x->time < y->time);
+}
+
+/** 同一来源的记录时间戳递增，排序只防止拼接的文件等异常情况下乱序送入 */
+static void Replay_Sort(Replay_Seq_t *seq)
+{
+    if (seq->count > 0)
+    {
+        qsort(seq->buf, seq->count, sizeof(Replay_Sample_t), Replay_Compare);
+    }
+}
+
+/** 早于时间0的点（第一个采样点之前的INFO记录）记为时间0 */
+static void Replay_Shift(Replay_Seq_t *seq, uint64_t offset)
+{
+    size_t i;
+
+    for (i = 0; i < seq->count; i++)
+    {
+        seq->buf[i].time = (seq->buf[i].time > offset) ? seq->buf[i].time - offset : 0;
+    }
+}
+
+/*============================ 公共函数 ============================*/
+
+/**
+  * @brief  读入记录文件，展开为采样序列，最早的采样点作为时间0
+  */
+int Replay_Load(const char *path, Replay_Stats_t *stats)
+{
+    FILE *f = fopen(path, "rb");
+    Trace_Parser_t parser;
+    Trace_Info_t info;
+    uint32_t ecg_period = TIM3_COUNTER_FREQ / ECG_SAMPLE_FREQ;
+    uint32_t ppg_period = TIM3_COUNTER_FREQ / HOST_PPG_FIFO_SPS;
+    uint32_t last_tick = 0;
+    uint64_t base = (uint64_t)1 << 40, t;   /* 留出首条记录中早于其时间戳的点 */
+    uint64_t offset = 0;
+    uint8_t started = 0;
+    uint8_t page = TRACE_PAGE_UNKNOWN;
+    int32_t ppg[2];
+    int ch;
+    uint8_t i, n;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->page = TRACE_PAGE_UNKNOWN;
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    Trace_ParserInit(&parser);
+    while ((ch = fgetc(f)) != EOF)
+    {
+        if (!Trace_ParserFeed(&parser, (uint8_t)ch))
+        {
+            continue;
+        }
+        stats->records[parser.rec.type <= TRACE_REC_LOST ? parser.rec.type : 0]++;    /* [0]: 未知类型 */
+
+        /* 32位时间戳展开为自记录开始的64位时间（设备侧约11.9小时回绕） */
+        if (!started)
+        {
+            started = 1;
+            last_tick = parser.rec.tick;
+        }
+        base += (uint64_t)(int64_t)(int32_t)(parser.rec.tick - last_tick);
+        last_tick = parser.rec.tick;
+
+        switch (parser.rec.type)
+        {
+        case TRACE_REC_INFO:
+            if (parser.rec.len < TRACE_INFO_LEN_V1)
+            {
+                break;
+            }
+            Trace_GetInfo(&parser.rec, &info);
+            if (info.page < PAGE_MAX && info.page != page)
+            {
+                if (page == TRACE_PAGE_UNKNOWN)
+                {
+                    stats->page = info.page;
+                }
+                else
+                {
+                    stats->page_changes++;
+                }
+                page = info.page;
+                Replay_Append(&replay_page, base, info.page, 0);
+            }
+            if (info.ecg_rate != ECG_SAMPLE_FREQ || info.ppg_rate != HOST_PPG_FIFO_SPS)
+            {
+                fprintf(stderr, "warning: trace recorded at ecg %u / ppg %u sps, build expects %u / %u\n",
+                        info.ecg_rate, info.ppg_rate, ECG_SAMPLE_FREQ, HOST_PPG_FIFO_SPS);
+            }
+            if (info.ecg_rate != 0)
+            {
+                ecg_period = TIM3_COUNTER_FREQ / info.ecg_rate;
+            }
+            if (info.ppg_rate != 0)
+            {
+                ppg_period = TIM3_COUNTER_FREQ / info.ppg_rate;
+            }
+            break;
+
+        case TRACE_REC_PPG:
+            n = (uint8_t)TRACE_PPG_COUNT(&parser.rec);
+            for (i = 0; i < n; i++)
+            {
+                /* 最后一点在记录时刻，之前各点等间隔 */
+                t = base - (uint64_t)ppg_period * (n - 1 - i);
+                Trace_GetPPG(&parser.rec, i, ppg);
+                Replay_Append(&replay_ppg, t, ppg[0], ppg[1]);
+            }
+            break;
+
+        case TRACE_REC_ECG:
+            if (parser.rec.len == 0)
+            {
+                break;
+            }
+            n = (uint8_t)TRACE_ECG_COUNT(&parser.rec);
+            for (i = 0; i < n; i++)
+            {
+                t = base - (uint64_t)ecg_period * (n - 1 - i);
+                Replay_Append(&replay_ecg, t, Trace_GetECG(&parser.rec, i), parser.rec.payload[0]);
+            }
+            break;
+
+        case TRACE_REC_LOST:
+            if (parser.rec.len < TRACE_LOST_LEN)
+            {
+                break;
+            }
+            stats->lost += (uint32_t)(parser.rec.payload[1] | parser.rec.payload[2] << 8);
+            break;
+
+        default:
+            break;
+        }
+    }
+    fclose(f);
+
+    Replay_Sort(&replay_ppg);
+    Replay_Sort(&replay_ecg);
+    Replay_Sort(&replay_page);
+
+    /* 最早的采样点作为时间0 */
+    if (replay_ppg.count > 0)
+    {
+        offset = replay_ppg.buf[0].time;
+    }
+    if (replay_ecg.count > 0 && (replay_ppg.count == 0 || replay_ecg.buf[0].time < offset))
+    {
+        offset = replay_ecg.buf[0].time;
+    }
+    Replay_Shift(&replay_ppg, offset);
+    Replay_Shift(&replay_ecg, offset);
+    Replay_Shift(&replay_page, offset);
+
+    if (replay_ppg.count > 0)
+    {
+        stats->end = replay_ppg.buf[replay_ppg.count - 1].time;
+    }
+    if (replay_ecg.count > 0 && replay_ecg.buf[replay_ecg.count - 1].time > stats->end)
+    {
+        stats->end = replay_ecg.buf[replay_ecg.count - 1].time;
+    }
+    stats->crc_errors = parser.crc_errors;
+    stats->skipped = parser.skipped;
+    stats->ppg_samples = (uint32_t)replay_ppg.count;
+    stats->ecg_samples = (uint32_t)replay_ecg.count;
+    return 0;
+}
+
+/**
+  * @brief  送入时间早于 end 的采样点
+  */
+void Replay_Feed(uint64_t end)
+{
+    Replay_Sample_t *s;
+
+    while (replay_ecg.next < replay_ecg.count && replay_ecg.buf[replay_ecg.next].time < end)
+    {
+        s = &replay_ecg.buf[replay_ecg.next++];
+        Host_GPIO_SetInput(GPIOB, GPIO_Pin_0 | GPIO_Pin_1, s->value[1] ? 0 : 1);
+        Host_ADC_Push((uint16_t)s->value[0]);
+    }
+    while (replay_ppg.next < replay_ppg.count && replay_ppg.buf[replay_ppg.next].time < end)
+    {
+        s = &replay_ppg.buf[replay_ppg.next++];
+        Host_MAX30102_Push(s->value[0], s->value[1]);
+    }
+    while (replay_page.next < replay_page.count && replay_page.buf[replay_page.next].time < end)
+    {
+        s = &replay_page.buf[replay_page.next++];
+        if (!replay_page_fixed)
+        {
+            current_page = (uint8_t)s->value[0];
+        }
+    }
+}
+
+/**
+  * @brief  固定页面，忽略记录中的页面
+  */
+void Replay_FixPage(uint8_t page)
+{
+    replay_page_fixed = 1;
+    current_page = page;
+}
+
+/**
+  * @brief  释放读入的序列
+  */
+void Replay_Free(void)
+{
+    free(replay_ppg.buf);
+    free(replay_ecg.buf);
+    free(replay_page.buf);
+    memset(&replay_ppg, 0, sizeof(replay_ppg));
+    memset(&replay_ecg, 0, sizeof(replay_ecg));
+    memset(&replay_page, 0, sizeof(replay_page));
+    replay_page_fixed = 0;
+}
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    replay_input.h
+  * @brief   记录文件输入: 读入采样记录，按时间送入硬件替身
+  *
+  * @details 记录格式见 module/trace/trace.h。读入时把每条记录展开为逐点的PPG和ECG序列，
+  *          最早的采样点为时间0；重放时每推进一段时间调用 Replay_Feed，
+  *          到期的点经 Host_ADC_Push / Host_MAX30102_Push 送入，ECG同时设置电极脱落引脚；
+  *          INFO记录中的页面按时间写入 current_page，与按键切换页面相同。
+  *          主机重放程序 host_replay 使用
+  ******************************************************************************
+  */
+
+#ifndef __REPLAY_INPUT_H
+#define __REPLAY_INPUT_H
+
+#include <stdint.h>
+#include "module/trace/trace.h"
+
+/**
+  * @brief  读入统计
+  */
+typedef struct
+{
+    uint32_t records[TRACE_REC_LOST + 1];   /**< 各类型记录数，[0]为未知类型 */
+    uint32_t lost;                          /**< LOST记录报告的丢弃记录数 */
+    uint32_t crc_errors;                    /**< CRC错误丢弃的记录数 */
+    uint32_t skipped;                       /**< 对齐时跳过的字节数 */
+    uint32_t ppg_samples;
+    uint32_t ecg_samples;
+    uint64_t end;                           /**< 最后一个采样点的时间 (10us) */
+    uint8_t  page;                          /**< 记录开始时的页面，没有页面信息时为 TRACE_PAGE_UNKNOWN */
+    uint32_t page_changes;                  /**< 记录中的页面切换次数 */
+} Replay_Stats_t;
+
+/**
+  * @brief  读入记录文件
+  * @param  path: 文件路径
+  * @param  stats: 输出统计
+  * @retval 0: 成功, -1: 无法打开
+  */
+int Replay_Load(const char *path, Replay_Stats_t *stats);
+
+/**
+  * @brief  送入时间早于 end 的采样点
+  * @param  end: 重放时间 (10us)
+  */
+void Replay_Feed(uint64_t end);
+
+/**
+  * @brief  固定页面，忽略记录中的页面
+  * @param  page: 页面 (PAGE_xxx)
+  */
+void Replay_FixPage(uint8_t page);
+
+/**
+  * @brief  释放读入的序列
+  */
+void Replay_Free(void);
+
+#endif /* __REPLAY_INPUT_H */
@@ -1,15 +1,22 @@
 /**
   ******************************************************************************
   * @file    Timer2.c
-  * @brief   定时器3驱动 - 用于ECG采样和时间测量
-  * 
+  * @brief   定时器3驱动 - 时间戳与100Hz节拍
+  *
   * @details TIM3配置:
   *          - 时钟源: 内部时钟 72MHz
-  *          - 预分频: 72 (72MHz/72 = 1MHz)
-  *          - 计数周期: 10 (1MHz/10 = 100kHz中断)
-  *          - 中断频率: 100000Hz (每10us一次中断)
-  *          - ECG采样: 每500次中断采样一次 = 200Hz
-  *          - 时间测量精度: 10us
+  *          - 预分频: 720 (72MHz/720 = 100kHz计数)
+  *          - 计数周期: 65536 (自由运行，仅溢出时产生更新中断)
+  *          - 时间测量精度: 10us，直接读取计数器寄存器
+  *
+  *          CC3比较通道按到期时间触发，每次中断后比较值加上周期:
+  *          - CC3: 100Hz  按键扫描，并分频出1Hz计时
+  *
+  *          主循环任务的周期由调度器读取时间戳决定（module/scheduler），
+  *          不再由本中断置标志位
+  *
+  *          ECG采样由TIM2硬件触发ADC+DMA完成，见AD.c
+  *          中断次数由原来的100000次/秒降为约100次/秒
   ******************************************************************************
   */
 
@@ -22,121 +29,132 @@
 #include "ad8232.h"
 #include "esp8266.h"
 #include "key.h"
-#include "max30102.h"
-#include "max30102_fir.h"
 #include "module/transmit/transmit.h"
+#include "module/irqstat/irqstat.h"
 
 /*============================ 私有变量 ============================*/
 
-static uint32_t tim3_counter = 0;   /**< TIM3中断计数器(0-999) */
-
-/*============================ 全局变量 ============================*/
-
-volatile uint32_t tim3_ms_counter = 0;  /**< 10us计数器，每10us加1（用于时间测量） */
+static volatile uint16_t tim3_overflow = 0; /**< TIM3溢出次数（时间戳高16位） */
+static uint16_t base_counter = 0;           /**< 调度基准分频计数器(0-99) */
 
 /*============================ 函数实现 ============================*/
 
 /**
   * @brief  定时器3初始化
-  * @note   配置TIM3产生1kHz中断
+  * @note   TIM3自由运行，CC3以调度基准周期产生比较中断
   */
 void Timer3_Init(void)
 {
     TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure;
+    TIM_OCInitTypeDef TIM_OCInitStructure;
     NVIC_InitTypeDef NVIC_InitStructure;
-    
+
     /* 开启TIM3时钟 */
     RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
-    
+
     /* 配置TIM3为内部时钟 */
     TIM_InternalClockConfig(TIM3);
-    
+
     /* 时基单元配置 */
     TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
     TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
-    TIM_TimeBaseInitStructure.TIM_Period = 10 - 1;          /* ARR = 10 */
-    TIM_TimeBaseInitStructure.TIM_Prescaler = 72 - 1;     /* PSC = 7200 */
+    TIM_TimeBaseInitStructure.TIM_Period = 0xFFFF;        /* ARR = 65536，自由运行 */
+    TIM_TimeBaseInitStructure.TIM_Prescaler = 720 - 1;    /* PSC = 720，100kHz */
     TIM_TimeBaseInitStructure.TIM_RepetitionCounter = 0;
     TIM_TimeBaseInit(TIM3, &TIM_TimeBaseInitStructure);
-    
-    /* 清除更新标志位（避免初始化后立即进入中断） */
-    TIM_ClearFlag(TIM3, TIM_FLAG_Update);
-    
-    /* 使能更新中断 */
-    TIM_ITConfig(TIM3, TIM_IT_Update, ENABLE);
-    
+
+    /* 比较通道配置: 冻结模式，仅用于产生中断，不输出到引脚 */
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+    TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Disable;
+
+    TIM_OCInitStructure.TIM_Pulse = TIM3_BASE_PERIOD;
+    TIM_OC3Init(TIM3, &TIM_OCInitStructure);
+    TIM_OC3PreloadConfig(TIM3, TIM_OCPreload_Disable);    /* 比较值立即生效 */
+
+    /* 清除标志位（避免初始化后立即进入中断） */
+    TIM_ClearFlag(TIM3, TIM_FLAG_Update | TIM_FLAG_CC3);
+
+    /* 使能溢出中断（时间戳扩展）和比较中断（100Hz节拍） */
+    TIM_ITConfig(TIM3, TIM_IT_Update | TIM_IT_CC3, ENABLE);
+
     /* NVIC配置 */
     NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
     NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
     NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
     NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
     NVIC_Init(&NVIC_InitStructure);
-    
+
     /* 使能TIM3 */
     TIM_Cmd(TIM3, ENABLE);
 }
 
-/*============================ 外部变量 ============================*/
+/**
+  * @brief  读取10us时间戳
+  * @retval 32位时间戳（单位10us）
+  * @note   若计数器已回绕但溢出中断尚未处理（如在更高优先级中断中调用），
+  *         通过UIF标志补偿高16位；读取期间溢出计数变化则重读
+  */
+uint32_t Timer3_GetTick(void)
+{
+    uint16_t high, low;
+    uint8_t pending;
+
+    do
+    {
+        high = tim3_overflow;
+        low = TIM3->CNT;
 
-extern volatile uint8_t display_refresh_flag;  /**< 5Hz显示刷新标志 */
-extern volatile uint8_t ecg_upload_flag;       /**< 10Hz ECG上传标志 */
+        /* 溢出已发生但尚未进入中断，且计数值为回绕后的小值 */
+        pending = ((TIM3->SR & TIM_FLAG_Update) != 0) && (low < 0x8000);
+    } while (high != tim3_overflow);
 
-#ifdef ENABLE_DEBUG_PAGE
-extern volatile uint8_t debug_refresh_flag;  /**< 调试页面刷新标志 */
-#endif
+    if (pending)
+    {
+        high++;
+    }
+
+    return ((uint32_t)high << 16) | low;
+}
 
 /**
   * @brief  TIM3中断服务函数
-  * @note   中断频率: 100000Hz
-  *         
+  * @note   仅在任务到期时进入
+  *
   *         任务分配:
-  *         - 每100000次(1Hz):  更新测试计数器
-  *         - 每10000次(10Hz):  调试页面刷新标志
-  *         - 每500次(200Hz):   ECG采样与绘制
-  *         - 每2000次(50Hz):  心率血氧数据采集
+  *         - 溢出(约1.5Hz):   时间戳高16位加1
+  *         - CC3 (100Hz):     按键扫描，并分频出1Hz计时
   */
 void TIM3_IRQHandler(void)
 {
+    IRQSTAT_ENTER();
+
+    /* 计数器溢出: 扩展时间戳 */
     if (TIM_GetITStatus(TIM3, TIM_IT_Update) == SET){
-        tim3_counter++;
-        tim3_ms_counter++;  /* 毫秒计数器（用于循环时间测量） */
-        
+        TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+        tim3_overflow++;
+    }
+
+    /* CC3 100Hz任务: 调度基准 */
+    if (TIM_GetITStatus(TIM3, TIM_IT_CC3) == SET){
+        TIM_ClearITPendingBit(TIM3, TIM_IT_CC3);
+        IRQSTAT_LATENCY((uint16_t)(TIM3->CNT - TIM_GetCapture3(TIM3)) * (SYSTEM_CLOCK_HZ / TIM3_COUNTER_FREQ));
+        TIM_SetCompare3(TIM3, TIM_GetCapture3(TIM3) + TIM3_BASE_PERIOD);
+
+        base_counter++;
+
+        /* 100Hz任务: 按键扫描，键码放入队列 */
+        Key_Scan();
+
         /* 1Hz任务: 秒计数器 + 传输模块回调 */
-        if (tim3_counter >= 100000){
+        if (base_counter >= SCHED_BASE_FREQ){
+            base_counter = 0;
             test++;
-            tim3_counter = 0;
             Transmit_TimerCallback();  /* 每秒调用一次传输模块 */
         }
-		
-		/* 50Hz任务: 心率血氧采集（非ECG页面执行） */
-		if ((tim3_counter % 2000 == 0) && (current_page != PAGE_ECG)){
-			max30102_process_flag = 1;
-		}
-        
-        /* 200Hz任务: ECG采样与绘制（仅在心电图页面执行） */
-        if ((tim3_counter % 500 == 0) && (current_page == PAGE_ECG)){
-            ECG_SampleAndDraw();
-        }
-        
-        /* 5Hz任务: 心率页面显示刷新 */
-        if (tim3_counter % 20000 == 0){
-            display_refresh_flag = 1;
-        }
-        
-        /* 100Hz任务: ECG上传触发（每10ms发送一批，实时传输） */
-        if (tim3_counter % 1000 == 0){
-            ecg_upload_flag = 1;
-        }
-        
-#ifdef ENABLE_DEBUG_PAGE
-        /* 10Hz任务: 调试页面刷新 */
-        if (tim3_counter % 10000 == 0){
-            debug_refresh_flag = 1;
-        }
-#endif
-        
-        /* 清除中断标志 */
-        TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+
+        /* 只统计CC3，溢出单独进入的几次不计入节拍抖动 */
+        IRQSTAT_EXIT(IRQSTAT_TIM3);
     }
 }
 
@@ -9,17 +9,25 @@
 #define __TIMER2_H
 
 #include "stdint.h"
+#include "kconfig.h"
 
-/*============================ 外部变量 ============================*/
+/*============================ 调度周期（单位：10us计数） ============================*/
 
-extern volatile uint32_t tim3_ms_counter;  /**< 10us计数器，每10us加1（100kHz） */
+#define TIM3_BASE_PERIOD    (TIM3_COUNTER_FREQ / SCHED_BASE_FREQ)   /**< CC3: 调度基准周期 */
 
 /*============================ 函数声明 ============================*/
 
 /**
  * @brief  定时器3初始化
- * @note   配置TIM3产生1kHz中断，用于ECG采样
+ * @note   TIM3以100kHz自由运行，CC3产生100Hz节拍中断
  */
 void Timer3_Init(void);
 
+/**
+ * @brief  读取10us时间戳
+ * @retval 自TIM3启动以来的计数值（单位10us，约11.9小时回绕）
+ * @note   由TIM3计数器和溢出次数拼接而成，可在中断和主循环中调用
+ */
+uint32_t Timer3_GetTick(void);
+
 #endif
@@ -4,61 +4,190 @@
 #include "stm32f10x_rcc.h"     // 包含 RCC 外设定义
 #include "stm32f10x_gpio.h"
 #include "stm32f10x_adc.h"
+#include "stm32f10x_dma.h"
+#include "stm32f10x_tim.h"
+#include "AD.h"
+#include "ad8232.h"
+#include "module/irqstat/irqstat.h"
 
+/**
+  * 采集链路：
+  * TIM2 CC2 (ECG_SAMPLE_FREQ) --触发--> ADC1 通道8 --DMA1通道1(循环)--> AD_DMABuf
+  *
+  *      AD_DMABuf: [  前半缓冲  |  后半缓冲  ]
+  *                      ^ 半满中断     ^ 全满中断
+  *
+  * DMA写后半缓冲时CPU处理前半缓冲，反之亦然，采样时刻完全由硬件决定，无抖动
+  */
+
+static uint16_t AD_DMABuf[AD_DMA_BUF_LEN];		//DMA双缓冲
+static volatile uint16_t AD_LastValue = 0;		//最近一次转换结果
+
+/**
+  * 函    数：ECG采样定时器初始化
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：TIM2以1MHz计数，周期为1/ECG_SAMPLE_FREQ，CC2比较事件触发ADC转换
+  *           TIM2_CH2对应的PA1为LED1，保持GPIO推挽输出模式，比较输出不会出现在引脚上
+  */
+static void AD_TriggerTimer_Init(void)
+{
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);	//开启TIM2的时钟
+
+	TIM_InternalClockConfig(TIM2);
+
+	/*时基单元初始化*/
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure;
+	TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInitStructure.TIM_Period = 1000000 / ECG_SAMPLE_FREQ - 1;	//ARR，采样周期
+	TIM_TimeBaseInitStructure.TIM_Prescaler = 72 - 1;						//PSC，72MHz / 72 = 1MHz
+	TIM_TimeBaseInitStructure.TIM_RepetitionCounter = 0;
+	TIM_TimeBaseInit(TIM2, &TIM_TimeBaseInitStructure);
+
+	/*CC2配置为PWM模式，每个周期产生一次比较事件*/
+	TIM_OCInitTypeDef TIM_OCInitStructure;
+	TIM_OCStructInit(&TIM_OCInitStructure);
+	TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+	TIM_OCInitStructure.TIM_OCPolarity = TIM_OCPolarity_High;
+	TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;	//ADC外部触发需要使能CC2
+	TIM_OCInitStructure.TIM_Pulse = (1000000 / ECG_SAMPLE_FREQ) / 2;
+	TIM_OC2Init(TIM2, &TIM_OCInitStructure);
+}
+
+/**
+  * 函    数：AD DMA初始化
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：DMA1通道1循环搬运ADC1->DR到AD_DMABuf，开启半满和全满中断
+  */
+static void AD_DMA_Init(void)
+{
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);		//开启DMA1的时钟
+
+	DMA_DeInit(DMA1_Channel1);
+
+	DMA_InitTypeDef DMA_InitStructure;
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;			//外设地址，ADC1数据寄存器
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)AD_DMABuf;				//存储器地址，双缓冲
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;						//外设到存储器
+	DMA_InitStructure.DMA_BufferSize = AD_DMA_BUF_LEN;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;							//循环模式
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_Init(DMA1_Channel1, &DMA_InitStructure);
+
+	DMA_ClearFlag(DMA1_FLAG_GL1);
+	DMA_ITConfig(DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE);	//半满、全满中断
+
+	NVIC_InitTypeDef NVIC_InitStructure;
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel1_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	DMA_Cmd(DMA1_Channel1, ENABLE);
+}
 
 /**
   * 函    数：AD初始化
   * 参    数：无
   * 返 回 值：无
+  * 说    明：初始化完成后采集即开始，数据通过DMA中断交给ECG_ProcessBlock
   */
 void AD_Init(void)
 {
 	/*开启时钟*/
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC1, ENABLE);	//开启ADC1的时钟
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);	//开启GPIOA的时钟
-	
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);	//开启GPIOB的时钟
+
 	/*设置ADC时钟*/
 	RCC_ADCCLKConfig(RCC_PCLK2_Div6);						//选择时钟6分频，ADCCLK = 72MHz / 6 = 12MHz
-	
+
 	/*GPIO初始化*/
 	GPIO_InitTypeDef GPIO_InitStructure;
 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
 	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_0;
 	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-	GPIO_Init(GPIOB, &GPIO_InitStructure);					//将PA0引脚初始化为模拟输入
-	
+	GPIO_Init(GPIOB, &GPIO_InitStructure);					//将PB0引脚初始化为模拟输入
+
 	/*规则组通道配置*/
-	ADC_RegularChannelConfig(ADC1, ADC_Channel_8, 1, ADC_SampleTime_55Cycles5);		//规则组序列1的位置，配置为通道0
-	
+	ADC_RegularChannelConfig(ADC1, ADC_Channel_8, 1, ADC_SampleTime_55Cycles5);		//规则组序列1的位置，配置为通道8
+
 	/*ADC初始化*/
 	ADC_InitTypeDef ADC_InitStructure;						//定义结构体变量
 	ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;		//模式，选择独立模式，即单独使用ADC1
 	ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;	//数据对齐，选择右对齐
-	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_None;	//外部触发，使用软件触发，不需要外部触发
-	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;		//连续转换，失能，每转换一次规则组序列后停止
+	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T2_CC2;	//外部触发，TIM2 CC2
+	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;		//连续转换，失能，每次触发转换一次
 	ADC_InitStructure.ADC_ScanConvMode = DISABLE;			//扫描模式，失能，只转换规则组的序列1这一个位置
 	ADC_InitStructure.ADC_NbrOfChannel = 1;					//通道数，为1，仅在扫描模式下，才需要指定大于1的数，在非扫描模式下，只能是1
 	ADC_Init(ADC1, &ADC_InitStructure);						//将结构体变量交给ADC_Init，配置ADC1
-	
+
+	/*DMA请求使能*/
+	ADC_DMACmd(ADC1, ENABLE);
+
 	/*ADC使能*/
-	ADC_Cmd(ADC1, ENABLE);									//使能ADC1，ADC开始运行
-	
+	ADC_Cmd(ADC1, ENABLE);									//使能ADC1
+
 	/*ADC校准*/
 	ADC_ResetCalibration(ADC1);								//固定流程，内部有电路会自动执行校准
 	while (ADC_GetResetCalibrationStatus(ADC1) == SET);
 	ADC_StartCalibration(ADC1);
 	while (ADC_GetCalibrationStatus(ADC1) == SET);
+
+	/*外部触发使能*/
+	ADC_ExternalTrigConvCmd(ADC1, ENABLE);
+
+	/*启动DMA和采样定时器*/
+	AD_DMA_Init();
+	AD_TriggerTimer_Init();
+	TIM_Cmd(TIM2, ENABLE);									//TIM2开始计数，采集开始
 }
 
 /**
   * 函    数：获取AD转换的值
   * 参    数：无
-  * 返 回 值：AD转换的值，范围：0~4095
+  * 返 回 值：最近一次DMA采集到的AD值，范围：0~4095
+  * 说    明：采集由硬件自动完成，此函数不再启动转换和等待
   */
 uint16_t AD_GetValue(void)
 {
-	ADC_SoftwareStartConvCmd(ADC1, ENABLE);					//软件触发AD转换一次
-	while (ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) == RESET);	//等待EOC标志位，即等待AD转换结束
-	return ADC_GetConversionValue(ADC1);					//读数据寄存器，得到AD转换的结果
+	return AD_LastValue;
+}
+
+/**
+  * 函    数：DMA1通道1中断服务函数
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：半满时处理前半缓冲，全满时处理后半缓冲
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+	IRQSTAT_ENTER();
+	
+	/* 延迟: 半缓冲最后一点的采样触发 (TIM2 CC2) 以来的时间，TIM2以1MHz计数 */
+	IRQSTAT_LATENCY((TIM2->CNT + TIM2->ARR + 1 - TIM2->CCR2) % (TIM2->ARR + 1) * (SYSTEM_CLOCK_HZ / 1000000));
+	
+	if (DMA_GetITStatus(DMA1_IT_HT1) == SET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_HT1);
+		AD_LastValue = AD_DMABuf[AD_DMA_HALF_LEN - 1];
+		ECG_ProcessBlock(&AD_DMABuf[0], AD_DMA_HALF_LEN);
+	}
+
+	if (DMA_GetITStatus(DMA1_IT_TC1) == SET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_TC1);
+		AD_LastValue = AD_DMABuf[AD_DMA_BUF_LEN - 1];
+		ECG_ProcessBlock(&AD_DMABuf[AD_DMA_HALF_LEN], AD_DMA_HALF_LEN);
+	}
+	
+	IRQSTAT_EXIT(IRQSTAT_ADC_DMA);
 }
 #endif
@@ -1,6 +1,13 @@
 #ifndef __AD_H
 #define __AD_H
 
+#include "stdint.h"
+#include "kconfig.h"
+
+/* DMA双缓冲: 每个半缓冲的采样点数，半满/全满各回调一次 */
+#define AD_DMA_HALF_LEN     (ECG_SAMPLE_FREQ / ECG_BLOCK_FREQ)
+#define AD_DMA_BUF_LEN      (AD_DMA_HALF_LEN * 2)
+
 void AD_Init(void);
 uint16_t AD_GetValue(void);
 
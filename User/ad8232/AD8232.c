@@ -6,8 +6,25 @@
   * @details AD8232是一款单导联心电前端芯片，用于采集心电信号(ECG)
   *          本驱动实现:
   *          - GPIO初始化（电极脱落检测引脚）
-  *          - ECG数据采集与低通滤波
+  *          - ECG数据低通滤波（数据由ADC DMA按块送入）
+  *          - QRS检测，逐拍更新ECG心率（ecg_qrs.c）
   *          - OLED实时波形绘制
+  *
+  *          中断与主循环分工:
+  *
+  *          DMA中断: QRS检测 -> 滤波 -> [上传环形队列] -> 缩放 -> [绘图环形队列]（仅心电图页面）
+  *                                                  │ 单生产者/单消费者，无锁
+  *          主循环:  ECG_Render() 按帧率取出 <─────┘
+  *                   -> 画新增列（由OLED脏区记录决定刷新范围）
+  *          上传:    Transmit_ECGUploadProcess() 取出 <── [上传环形队列]
+  * 
+  *          上传队列的写索引持续递增，采集不再因上传而暂停，不在心电图页面时也照常写入:
+  *          - 空闲时作为历史缓存，旧数据被覆盖
+  *          - 单次上传: 取最近 ECG_CAPTURE_LEN 个点，上传期间新数据照常写入
+  *          - 连续上传: 边采边传，队列满时丢弃新点并计数
+  *          上传中丢点后队列序号少于采样点序号，中断在缺口后第一个点入队时
+  *          记录一条缺口（队列序号、累计丢点数），主循环取数时据此换算采样点序号
+  *          两个队列均为 module/ring 的单生产者/单消费者队列
   ******************************************************************************
   */
 
@@ -17,8 +34,14 @@
 #include "stm32f10x_rcc.h"
 #include "stm32f10x_gpio.h"
 #include "ad8232.h"
+#include "ecg_qrs.h"
 #include "OLED.h"
 #include "AD.h"
+#include "key.h"
+#include "module/ring/ring.h"
+#ifdef ENABLE_TRACE_RECORD
+#include "module/trace/trace.h"
+#endif
 
 /*============================ 全局变量 ============================*/
 
@@ -29,20 +52,70 @@ uint16_t test = 0;              /**< 测试计数器（秒） */
 
 /*============================ ECG上传缓存 ============================*/
 
-#define ECG_UPLOAD_BUFFER_SIZE  600   /**< 上传缓存大小（3秒 @ 200Hz） */
-#define ECG_UPLOAD_BATCH_SIZE   1     /**< 每批上传点数 */
+#define ECG_CAPTURE_LEN         (3 * ECG_SAMPLE_FREQ)  /**< 单次上传点数（最近3秒） */
+
+/* 上传队列长度: 大于 ECG_CAPTURE_LEN 的最小2的幂（200Hz: 5.1秒，500/1000Hz: 4.1秒） */
+#if ECG_CAPTURE_LEN < 1024
+#define ECG_UPLOAD_RING_SIZE    1024
+#elif ECG_CAPTURE_LEN < 2048
+#define ECG_UPLOAD_RING_SIZE    2048
+#elif ECG_CAPTURE_LEN < 4096
+#define ECG_UPLOAD_RING_SIZE    4096
+#else
+#error "ECG_SAMPLE_FREQ too high for the ECG upload ring"
+#endif
+#define ECG_UPLOAD_BATCH_SIZE   50    /**< 每批最多上传点数（一帧） */
+#define ECG_GAP_RING_SIZE       8     /**< 缺口记录队列长度（必须为2的幂） */
+
+#if (ECG_CAPTURE_LEN >= ECG_UPLOAD_RING_SIZE) || !RING_IS_POW2(ECG_UPLOAD_RING_SIZE)
+#error "ECG_UPLOAD_RING_SIZE must be a power of two larger than ECG_CAPTURE_LEN"
+#endif
 
-uint16_t ecg_upload_buffer[ECG_UPLOAD_BUFFER_SIZE];  /**< ECG原始数据上传缓存 */
-uint16_t ecg_upload_write_idx = 0;    /**< 写入索引 */
-uint16_t ecg_upload_read_idx = 0;     /**< 上传读取索引 */
-uint8_t  ecg_upload_active = 0;       /**< 上传进行中标志 */
-uint32_t ecg_upload_timestamp = 0;    /**< 上传数据起始时间戳 */
+static uint16_t ecg_upload_buf[ECG_UPLOAD_RING_SIZE];   /**< 上传队列存储区 */
+static uint32_t ecg_upload_end = 0;            /**< 单次上传的结束位置 */
+static uint32_t ecg_upload_begin = 0;          /**< 单次上传的起始位置（计算进度） */
+static volatile uint8_t ecg_upload_mode = ECG_UPLOAD_IDLE;  /**< 上传模式 */
+
+/** @brief ECG滤波数据上传队列（overrun为上传中队列满丢弃的点数，序号加上丢点数为采样点序号） */
+Ring_t ecg_upload_ring;
+
+/**
+  * @brief  上传丢点缺口记录
+  */
+typedef struct
+{
+    uint32_t at;        /**< 缺口后第一个点的队列序号 */
+    uint32_t skew;      /**< 此点及之后: 采样点序号 - 队列序号（累计丢点数） */
+} ECG_Gap_t;
+
+static ECG_Gap_t ecg_gap_buf[ECG_GAP_RING_SIZE];
+static Ring_t ecg_gap_ring;                 /**< 中断写入，主循环取数时取出 */
+static uint32_t ecg_gap_pending = 0;        /**< 尚未记录的丢点数（中断中修改，上传停止后主循环可改） */
+static uint32_t ecg_gap_skew = 0;           /**< 最近一条缺口记录的累计丢点数（同上） */
+static uint32_t ecg_upload_skew = 0;        /**< 读位置的累计丢点数（主循环） */
+static uint32_t ecg_upload_gap_at = 0;      /**< 最近一个已计入的缺口位置（主循环） */
 
 /*============================ 私有变量 ============================*/
 
+#define ECG_DRAW_DIV    (ECG_SAMPLE_FREQ / 200)  /**< 绘图抽取比，波形固定按200Hz推进 */
+
+#define ECG_DRAW_RING_SIZE  128       /**< 绘图队列长度（必须为2的幂） */
+
+#define ECG_PLOT_X0     3             /**< 波形区起始列 */
+
 static uint16_t draw_x = 0;           /**< 绘图X坐标 */
+static uint8_t  draw_div_cnt = 0;     /**< 绘图抽取计数 */
 static uint16_t last_filtered = 2048; /**< 上一次滤波值（用于上传数据滤波）*/
 
+static uint8_t  ecg_draw_buf[ECG_DRAW_RING_SIZE];   /**< 绘图队列存储区 */
+
+/** @brief 绘图队列（已缩放的Y坐标，overrun为主循环来不及绘制丢弃的点数） */
+Ring_t ecg_draw_ring;
+
+/*============================ 私有函数 ============================*/
+
+static uint16_t ECG_FilterStore(uint16_t adc_raw);
+
 /*============================ 函数实现 ============================*/
 
 /**
@@ -68,6 +141,12 @@ void AD8232Init(void)
     GPIO_InitStructure.GPIO_Pin = GPIO_Pin_1;
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
     GPIO_Init(GPIOB, &GPIO_InitStructure);
+
+    Ring_Init(&ecg_upload_ring, ecg_upload_buf, sizeof(ecg_upload_buf[0]), ECG_UPLOAD_RING_SIZE);
+    Ring_Init(&ecg_gap_ring, ecg_gap_buf, sizeof(ecg_gap_buf[0]), ECG_GAP_RING_SIZE);
+    Ring_Init(&ecg_draw_ring, ecg_draw_buf, sizeof(ecg_draw_buf[0]), ECG_DRAW_RING_SIZE);
+
+    ECG_QRS_Reset();
 }
 
 /**
@@ -93,63 +172,156 @@ uint8_t GetConnect(void)
 }
 
 /**
-  * @brief  ECG数据采集与绘制
-  * @note   此函数应在定时器中断中调用，采样率200Hz
-  *         
-  *         数据处理流程:
-  *         1. 读取ADC值
-  *         2. 低通滤波
-  *         3. 保存滤波后数据到上传缓存
-  *         4. 数据缩放并绘制波形
+  * @brief  处理一块ECG采样数据
+  * @param  samples: DMA半缓冲中的采样数据
+  * @param  count: 采样点数
+  * @note   在ADC DMA半满/全满中断中调用，QRS检测和上传与页面无关，
+  *         只有绘图仅在心电图页面进行（见 ECG_ProcessSample）
   */
-void ECG_SampleAndDraw(void)
+void ECG_ProcessBlock(const uint16_t *samples, uint16_t count)
 {
-    uint16_t adc_raw;
-    uint16_t filtered;
+    uint16_t i;
+
+#ifdef ENABLE_TRACE_RECORD
+    Trace_RecordECG(samples, count, GetConnect());   /* 与页面无关，全部记录 */
+#endif
+
+    for (i = 0; i < count; i++)
+    {
+        ECG_ProcessSample(samples[i]);
+    }
+}
+
+/**
+  * @brief  上传中写入一个点（DMA中断中调用）
+  * @note   队列满时丢弃并累计缺口，之后第一个能入队的点先记录缺口；
+  *         缺口记录队列也满时该点一并丢弃，缺口继续累计
+  */
+static void ECG_UploadPut(uint16_t sample)
+{
+    ECG_Gap_t gap;
     
-    /* 注意: 调用前需在Timer2.c中判断 current_page == PAGE_ECG */
+    if (ecg_gap_pending != 0 && Ring_Free(&ecg_upload_ring) != 0)
+    {
+        gap.at = ecg_upload_ring.head;
+        gap.skew = ecg_gap_skew + ecg_gap_pending;
+        if (Ring_Put(&ecg_gap_ring, &gap) != 0)
+        {
+            ecg_upload_ring.overrun++;
+            ecg_gap_pending++;
+            return;
+        }
+        ecg_gap_skew = gap.skew;
+        ecg_gap_pending = 0;
+    }
     
-    /* 1. 读取ADC原始值 */
-    adc_raw = AD_GetValue();
+    if (Ring_Put(&ecg_upload_ring, &sample) != 0)
+    {
+        ecg_gap_pending++;
+    }
+}
+
+/**
+  * @brief  低通滤波后写入上传队列
+  * @param  adc_raw: ADC原始值
+  * @retval 滤波后的值
+  */
+static uint16_t ECG_FilterStore(uint16_t adc_raw)
+{
+    uint16_t filtered;
     
-    /* 2. 低通滤波: y = y_last + 0.25 * (y_new - y_last) */
-    filtered = last_filtered + (int16_t)(adc_raw - last_filtered) * 0.25f;
+    /* 低通滤波: y = y_last + (y_new - y_last) / 4
+     *    算术右移向下取整，与原浮点乘0.25后截断的结果完全相同，无软件浮点调用 */
+    filtered = last_filtered + ((int16_t)(adc_raw - last_filtered) >> 2);
     last_filtered = filtered;
     
-    /* 3. 保存滤波后数据到上传缓存 */
-    if (!ecg_upload_active)  /* 上传过程中不覆盖数据 */
+    if (ecg_upload_mode == ECG_UPLOAD_IDLE)
     {
-        ecg_upload_buffer[ecg_upload_write_idx] = filtered;
-        ecg_upload_write_idx++;
-        if (ecg_upload_write_idx >= ECG_UPLOAD_BUFFER_SIZE)
-        {
-            ecg_upload_write_idx = 0;
-        }
+        Ring_PutOverwrite(&ecg_upload_ring, &filtered);  /* 空闲时作为历史缓存 */
+    }
+    else
+    {
+        ECG_UploadPut(filtered);    /* 上传中队列满则丢弃，不覆盖未发送的数据 */
     }
+    return filtered;
+}
+
+/**
+  * @brief  ECG单点处理
+  * @param  adc_raw: ADC原始值
+  * @note   数据处理流程（中断中执行，耗时固定，不访问显存）:
+  *         1. QRS检测（使用原始数据，带通在检测器内部完成）
+  *         2. 低通滤波
+  *         3. 保存滤波后数据到上传队列
+  *         4. 按200Hz抽取后缩放，放入绘图队列（仅心电图页面）
+  */
+void ECG_ProcessSample(uint16_t adc_raw)
+{
+    uint16_t filtered;
+    uint8_t y;
+    
+    /* 1. QRS检测 */
+    ECG_QRS_Process(adc_raw);
     
-    /* 4. 绘制波形 */
-    if (ecg_index < 120)
+    /* 2-3. 低通滤波，保存滤波后数据到上传队列 */
+    filtered = ECG_FilterStore(adc_raw);
+    
+    /* 4. 抽取到200Hz后放入绘图队列 */
+    if (current_page != PAGE_ECG || ++draw_div_cnt < ECG_DRAW_DIV)
     {
-        /* 数据缩放（适配OLED Y轴范围10-55） */
-        ecg_data[ecg_index] = 90 - filtered / 45;
-        ecg_data[0] = ecg_data[1];
-        
-        /* 绘制波形线段 */
-        OLED_DrawLine(draw_x + 3, ecg_data[ecg_index - 1], 
-                      draw_x + 4, ecg_data[ecg_index]);
-        
-        ecg_index++;
-        draw_x += 1;
+        return;
     }
-    else
+    draw_div_cnt = 0;
+    
+    /* 数据缩放（适配OLED Y轴范围10-55），主循环来不及绘制时丢弃 */
+    y = 90 - filtered / 45;
+    Ring_Put(&ecg_draw_ring, &y);
+}
+
+/**
+  * @brief  ECG波形渲染（主循环调用）
+  * @note   取出绘图队列中所有新点，逐列画线，只写显存，
+  *         由调用者调用OLED_Update发送改动的部分
+  */
+void ECG_Render(void)
+{
+    uint8_t y;
+    
+    while (Ring_Get(&ecg_draw_ring, &y))
     {
-        /* 到达屏幕边缘，清屏重绘 */
-        ECG_ClearAndRedraw();
-        ecg_index = 1;
-        draw_x = 0;
+        if (ecg_index < 120)
+        {
+            ecg_data[ecg_index] = y;
+            ecg_data[0] = ecg_data[1];
+            
+            /* 绘制波形线段 */
+            OLED_DrawLine(draw_x + ECG_PLOT_X0, ecg_data[ecg_index - 1], 
+                          draw_x + ECG_PLOT_X0 + 1, ecg_data[ecg_index]);
+            
+            ecg_index++;
+            draw_x += 1;
+        }
+        else
+        {
+            /* 到达屏幕边缘，清屏重绘 */
+            ECG_ClearAndRedraw();
+            ecg_index = 1;
+            draw_x = 0;
+        }
     }
 }
 
+/**
+  * @brief  ECG渲染状态复位
+  * @note   进入心电图页面时调用，丢弃队列中的旧数据并从左侧重新绘制
+  */
+void ECG_RenderReset(void)
+{
+    Ring_Flush(&ecg_draw_ring);
+    ecg_index = 1;
+    draw_x = 0;
+}
+
 /**
   * @brief  ECG显示区域清除并重绘坐标轴
   * @note   清除波形区域，保留坐标轴
@@ -177,39 +349,6 @@ void ECG_ClearAndRedraw(void)
     OLED_DrawTriangle(120, 55, 120, 53, 123, 54, OLED_UNFILLED);
 }
 
-/**
-  * @brief  获取心率值（峰值检测法）
-  * @param  array: ECG数据数组
-  * @param  length: 数组长度
-  * @retval 心率值（基于相邻峰值间隔计算）
-  * @note   通过检测ECG波形的R波峰值计算心率
-  */
-uint8_t GetHeartRate(uint16_t *array, uint16_t length)
-{
-    uint8_t i, count = 0;
-    uint16_t peakPositions[10] = {0};
-    
-    for (i = 1; i < length - 1; i++) 
-    {
-        /* 检测峰值：当前点大于前后两点，且幅值小于阈值 */
-        if ((array[i] > array[i - 1]) && 
-            (array[i] > array[i + 1]) && 
-            (array[i] < 20)) 
-        {
-            peakPositions[count] = i;
-            count++;
-            
-            if (count >= 2)
-            {
-                /* 计算心率: HR = 60 / (峰值间隔 * 采样周期) */
-                return (peakPositions[1] - peakPositions[0]);
-            }
-        }
-    }
-    
-    return 0;
-}
-
 /**
   * @brief  绘制ECG图表（静态显示）
   * @param  Chart: 数据数组
@@ -252,62 +391,160 @@ void ChartOptimize(uint16_t *R, uint16_t *Chart)
 /*============================================================================*/
 
 /**
-  * @brief  开始ECG数据上传
-  * @param  timestamp: 数据起始时间戳
-  * @note   调用后，ECG_UploadProcess() 会分批上传数据
+  * @brief  上传停止后计入全部缺口
+  * @note   调用前上传模式须已置为空闲，此后中断不再改动缺口记录；
+  *         未记录的丢点发生在当前写位置，之后的点都在缺口之后
+  */
+static void ECG_UploadSyncAll(void)
+{
+    ECG_Gap_t gap;
+    
+    while (Ring_Get(&ecg_gap_ring, &gap))
+    {
+        ecg_upload_gap_at = gap.at;
+        ecg_upload_skew = gap.skew;
+    }
+    if (ecg_gap_pending != 0)
+    {
+        ecg_gap_skew += ecg_gap_pending;
+        ecg_gap_pending = 0;
+        ecg_upload_gap_at = ecg_upload_ring.head;
+        ecg_upload_skew = ecg_gap_skew;
+    }
+}
+
+/**
+  * @brief  计入读位置之前的缺口
+  * @retval 到下一个缺口前可连续取出的点数，没有缺口时为0xFFFF
+  */
+static uint16_t ECG_UploadSyncGaps(void)
+{
+    const ECG_Gap_t *gap;
+    int32_t ahead;
+    
+    while (Ring_Count(&ecg_gap_ring) > 0)
+    {
+        gap = (const ECG_Gap_t *)Ring_At(&ecg_gap_ring, ecg_gap_ring.tail);
+        ahead = (int32_t)(gap->at - ecg_upload_ring.tail);
+        if (ahead > 0)
+        {
+            return (ahead < 0xFFFF) ? (uint16_t)ahead : 0xFFFF;
+        }
+        ecg_upload_gap_at = gap->at;
+        ecg_upload_skew = gap->skew;
+        Ring_Skip(&ecg_gap_ring, 1);
+    }
+    return 0xFFFF;
+}
+
+/**
+  * @brief  开始单次ECG上传
+  * @note   上传按键前最近 ECG_CAPTURE_LEN 个点，采集不暂停
+  *         窗口从最近一个丢点缺口之后开始，可能少于 ECG_CAPTURE_LEN
+  */
+void ECG_StartUpload(void)
+{
+    uint32_t head;
+    uint32_t len;
+    
+    ecg_upload_mode = ECG_UPLOAD_IDLE;
+    ECG_UploadSyncAll();
+    head = ecg_upload_ring.head;
+    len = (head < ECG_CAPTURE_LEN) ? head : ECG_CAPTURE_LEN;
+    
+    /* 刚结束的连续上传在窗口内丢过点时，只取缺口之后的部分，保证时间连续 */
+    if ((int32_t)(head - ecg_upload_gap_at) < (int32_t)len)
+    {
+        len = head - ecg_upload_gap_at;
+    }
+    ecg_upload_begin = head - len;
+    ecg_upload_end = head;
+    Ring_Rewind(&ecg_upload_ring, head - ecg_upload_begin);  /* 先设置读索引，再允许写入检查队列满 */
+    ecg_upload_mode = ECG_UPLOAD_ONESHOT;
+}
+
+/**
+  * @brief  开始连续ECG上传
+  * @note   从当前时刻开始边采边传，直到调用ECG_StopUpload
   */
-void ECG_StartUpload(uint32_t timestamp)
+void ECG_StartStream(void)
 {
-    ecg_upload_timestamp = timestamp;
-    ecg_upload_read_idx = 0;
-    ecg_upload_active = 1;
+    ecg_upload_mode = ECG_UPLOAD_IDLE;
+    ECG_UploadSyncAll();
+    Ring_Rewind(&ecg_upload_ring, 0);
+    ecg_upload_mode = ECG_UPLOAD_STREAM;
 }
 
 /**
   * @brief  停止ECG数据上传
+  * @note   立即计入未记录的丢点，缺口记在停止时的写位置，
+  *         之后空闲期间写入的点与下次单次上传保持连续
   */
 void ECG_StopUpload(void)
 {
-    ecg_upload_active = 0;
-    ecg_upload_read_idx = 0;
+    ecg_upload_mode = ECG_UPLOAD_IDLE;
+    ECG_UploadSyncAll();
 }
 
 /**
-  * @brief  获取待上传的数据量
-  * @retval 缓存中的数据点数
+  * @brief  获取当前上传模式
+  * @retval ECG_UPLOAD_IDLE / ECG_UPLOAD_ONESHOT / ECG_UPLOAD_STREAM
   */
-uint16_t ECG_GetUploadDataCount(void)
+uint8_t ECG_GetUploadMode(void)
 {
-    return ecg_upload_write_idx;
+    return ecg_upload_mode;
 }
 
 /**
-  * @brief  获取一批ECG数据用于上传
-  * @param  batch_data: 输出缓冲区（至少20个元素）
-  * @param  batch_size: 请求的批次大小
-  * @retval 实际获取的数据点数（0表示上传完成）
+  * @brief  获取待上传的数据量
+  * @retval 队列中尚未取出的数据点数
   */
-uint16_t ECG_GetUploadBatch(uint16_t *batch_data, uint16_t batch_size)
+uint16_t ECG_GetUploadDataCount(void)
 {
-    uint16_t i;
-    uint16_t count = 0;
-    uint16_t available;
+    uint32_t limit;
     
-    if (!ecg_upload_active)
+    if (ecg_upload_mode == ECG_UPLOAD_IDLE)
     {
         return 0;
     }
+    limit = (ecg_upload_mode == ECG_UPLOAD_ONESHOT) ? ecg_upload_end : ecg_upload_ring.head;
     
-    /* 计算剩余数据量 */
-    available = ecg_upload_write_idx - ecg_upload_read_idx;
+    return (uint16_t)(limit - ecg_upload_ring.tail);
+}
+
+/**
+  * @brief  获取下一个待上传点的序号
+  * @retval 自采集开始的采样点序号（含上传中丢弃的点），用于计算帧时间戳
+  */
+uint32_t ECG_GetUploadPosition(void)
+{
+    ECG_UploadSyncGaps();
+    return ecg_upload_ring.tail + ecg_upload_skew;
+}
+
+/**
+  * @brief  读取一批ECG数据用于上传，不取出
+  * @param  batch_data: 输出缓冲区（至少ECG_UPLOAD_BATCH_SIZE个元素）
+  * @param  batch_size: 请求的批次大小
+  * @retval 读到的数据点数（0表示暂无数据或上传完成）
+  * @note   一批不跨越丢点缺口，批内各点的采样时间连续；
+  *         发送成功后调用 ECG_ConsumeUpload 取出
+  */
+uint16_t ECG_PeekUploadBatch(uint16_t *batch_data, uint16_t batch_size)
+{
+    uint16_t available, contiguous, i;
+    
+    available = ECG_GetUploadDataCount();
     if (available == 0)
     {
-        /* 上传完成 */
-        ecg_upload_active = 0;
+        if (ecg_upload_mode == ECG_UPLOAD_ONESHOT)
+        {
+            ecg_upload_mode = ECG_UPLOAD_IDLE;  /* 单次上传完成 */
+            ECG_UploadSyncAll();
+        }
         return 0;
     }
-    
-    /* 限制批次大小 */
+    /* 限制批次大小（单次上传不超过结束位置） */
     if (batch_size > available)
     {
         batch_size = available;
@@ -316,30 +553,60 @@ uint16_t ECG_GetUploadBatch(uint16_t *batch_data, uint16_t batch_size)
     {
         batch_size = ECG_UPLOAD_BATCH_SIZE;
     }
+    contiguous = ECG_UploadSyncGaps();
+    if (batch_size > contiguous)
+    {
+        batch_size = contiguous;
+    }
     
-    /* 复制数据 */
     for (i = 0; i < batch_size; i++)
     {
-        batch_data[i] = ecg_upload_buffer[ecg_upload_read_idx + i];
-        count++;
+        batch_data[i] = *(const uint16_t *)Ring_At(&ecg_upload_ring, ecg_upload_ring.tail + i);
     }
+    return batch_size;
+}
+
+/**
+  * @brief  取出已发送的点
+  * @param  count: ECG_PeekUploadBatch 读到的点数
+  */
+void ECG_ConsumeUpload(uint16_t count)
+{
+    Ring_Skip(&ecg_upload_ring, count);
+}
+
+/**
+  * @brief  获取一批ECG数据用于上传并取出
+  * @param  batch_data: 输出缓冲区（至少ECG_UPLOAD_BATCH_SIZE个元素）
+  * @param  batch_size: 请求的批次大小
+  * @retval 实际获取的数据点数（0表示暂无数据或上传完成）
+  */
+uint16_t ECG_GetUploadBatch(uint16_t *batch_data, uint16_t batch_size)
+{
+    uint16_t count = ECG_PeekUploadBatch(batch_data, batch_size);
     
-    ecg_upload_read_idx += count;
-    
+    ECG_ConsumeUpload(count);
     return count;
 }
 
 /**
   * @brief  获取上传进度
-  * @retval 进度百分比 (0-100)
+  * @retval 单次上传的进度百分比 (0-100)，连续上传时为0
   */
 uint8_t ECG_GetUploadProgress(void)
 {
-    if (ecg_upload_write_idx == 0)
+    uint32_t total;
+    
+    if (ecg_upload_mode == ECG_UPLOAD_STREAM)
+    {
+        return 0;
+    }
+    total = ecg_upload_end - ecg_upload_begin;
+    if (ecg_upload_mode == ECG_UPLOAD_IDLE || total == 0)
     {
         return 100;
     }
-    return (uint8_t)((ecg_upload_read_idx * 100) / ecg_upload_write_idx);
+    return (uint8_t)(((ecg_upload_ring.tail - ecg_upload_begin) * 100) / total);
 }
 
 /**
@@ -348,7 +615,7 @@ uint8_t ECG_GetUploadProgress(void)
   */
 uint8_t ECG_IsUploadComplete(void)
 {
-    return !ecg_upload_active;
+    return ecg_upload_mode == ECG_UPLOAD_IDLE;
 }
 
 #endif
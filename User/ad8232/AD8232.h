@@ -9,17 +9,24 @@
 #define __AD8232_H
 
 #include "stdint.h"
+#include "kconfig.h"
+#include "module/ring/ring.h"
 
 /*============================ 外部变量 ============================*/
 extern uint16_t ecg_data[500];      /**< ECG数据缓冲区 */
 extern uint16_t map_upload[130];    /**< 上传数据缓冲区 */
 extern uint16_t ecg_index;          /**< ECG数据索引 */
 extern uint16_t test;               /**< 测试计数器 */
+extern Ring_t   ecg_draw_ring;      /**< 绘图队列（overrun: 溢出丢点数） */
 
 /* ECG上传相关 */
-extern uint16_t ecg_upload_buffer[];     /**< ECG上传缓存 */
-extern uint16_t ecg_upload_write_idx;    /**< 写入索引 */
-extern uint8_t  ecg_upload_active;       /**< 上传进行中标志 */
+extern Ring_t   ecg_upload_ring;    /**< 上传队列（overrun: 上传中队列满丢弃的点数） */
+
+/*============================ 上传模式 ============================*/
+
+#define ECG_UPLOAD_IDLE     0   /**< 未上传，队列作为历史缓存 */
+#define ECG_UPLOAD_ONESHOT  1   /**< 单次上传最近3秒数据 */
+#define ECG_UPLOAD_STREAM   2   /**< 连续实时上传 */
 
 /*============================ 函数声明 ============================*/
 
@@ -35,18 +42,29 @@ void AD8232Init(void);
 uint8_t GetConnect(void);
 
 /**
- * @brief  获取心率值
- * @param  array: 数据数组
- * @param  length: 数组长度
- * @retval 心率值
+ * @brief  单个ECG采样点的滤波与缓存，缩放后放入绘图队列
+ * @param  adc_raw: ADC原始值 (0-4095)
  */
-uint8_t GetHeartRate(uint16_t *array, uint16_t length);
+void ECG_ProcessSample(uint16_t adc_raw);
 
 /**
- * @brief  ECG数据采集与绘制（在定时器中断中调用）
- * @note   采样率200Hz，每5ms调用一次
+ * @brief  处理一块ECG采样数据（在ADC DMA中断中调用）
+ * @param  samples: 采样数据
+ * @param  count: 采样点数
+ * @note   每块包含 ECG_SAMPLE_FREQ / ECG_BLOCK_FREQ 个点
  */
-void ECG_SampleAndDraw(void);
+void ECG_ProcessBlock(const uint16_t *samples, uint16_t count);
+
+/**
+ * @brief  ECG波形渲染（主循环按 ECG_RENDER_FPS 调用）
+ * @note   将队列中的新点画入显存，不发送到屏幕
+ */
+void ECG_Render(void);
+
+/**
+ * @brief  ECG渲染状态复位（进入心电图页面时调用）
+ */
+void ECG_RenderReset(void);
 
 /**
  * @brief  ECG显示区域清除并重绘坐标轴
@@ -70,22 +88,52 @@ void ChartOptimize(uint16_t *R, uint16_t *Chart);
 /*============================ ECG上传接口 ============================*/
 
 /**
- * @brief  开始ECG数据上传
- * @param  timestamp: 数据起始时间戳
+ * @brief  开始单次ECG上传（最近3秒数据）
+ */
+void ECG_StartUpload(void);
+
+/**
+ * @brief  开始连续ECG上传
  */
-void ECG_StartUpload(uint32_t timestamp);
+void ECG_StartStream(void);
 
 /**
  * @brief  停止ECG数据上传
  */
 void ECG_StopUpload(void);
 
+/**
+ * @brief  获取当前上传模式
+ * @retval ECG_UPLOAD_IDLE / ECG_UPLOAD_ONESHOT / ECG_UPLOAD_STREAM
+ */
+uint8_t ECG_GetUploadMode(void);
+
 /**
  * @brief  获取待上传的数据量
- * @retval 缓存中的数据点数
+ * @retval 队列中尚未取出的数据点数
  */
 uint16_t ECG_GetUploadDataCount(void);
 
+/**
+ * @brief  获取下一个待上传点的序号
+ * @retval 自采集开始的采样点序号（含上传中丢弃的点）
+ */
+uint32_t ECG_GetUploadPosition(void);
+
+/**
+ * @brief  读取一批ECG数据用于上传，不取出
+ * @param  batch_data: 输出缓冲区
+ * @param  batch_size: 请求的批次大小
+ * @retval 读到的数据点数，一批不跨越丢点缺口
+ */
+uint16_t ECG_PeekUploadBatch(uint16_t *batch_data, uint16_t batch_size);
+
+/**
+ * @brief  取出已发送的点
+ * @param  count: ECG_PeekUploadBatch 读到的点数
+ */
+void ECG_ConsumeUpload(uint16_t count);
+
 /**
  * @brief  获取一批ECG数据用于上传
  * @param  batch_data: 输出缓冲区
@@ -0,0 +1,388 @@
+/**
+  ******************************************************************************
+  * @file    ecg_qrs.c
+  * @brief   ECG实时QRS检测（Pan-Tompkins）
+  *
+  * @details 原 GetHeartRate() 在缩放后的显示数组中找两个低于固定像素值的
+  *          局部极值，返回的是点数间隔而非心率，也没有接入采集流程。
+  *          现逐点处理原始采样，全部整数运算:
+  *
+  *          原始 ──> 低通 ──> 高通 ──> 微分 ──> 平方 ──> 滑动积分(150ms)
+  *                          │                                 │
+  *                          └─[带通缓存]      积分峰值 <─────┘
+  *                                 │              │ 与自适应阈值比较
+  *                                 └── 回溯找R波 <┘
+  *
+  *          - 低通/高通为Pan-Tompkins原始的整数系数滤波器，
+  *            延时按毫秒换算，ECG_SAMPLE_FREQ为200/500/1000均适用
+  *          - 信号/噪声峰值估计 SPKI/NPKI，阈值 THR1 = NPKI + (SPKI-NPKI)/4
+  *          - 200ms不应期；超过平均RR的166%未检出时，以 THR1/2 回溯
+  *          - R波时刻为积分窗内带通绝对值最大点，扣除滤波器群延时
+  ******************************************************************************
+  */
+
+#include "ecg_qrs.h"
+
+/*============================ 宏定义 ============================*/
+
+#define QRS_MS(ms)          ((uint32_t)(ms) * ECG_SAMPLE_FREQ / 1000)  /**< 毫秒换算为点数 */
+
+#define QRS_LP_D            QRS_MS(30)      /**< 低通零点间隔（200Hz时6点） */
+#define QRS_LP_GAIN         (QRS_LP_D * QRS_LP_D)
+#define QRS_HP_M            QRS_MS(160)     /**< 高通平均长度（200Hz时32点） */
+#define QRS_DER_K           ((QRS_MS(5) > 0) ? QRS_MS(5) : 1)  /**< 微分步长 */
+#define QRS_MWI_W           QRS_MS(150)     /**< 滑动积分窗口 */
+
+#define QRS_DELAY           (QRS_LP_D - 1 + QRS_HP_M / 2)  /**< 带通相对原始信号的群延时 */
+#define QRS_SEARCH_LEN      (QRS_MWI_W + 2 * QRS_DER_K)     /**< 回溯R波的范围 */
+
+#define QRS_LEARN_LEN       QRS_MS(2000)    /**< 初始阈值学习时长 */
+#define QRS_REFRACTORY      QRS_MS(200)     /**< 不应期 */
+#define QRS_RR_MIN          QRS_MS(250)     /**< 240bpm */
+#define QRS_RR_MAX          QRS_MS(2000)    /**< 30bpm */
+#define QRS_DER_LIMIT       4095            /**< 微分限幅，平方和不溢出 */
+
+#define QRS_RR_NUMS         8               /**< RR间期平均个数 */
+
+/* 各缓存长度（2的幂） */
+#if (ECG_SAMPLE_FREQ <= 200)
+#define QRS_RAW_SIZE        16
+#define QRS_LP_SIZE         64
+#define QRS_HP_SIZE         64
+#define QRS_SQ_SIZE         32
+#elif (ECG_SAMPLE_FREQ <= 500)
+#define QRS_RAW_SIZE        32
+#define QRS_LP_SIZE         128
+#define QRS_HP_SIZE         128
+#define QRS_SQ_SIZE         128
+#elif (ECG_SAMPLE_FREQ <= 1000)
+#define QRS_RAW_SIZE        64
+#define QRS_LP_SIZE         256
+#define QRS_HP_SIZE         256
+#define QRS_SQ_SIZE         256
+#else
+#error "ECG_SAMPLE_FREQ above 1000Hz is not supported by ecg_qrs.c"
+#endif
+
+#define QRS_RAW_MASK        (QRS_RAW_SIZE - 1)
+#define QRS_LP_MASK         (QRS_LP_SIZE - 1)
+#define QRS_HP_MASK         (QRS_HP_SIZE - 1)
+#define QRS_SQ_MASK         (QRS_SQ_SIZE - 1)
+
+/*============================ 私有变量 ============================*/
+
+static uint32_t qrs_n = 0;                  /**< 采样点序号 */
+
+/* 滤波器状态 */
+static uint16_t qrs_raw[QRS_RAW_SIZE];      /**< 原始采样 */
+static int32_t  qrs_lp_y1 = 0;              /**< 低通 y(n-1)，未除增益 */
+static int32_t  qrs_lp_y2 = 0;              /**< 低通 y(n-2) */
+static int16_t  qrs_lp[QRS_LP_SIZE];        /**< 低通输出 */
+static int32_t  qrs_hp_sum = 0;             /**< 高通滑动和 */
+static int16_t  qrs_hp[QRS_HP_SIZE];        /**< 带通输出 */
+static uint32_t qrs_sq[QRS_SQ_SIZE];        /**< 微分平方 */
+static uint32_t qrs_mwi_sum = 0;            /**< 滑动积分和 */
+static uint32_t qrs_mwi_prev = 0;           /**< 上一点积分值 */
+static uint8_t  qrs_rising = 0;             /**< 积分值正在上升 */
+
+/* 阈值 */
+static uint32_t qrs_spki = 0;               /**< 信号峰值估计 */
+static uint32_t qrs_npki = 0;               /**< 噪声峰值估计 */
+static uint32_t qrs_thr1 = 0;               /**< 主阈值 */
+static uint32_t qrs_learn_max = 0;          /**< 学习期最大峰值 */
+
+/* 检测结果 */
+static uint8_t  qrs_detected = 0;           /**< 已检出过QRS */
+static uint32_t qrs_last_peak = 0;          /**< 上次QRS的积分峰值位置（不应期） */
+static uint32_t qrs_last_r = 0;             /**< 上次R波位置 */
+static uint32_t qrs_sb_peak = 0;            /**< 回溯候选峰值，0表示无 */
+static uint32_t qrs_sb_pos = 0;             /**< 回溯候选积分峰值位置 */
+static uint32_t qrs_sb_r = 0;               /**< 回溯候选R波位置 */
+
+static uint16_t qrs_rr[QRS_RR_NUMS];        /**< 最近RR间期 */
+static uint32_t qrs_rr_sum = 0;
+static uint8_t  qrs_rr_head = 0;
+static uint8_t  qrs_rr_count = 0;
+static volatile uint16_t qrs_heart_rate = 0;
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  在积分窗内找R波
+  * @param  pos: 积分峰值位置
+  * @retval R波位置（原始信号时间轴）
+  * @note   每次确认或成为回溯候选时调用一次，不是每点执行
+  */
+static uint32_t ECG_QRS_LocateR(uint32_t pos)
+{
+    uint32_t i, best = pos;
+    int16_t v, best_v = -1;
+
+    for (i = 0; i < QRS_SEARCH_LEN; i++)
+    {
+        v = qrs_hp[(pos - i) & QRS_HP_MASK];
+        if (v < 0)
+        {
+            v = -v;
+        }
+        if (v > best_v)
+        {
+            best_v = v;
+            best = pos - i;
+        }
+    }
+
+    return best - QRS_DELAY;
+}
+
+/**
+  * @brief  确认一次QRS
+  * @param  pos: 积分峰值位置
+  * @param  r: R波位置
+  */
+static void ECG_QRS_Accept(uint32_t pos, uint32_t r)
+{
+    uint32_t rr = r - qrs_last_r;
+
+    if (qrs_detected)
+    {
+        if (rr > QRS_RR_MAX)
+        {
+            /* 间断过久，重新统计 */
+            qrs_rr_sum = 0;
+            qrs_rr_head = 0;
+            qrs_rr_count = 0;
+        }
+        else if (rr >= QRS_RR_MIN)
+        {
+            if (qrs_rr_count < QRS_RR_NUMS)
+            {
+                qrs_rr_count++;
+            }
+            else
+            {
+                qrs_rr_sum -= qrs_rr[qrs_rr_head];
+            }
+            qrs_rr[qrs_rr_head] = (uint16_t)rr;
+            qrs_rr_sum += rr;
+            qrs_rr_head = (qrs_rr_head + 1) & (QRS_RR_NUMS - 1);
+        }
+    }
+
+    if (qrs_rr_count > 0)
+    {
+        qrs_heart_rate = (uint16_t)((60UL * ECG_SAMPLE_FREQ * qrs_rr_count + qrs_rr_sum / 2) / qrs_rr_sum);
+    }
+
+    qrs_detected = 1;
+    qrs_last_peak = pos;
+    qrs_last_r = r;
+    qrs_sb_peak = 0;
+}
+
+/**
+  * @brief  更新阈值
+  */
+static void ECG_QRS_UpdateThreshold(void)
+{
+    qrs_thr1 = qrs_npki + (qrs_spki - qrs_npki) / 4;
+}
+
+/**
+  * @brief  处理一个积分峰值
+  * @param  peak: 峰值
+  * @param  pos: 峰值位置
+  * @retval 1: 确认为QRS
+  */
+static uint8_t ECG_QRS_OnPeak(uint32_t peak, uint32_t pos)
+{
+    /* 学习期: 记录最大峰值 */
+    if (pos < QRS_LEARN_LEN)
+    {
+        if (peak > qrs_learn_max)
+        {
+            qrs_learn_max = peak;
+        }
+        return 0;
+    }
+
+    if (qrs_detected && (pos - qrs_last_peak) < QRS_REFRACTORY)
+    {
+        return 0;
+    }
+
+    if (peak > qrs_thr1)
+    {
+        qrs_spki = (peak + 7 * qrs_spki) / 8;
+        ECG_QRS_UpdateThreshold();
+        ECG_QRS_Accept(pos, ECG_QRS_LocateR(pos));
+        return 1;
+    }
+
+    qrs_npki = (peak + 7 * qrs_npki) / 8;
+    ECG_QRS_UpdateThreshold();
+
+    /* 超过次阈值的最大噪声峰留作回溯候选 */
+    if (peak > qrs_thr1 / 2 && peak > qrs_sb_peak)
+    {
+        qrs_sb_peak = peak;
+        qrs_sb_pos = pos;
+        qrs_sb_r = ECG_QRS_LocateR(pos);
+    }
+
+    return 0;
+}
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  QRS检测复位
+  */
+void ECG_QRS_Reset(void)
+{
+    uint16_t i;
+
+    qrs_n = 0;
+    for (i = 0; i < QRS_RAW_SIZE; i++)
+    {
+        qrs_raw[i] = 2048;
+    }
+    for (i = 0; i < QRS_LP_SIZE; i++)
+    {
+        qrs_lp[i] = 0;
+    }
+    for (i = 0; i < QRS_HP_SIZE; i++)
+    {
+        qrs_hp[i] = 0;
+    }
+    for (i = 0; i < QRS_SQ_SIZE; i++)
+    {
+        qrs_sq[i] = 0;
+    }
+    qrs_lp_y1 = qrs_lp_y2 = 2048 * (int32_t)QRS_LP_GAIN;   /* 与原始缓存的初值一致 */
+    qrs_hp_sum = 0;
+    qrs_mwi_sum = 0;
+    qrs_mwi_prev = 0;
+    qrs_rising = 0;
+
+    qrs_spki = qrs_npki = qrs_thr1 = 0;
+    qrs_learn_max = 0;
+
+    qrs_detected = 0;
+    qrs_sb_peak = 0;
+    qrs_rr_sum = 0;
+    qrs_rr_head = 0;
+    qrs_rr_count = 0;
+    qrs_heart_rate = 0;
+}
+
+/**
+  * @brief  输入一个ECG采样点
+  * @param  sample: ADC原始值 (0-4095)
+  * @retval 1: 本点确认了一次QRS; 0: 无
+  */
+uint8_t ECG_QRS_Process(uint16_t sample)
+{
+    uint32_t n = qrs_n;
+    int32_t lp_y, lp, hp, der;
+    uint32_t sq, mwi;
+    uint8_t beat = 0;
+
+    /* 1. 低通 y(n) = 2y(n-1) - y(n-2) + x(n) - 2x(n-D) + x(n-2D)
+     *    整数运算精确，递推不会累积误差；除以增益后减去ADC中点 */
+    qrs_raw[n & QRS_RAW_MASK] = sample;
+    lp_y = 2 * qrs_lp_y1 - qrs_lp_y2
+         + (int32_t)sample
+         - 2 * (int32_t)qrs_raw[(n - QRS_LP_D) & QRS_RAW_MASK]
+         + (int32_t)qrs_raw[(n - 2 * QRS_LP_D) & QRS_RAW_MASK];
+    qrs_lp_y2 = qrs_lp_y1;
+    qrs_lp_y1 = lp_y;
+    lp = lp_y / (int32_t)QRS_LP_GAIN - 2048;
+    qrs_lp[n & QRS_LP_MASK] = (int16_t)lp;
+
+    /* 2. 高通: 全通延时减去M点均值 */
+    qrs_hp_sum += lp - qrs_lp[(n - QRS_HP_M) & QRS_LP_MASK];
+    hp = qrs_lp[(n - QRS_HP_M / 2) & QRS_LP_MASK] - qrs_hp_sum / (int32_t)QRS_HP_M;
+    qrs_hp[n & QRS_HP_MASK] = (int16_t)hp;
+
+    /* 3. 五点微分 */
+    der = (2 * hp
+         + qrs_hp[(n - QRS_DER_K) & QRS_HP_MASK]
+         - qrs_hp[(n - 3 * QRS_DER_K) & QRS_HP_MASK]
+         - 2 * qrs_hp[(n - 4 * QRS_DER_K) & QRS_HP_MASK]) / 8;
+    if (der > QRS_DER_LIMIT)
+    {
+        der = QRS_DER_LIMIT;
+    }
+    else if (der < -QRS_DER_LIMIT)
+    {
+        der = -QRS_DER_LIMIT;
+    }
+
+    /* 4. 平方与滑动积分 */
+    sq = (uint32_t)(der * der);
+    qrs_mwi_sum += sq - qrs_sq[(n - QRS_MWI_W) & QRS_SQ_MASK];
+    qrs_sq[n & QRS_SQ_MASK] = sq;
+    mwi = qrs_mwi_sum / QRS_MWI_W;
+
+    /* 5. 积分峰值检测（滤波器建立之前不检测） */
+    if (n > QRS_HP_M + QRS_MWI_W)
+    {
+        if (mwi > qrs_mwi_prev)
+        {
+            qrs_rising = 1;
+        }
+        else if (mwi < qrs_mwi_prev && qrs_rising)
+        {
+            qrs_rising = 0;
+            beat = ECG_QRS_OnPeak(qrs_mwi_prev, n - 1);
+        }
+    }
+    qrs_mwi_prev = mwi;
+
+    /* 学习期结束，设置初始阈值 */
+    if (n == QRS_LEARN_LEN)
+    {
+        qrs_spki = qrs_learn_max / 2;
+        qrs_npki = qrs_learn_max / 8;
+        ECG_QRS_UpdateThreshold();
+    }
+
+    /* 6. 超过平均RR的166%未检出，回溯次阈值候选 */
+    if (!beat && qrs_rr_count > 0 && qrs_sb_peak > 0 &&
+        (n - qrs_last_peak) * qrs_rr_count > qrs_rr_sum * 166 / 100)
+    {
+        qrs_spki = (qrs_sb_peak + 3 * qrs_spki) / 4;
+        ECG_QRS_UpdateThreshold();
+        ECG_QRS_Accept(qrs_sb_pos, qrs_sb_r);
+        beat = 1;
+    }
+
+    /* 长时间无心跳，心率清零 */
+    if (qrs_detected && (n - qrs_last_peak) > QRS_RR_MAX)
+    {
+        qrs_heart_rate = 0;
+    }
+
+    qrs_n = n + 1;
+
+    return beat;
+}
+
+/**
+  * @brief  获取最近一次R波的采样点序号
+  * @retval 自复位起的采样点序号
+  */
+uint32_t ECG_QRS_GetLastR(void)
+{
+    return qrs_last_r;
+}
+
+/**
+  * @brief  获取ECG心率
+  * @retval 心率 (bpm)，未检测到或超过2秒无心跳时为0
+  */
+uint16_t ECG_QRS_GetHeartRate(void)
+{
+    return qrs_heart_rate;
+}
@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * @file    ecg_qrs.h
+  * @brief   ECG实时QRS检测头文件（Pan-Tompkins）
+  ******************************************************************************
+  */
+
+#ifndef __ECG_QRS_H
+#define __ECG_QRS_H
+
+#include "stdint.h"
+#include "kconfig.h"
+
+/*============================ 函数声明 ============================*/
+
+/**
+  * @brief  QRS检测复位（采集中断后重新开始时调用）
+  * @note   复位后先学习2秒确定初始阈值
+  */
+void ECG_QRS_Reset(void);
+
+/**
+  * @brief  输入一个ECG采样点
+  * @param  sample: ADC原始值 (0-4095)
+  * @retval 1: 本点确认了一次QRS，R波时刻和心率已更新; 0: 无
+  * @note   在ADC DMA中断中逐点调用，整数运算，每点耗时固定
+  */
+uint8_t ECG_QRS_Process(uint16_t sample);
+
+/**
+  * @brief  获取最近一次R波的采样点序号
+  * @retval 自复位起的采样点序号
+  */
+uint32_t ECG_QRS_GetLastR(void);
+
+/**
+  * @brief  获取ECG心率
+  * @retval 心率 (bpm)，最近8个RR间期平均；未检测到或超过2秒无心跳时为0
+  */
+uint16_t ECG_QRS_GetHeartRate(void);
+
+#endif
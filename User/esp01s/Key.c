@@ -5,8 +5,15 @@
   * 
   * @details 按键功能:
   *          - Key1 (PB12): 上一页
-  *          - Key2 (PB13): 功能键（上传心电数据）
+  *          - Key2 (PB13): 功能键（短按单次上传心电数据，长按开关连续上传）
   *          - Key3 (PB14): 下一页
+  *
+  *          扫描与处理分离:
+  *
+  *          TIM3 100Hz中断: Key_Scan() 消抖、计时 --键码--> [ key_ring ] --Key_GetNum()--> 主循环
+  *
+  *          主循环不再等待松手，按键期间ECG绘图和上传不受影响；
+  *          主循环卡顿时按键留在队列中，不会丢失
   ******************************************************************************
   */
 
@@ -17,13 +24,34 @@
 #include "stm32f10x_gpio.h"
 
 #include "key.h"
-#include "Timer2.h"
 #include "esp8266.h"
 #include "oled.h"
+#include "module/transmit/transmit.h"
+#ifdef ENABLE_IRQ_STAT
+#include "module/irqstat/irqstat.h"
+#endif
 
 /*============================ 全局变量 ============================*/
 
 uint8_t current_page = PAGE_HEARTRATE;  /**< 当前页面，默认心率页面 */
+
+/** @brief 键码队列（扫描中断写入，主循环取出；overrun为主循环来不及处理丢弃的按键数） */
+Ring_t key_ring;
+
+/*============================ 私有变量 ============================*/
+
+#define KEY_RING_SIZE       8       /**< 键码队列长度（必须为2的幂） */
+#define KEY_LONG_PRESS_TICKS (KEY_LONG_PRESS_MS * SCHED_BASE_FREQ / 1000)  /**< 长按判定扫描次数 */
+
+#define KEY1_BIT            0x01
+#define KEY2_BIT            0x02
+#define KEY3_BIT            0x04
+
+static uint8_t  key_ring_buf[KEY_RING_SIZE];  /**< 键码队列存储区 */
+static uint8_t  key_last_raw = 0;       /**< 上一次扫描的引脚状态 */
+static uint8_t  key_stable = 0;         /**< 消抖后的按下状态 */
+static uint16_t key2_hold = 0;          /**< Key2按住的扫描次数 */
+
 /*============================ 函数实现 ============================*/
 
 /**
@@ -43,38 +71,91 @@ void Key_Init(void)
     GPIO_InitStructure.GPIO_Pin = GPIO_Pin_12 | GPIO_Pin_13 | GPIO_Pin_14;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
     GPIO_Init(GPIOB, &GPIO_InitStructure);
+    
+    Ring_Init(&key_ring, key_ring_buf, sizeof(key_ring_buf[0]), KEY_RING_SIZE);
 }
 
 /**
-  * @brief  按键扫描获取键码
-  * @param  无
-  * @retval 按下按键的键码值: 0=无按键, 1=Key1, 2=Key2, 3=Key3
-  * @note   此函数是阻塞式操作，按键按住不放时会等待松手
+  * @brief  读取按键引脚
+  * @retval 按下的按键位图: bit0=Key1, bit1=Key2, bit2=Key3
   */
-uint8_t Key_GetNum(void)
+static uint8_t Key_ReadPins(void)
 {
-    uint8_t KeyNum = 0;
+    uint8_t pins = 0;
+    
+    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_12) == 0) pins |= KEY1_BIT;
+    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_13) == 0) pins |= KEY2_BIT;
+    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_14) == 0) pins |= KEY3_BIT;
+    
+    return pins;
+}
+
+/**
+  * @brief  放入一个键码
+  * @param  code: 键码
+  */
+static void Key_Post(uint8_t code)
+{
+    Ring_Put(&key_ring, &code);
+}
+
+/**
+  * @brief  按键扫描（TIM3中断中以 SCHED_BASE_FREQ 调用）
+  * @note   连续两次读数相同才认为状态稳定（消抖10ms）:
+  *         - Key1/Key3 松手时放入键码
+  *         - Key2 按住满 KEY_LONG_PRESS_MS 时立即放入长按键码，松手不再放入；
+  *           未满则松手时放入短按键码
+  */
+void Key_Scan(void)
+{
+    uint8_t pins = Key_ReadPins();
+    uint8_t released;
     
-    /* Key1: PB12 */
-    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_12) == 0)
+    if (pins != key_last_raw)
     {
-        while (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_12) == 0);  /* 等待松手 */
-        KeyNum = 1;
+        key_last_raw = pins;  /* 抖动中，等待稳定 */
+        return;
     }
+    released = key_stable & (uint8_t)~pins;
+    key_stable = pins;
     
-    /* Key2: PB13 */
-    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_13) == 0)
+    if (released & KEY1_BIT)
     {
-        while (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_13) == 0);  /* 等待松手 */
-        KeyNum = 2;
+        Key_Post(1);
+    }
+    if (released & KEY3_BIT)
+    {
+        Key_Post(3);
     }
     
-    /* Key3: PB14 */
-    if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_14) == 0)
+    if (pins & KEY2_BIT)
+    {
+        if (key2_hold < KEY_LONG_PRESS_TICKS && ++key2_hold == KEY_LONG_PRESS_TICKS)
+        {
+            Key_Post(KEY2_LONG);
+        }
+    }
+    else if (released & KEY2_BIT)
     {
-        while (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_14) == 0);  /* 等待松手 */
-        KeyNum = 3;
+        if (key2_hold < KEY_LONG_PRESS_TICKS)
+        {
+            Key_Post(2);
+        }
+        key2_hold = 0;
     }
+}
+
+/**
+  * @brief  取出一个键码
+  * @param  无
+  * @retval 按键的键码值: 0=无按键, 1=Key1, 2=Key2, 3=Key3, 4=Key2长按
+  * @note   非阻塞，键码由 Key_Scan 在中断中放入
+  */
+uint8_t Key_GetNum(void)
+{
+    uint8_t KeyNum = 0;
+    
+    Ring_Get(&key_ring, &KeyNum);
     
     return KeyNum;
 }
@@ -110,13 +191,28 @@ void Key_Process(void)
             OLED_Clear();  /* 清屏准备显示新页面 */
             break;
             
-        case 2:  /* Key2: 功能键 - 上传心电数据 */
+        case 2:  /* Key2: 功能键 - 上传最近3秒心电数据 */
+            if (current_page == PAGE_ECG)
+            {
+                Transmit_StartECGUpload();
+            }
+#ifdef ENABLE_IRQ_STAT
+            else if (current_page == PAGE_IRQ)
+            {
+                /* 中断统计: 经调试串口输出后清零，无串口输出时直接清零 */
+#if defined(ENABLE_UART_DEBUG) && !defined(ENABLE_TRACE_RECORD)
+                IrqStat_RequestReport();
+#else
+                IrqStat_Reset();
+#endif
+            }
+#endif
+            break;
+            
+        case KEY2_LONG:  /* Key2长按: 开关连续上传 */
             if (current_page == PAGE_ECG)
             {
-                /* 开始ECG批量上传（使用当前秒数作为时间戳） */
-                extern uint16_t test;  /* 秒计数器 */
-                extern void Transmit_StartECGUpload(uint32_t timestamp);
-                Transmit_StartECGUpload(test);
+                Transmit_ToggleECGStream();
             }
             break;
             
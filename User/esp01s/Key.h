@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include "kconfig.h"  /* 全局配置（包含 ENABLE_DEBUG_PAGE 等宏定义） */
+#include "module/ring/ring.h"
 
 /*============================ 页面定义 ============================*/
 
@@ -18,18 +19,37 @@
 
 #ifdef ENABLE_DEBUG_PAGE
 #define PAGE_DEBUG        2     /**< 页面2: 调试页面 */
-#define PAGE_MAX          3     /**< 总页面数（含调试页面）*/
+#define PAGE_TASKS        3     /**< 页面3: 任务统计页面 */
+#ifdef ENABLE_IRQ_STAT
+#define PAGE_IRQ          4     /**< 页面4: 中断统计页面 */
+#define PAGE_MAX          5     /**< 总页面数（含调试和中断统计页面）*/
+#define PAGE_MAX_STR      "5"
 #else
+#define PAGE_MAX          4     /**< 总页面数（含调试页面）*/
+#define PAGE_MAX_STR      "4"
+#endif
+#else
+#if defined(ENABLE_IRQ_STAT)
+#error "ENABLE_IRQ_STAT requires ENABLE_DEBUG_PAGE"
+#endif
 #define PAGE_MAX          2     /**< 总页面数（不含调试页面）*/
+#define PAGE_MAX_STR      "2"
 #endif
 
+/*============================ 键码定义 ============================*/
+
+#define KEY2_LONG         4     /**< Key2长按键码 */
+#define KEY_LONG_PRESS_MS 1000  /**< 长按判定时间 (ms) */
+
 /*============================ 外部变量 ============================*/
 
 extern uint8_t current_page;    /**< 当前页面索引 */
+extern Ring_t  key_ring;        /**< 键码队列（overrun: 丢弃的按键数） */
 
 /*============================ 函数声明 ============================*/
 
 void Key_Init(void);
+void Key_Scan(void);
 uint8_t Key_GetNum(void);
 void Key_Process(void);
 
@@ -8,6 +8,13 @@
   *          - MQTT协议连接服务器（支持阿里云IoT/自建服务器）
   *          - 传感器数据上传与服务器指令接收
   * 
+  *          AT指令由非阻塞引擎执行，主循环周期调用 ESP8266_Process():
+  * 
+  *          指令队列 ──> 发送 ──> 等待应答 ──成功──> 完成后等待 ──> 下一条
+  *                                  │ 超时/ERROR
+  *                                  └──> 重试，次数用完则退避后重新连接
+  * 
+  *          上电后即开始测量，WiFi/MQTT连接和断线重连都在后台完成
   * @note    在esp8266.h中设置 MQTT_USE_ALIYUN 选择服务器模式：
   *          - 0: 自建MQTT服务器 (Mosquitto/EMQX等)
   *          - 1: 阿里云IoT平台
@@ -20,18 +27,86 @@
 #include "stm32f10x_rcc.h"
 #include "esp8266.h"
 #include "usart2.h"
+#include "timer2.h"
 #include "string.h"
 #include "stdint.h"
 #include "stdio.h"
+#include "stdarg.h"
 
 /*============================ 宏定义 ============================*/
 
 #undef USE_HAL_DRIVER  /* 禁用HAL库 */
 
+#define ESP8266_AT_QUEUE_SIZE   8       /**< AT指令队列长度 */
+#define ESP8266_TICKS_PER_MS    (TIM3_COUNTER_FREQ / 1000)
+
+#define ESP8266_BOOT_DELAY_MS   2000    /**< 上电后等待模块启动 */
+#define ESP8266_BACKOFF_MS      10000   /**< 连接失败后重新连接的等待时间 */
+
+#define ESP8266_ECG_PUB_LEN     200     /**< ECG帧发布指令缓冲区长度 */
+#define ESP8266_PUB_LEN         112     /**< 数值/报警发布指令缓冲区长度 */
+
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  AT引擎状态
+  */
+typedef enum
+{
+    AT_STATE_IDLE = 0,      /**< 空闲，可发送下一条 */
+    AT_STATE_SEND,          /**< 串口发送队列已满，等待重新发送当前指令 */
+    AT_STATE_WAIT_ACK,      /**< 已发送，等待应答 */
+    AT_STATE_DELAY          /**< 已完成，等待完成后延时 */
+} ESP8266_AtState_t;
+
 /*============================ 全局变量 ============================*/
 
 unsigned char Property_Data[5];  /**< 云端属性数据缓冲区 */
 
+/*============================ 私有变量 ============================*/
+
+static const char *esp8266_watch_property = NULL;  /**< 关注的云端属性名称 */
+
+/* AT指令队列 */
+static ESP8266_AtCmd_t at_queue[ESP8266_AT_QUEUE_SIZE];
+static uint8_t at_head = 0;                     /**< 入队位置 */
+static uint8_t at_tail = 0;                     /**< 当前指令位置 */
+static ESP8266_AtState_t at_state = AT_STATE_IDLE;
+static uint8_t  at_attempt = 0;                 /**< 当前指令已重试次数 */
+static uint32_t at_start_tick = 0;              /**< 当前状态开始时刻 (10us) */
+
+/* 发布指令缓冲，与队列位置一一对应，指令出队前保持有效 */
+static char at_pub_buf[ESP8266_AT_QUEUE_SIZE][ESP8266_PUB_LEN];
+
+/* 连接状态 */
+static ESP8266_Link_t link_state = ESP8266_LINK_BOOT;
+static uint32_t link_tick = 0;                  /**< 连接状态开始时刻 (10us) */
+
+uint32_t esp8266_reconnect_count = 0;           /**< 重新连接次数 */
+uint32_t esp8266_publish_drop = 0;              /**< 未连接或队列已满时被丢弃的发布次数 */
+
+/**
+  * @brief  WiFi/MQTT连接脚本
+  * @note   从头执行为完整连接；WiFi断开从入网开始，MQTT断开从MQTT配置开始
+  */
+static const ESP8266_AtCmd_t esp8266_connect_script[] =
+{
+    /* 指令                                                应答      超时ms 重试 可失败 完成后等待ms */
+    { "AT",                                                "OK",     500,   3,   0,     0    },
+    { "AT+CWMODE=1",                                       "OK",     500,   1,   0,     0    },
+    { "AT+RST",                                            "ready",  2000,  0,   1,     2000 },
+    { "AT+CWJAP=\"" WIFI_NAME "\",\"" WIFI_PASSWORD "\"", "GOT IP", 15000, 0,   0,     2000 },
+    { MQTT_USERCFG,                                        "OK",     1000,  1,   0,     0    },
+#if (MQTT_USE_ALIYUN == 1)
+    { MQTT_CLIENTID,                                       "OK",     1000,  1,   0,     0    },
+#endif
+    { MQTT_CONN,                                           "OK",     3000,  1,   0,     0    },
+};
+
+#define ESP8266_SCRIPT_LEN      (sizeof(esp8266_connect_script) / sizeof(esp8266_connect_script[0]))
+#define ESP8266_SCRIPT_WIFI     3   /**< 入网步骤位置 */
+#define ESP8266_SCRIPT_MQTT     4   /**< MQTT配置步骤位置 */
+
 /*============================ 私有函数 ============================*/
 
 /**
@@ -53,52 +128,360 @@ static void delay_ms(uint16_t ms)
     SysTick->CTRL = 0;  /* 关闭定时器 */
 }
 
+/**
+  * @brief  处理一行非应答数据
+  * @param  line: 行切片
+  * @note   无论哪个函数取出了下发数据所在的行，都在这里解析，
+  *         保证等待应答期间到达的云端下发数据不会丢失
+  *         
+  *         示例：收到 {"Property":123}
+  *         解析后 Property_Data = "123"
+  */
+static void ESP8266_HandleLine(const USART2_Line_t *line)
+{
+    int16_t pos;
+    uint16_t idx, total;
+    uint8_t i, c;
+    
+    if (esp8266_watch_property == NULL)
+    {
+        return;
+    }
+    
+    pos = USART2_LineFind(line, esp8266_watch_property);
+    if (pos < 0)
+    {
+        return;
+    }
+    
+    /* 提取属性值（数字部分） */
+    total = line->len1 + line->len2;
+    for (i = 0; i < 5; i++)
+    {
+        idx = pos + 13 + i;
+        if (idx >= total)
+        {
+            break;
+        }
+        c = USART2_LineAt(line, idx);
+        if ((c >= '0' && c <= '9') || (c == '}'))
+        {
+            Property_Data[i] = c;
+        }
+    }
+}
+
 /*============================ 公共函数 ============================*/
 
 /**
   * @brief  ESP8266模块初始化
-  * @note   初始化流程：
-  *         1. 测试AT通信
-  *         2. 设置Station模式
+  * @note   不阻塞，仅复位连接状态；连接流程由ESP8266_Process在后台执行：
+  *         1. 等待模块启动，测试AT通信
+  *         2. 设置Station模式并软复位
   *         3. 连接WiFi路由器
   *         4. 配置MQTT并连接服务器
   */
 void ESP8266_Init(void)
 {
-    uint8_t retry;
+    at_head = 0;
+    at_tail = 0;
+    at_state = AT_STATE_IDLE;
     
-    /* 等待模块启动 */
-    delay_ms(2000);
+    link_state = ESP8266_LINK_BOOT;
+    link_tick = Timer3_GetTick();
+}
+
+/*============================ AT指令引擎 ============================*/
+
+/**
+  * @brief  判断从start开始是否已经过ms毫秒
+  */
+static uint8_t ESP8266_Elapsed(uint32_t start, uint32_t ms)
+{
+    return (uint32_t)(Timer3_GetTick() - start) >= ms * ESP8266_TICKS_PER_MS;
+}
+
+/**
+  * @brief  AT指令入队
+  * @param  cmd: 指令描述，字符串须在指令执行完成前保持有效
+  * @retval 0: 成功, 1: 队列已满
+  */
+uint8_t ESP8266_AT_Submit(const ESP8266_AtCmd_t *cmd)
+{
+    uint8_t next = (at_head + 1) % ESP8266_AT_QUEUE_SIZE;
     
-    /* 测试AT通信 */
-    for (retry = 0; retry < 3; retry++)
+    if (next == at_tail)
     {
-        if (esp8266_send_cmd("AT", "OK", 50) == 0)
-            break;
-        delay_ms(500);
+        return 1;
     }
+    at_queue[at_head] = *cmd;
+    at_head = next;
+    return 0;
+}
+
+/**
+  * @brief  AT指令队列是否为空闲
+  * @retval 1: 没有正在执行或排队的指令
+  */
+uint8_t ESP8266_AT_IsIdle(void)
+{
+    return (at_state == AT_STATE_IDLE) && (at_head == at_tail);
+}
+
+/**
+  * @brief  从连接脚本的第first步开始排队
+  */
+static void ESP8266_StartScript(uint8_t first)
+{
+    uint8_t i;
     
-    /* 设置WiFi工作模式为Station模式 */
-    esp8266_send_cmd("AT+CWMODE=1", "OK", 50);
+    at_head = 0;
+    at_tail = 0;
+    at_state = AT_STATE_IDLE;
     
-    /* 软复位模块 */
-    esp8266_send_cmd("AT+RST", "ready", 20);
-    delay_ms(2000);  /* 等待复位完成 */
+    for (i = first; i < ESP8266_SCRIPT_LEN; i++)
+    {
+        ESP8266_AT_Submit(&esp8266_connect_script[i]);
+    }
+    link_state = ESP8266_LINK_CONNECTING;
+}
+
+/**
+  * @brief  连接断开或失败，稍后从头重新连接
+  */
+static void ESP8266_LinkFailed(void)
+{
+    at_head = 0;
+    at_tail = 0;
+    at_state = AT_STATE_IDLE;
     
-    /* 连接WiFi路由器（必须！超时设为15秒）*/
-    esp8266_send_cmd("AT+CWJAP=\"" WIFI_NAME "\",\"" WIFI_PASSWORD "\"", "GOT IP", 1500);
-    delay_ms(2000);  /* 等待网络稳定 */
+    link_state = ESP8266_LINK_BACKOFF;
+    link_tick = Timer3_GetTick();
+}
+
+/**
+  * @brief  发送当前指令
+  * @note   串口发送队列放不下时进入 AT_STATE_SEND，之后每次处理时重发，
+  *         超过应答超时仍未发出按本次尝试失败处理
+  */
+static void ESP8266_AT_SendCurrent(void)
+{
+    const ESP8266_AtCmd_t *cur = &at_queue[at_tail];
     
-    /* 配置MQTT用户信息（必须在MQTTCONN之前！）*/
-    esp8266_send_cmd(MQTT_USERCFG, "OK", 100);
+    if (u2_printf("%s\r\n", cur->cmd) != 0)
+    {
+        if (at_state != AT_STATE_SEND)
+        {
+            at_state = AT_STATE_SEND;
+            at_start_tick = Timer3_GetTick();
+        }
+        return;
+    }
+    at_start_tick = Timer3_GetTick();
+    at_state = (cur->ack != NULL) ? AT_STATE_WAIT_ACK : AT_STATE_DELAY;
+}
+
+/**
+  * @brief  当前指令完成（成功或可忽略的失败）
+  */
+static void ESP8266_AT_Complete(void)
+{
+    at_state = AT_STATE_DELAY;
+    at_start_tick = Timer3_GetTick();
+}
+
+/**
+  * @brief  当前指令本次尝试失败
+  */
+static void ESP8266_AT_AttemptFailed(void)
+{
+    const ESP8266_AtCmd_t *cur = &at_queue[at_tail];
     
-#if (MQTT_USE_ALIYUN == 1)
-    /* 阿里云需要单独设置ClientID */
-    esp8266_send_cmd(MQTT_CLIENTID, "OK", 100);
-#endif
+    if (at_attempt < cur->retries)
+    {
+        at_attempt++;
+        at_state = AT_STATE_IDLE;
+        ESP8266_AT_SendCurrent();   /* 重试 */
+    }
+    else if (cur->optional)
+    {
+        ESP8266_AT_Complete();      /* 失败可忽略，继续后续指令 */
+    }
+    else
+    {
+        ESP8266_LinkFailed();
+    }
+}
+
+/**
+  * @brief  处理一行收到的数据
+  * @param  line: 行切片
+  */
+static void ESP8266_Dispatch(const USART2_Line_t *line)
+{
+    const ESP8266_AtCmd_t *cur = &at_queue[at_tail];
     
-    /* 连接MQTT服务器 */
-    esp8266_send_cmd(MQTT_CONN, "OK", 300);
+    if (at_state == AT_STATE_WAIT_ACK)
+    {
+        if (USART2_LineFind(line, cur->ack) >= 0)
+        {
+            ESP8266_AT_Complete();
+            return;
+        }
+        if (USART2_LineFind(line, "ERROR") >= 0 || USART2_LineFind(line, "FAIL") >= 0)
+        {
+            ESP8266_AT_AttemptFailed();
+            return;
+        }
+    }
+    
+    /* 已连接时检测断线（连接过程中模块也会输出这些信息，不处理） */
+    if (link_state == ESP8266_LINK_ONLINE)
+    {
+        if (USART2_LineFind(line, "WIFI DISCONNECT") >= 0)
+        {
+            esp8266_reconnect_count++;
+            ESP8266_StartScript(ESP8266_SCRIPT_WIFI);
+            return;
+        }
+        if (USART2_LineFind(line, "+MQTTDISCONNECTED") >= 0)
+        {
+            esp8266_reconnect_count++;
+            ESP8266_StartScript(ESP8266_SCRIPT_MQTT);
+            return;
+        }
+    }
+    
+    ESP8266_HandleLine(line);
+}
+
+/**
+  * @brief  ESP8266后台处理（在主循环中调用）
+  * @note   每次调用只做少量工作后返回：
+  *         处理收到的行 -> 检查超时/延时 -> 推进连接状态 -> 发送下一条指令
+  */
+void ESP8266_Process(void)
+{
+    USART2_Line_t line;
+    const ESP8266_AtCmd_t *cur;
+    
+    /* 1. 处理收到的所有行 */
+    while (USART2_ReadLine(&line))
+    {
+        ESP8266_Dispatch(&line);
+    }
+    
+    /* 2. 当前指令超时或延时结束 */
+    cur = &at_queue[at_tail];
+    if ((at_state == AT_STATE_WAIT_ACK || at_state == AT_STATE_SEND) &&
+        ESP8266_Elapsed(at_start_tick, cur->timeout_ms))
+    {
+        ESP8266_AT_AttemptFailed();
+    }
+    else if (at_state == AT_STATE_DELAY && ESP8266_Elapsed(at_start_tick, cur->delay_ms))
+    {
+        at_tail = (at_tail + 1) % ESP8266_AT_QUEUE_SIZE;
+        at_state = AT_STATE_IDLE;
+    }
+    
+    /* 3. 连接状态 */
+    switch (link_state)
+    {
+        case ESP8266_LINK_BOOT:
+            if (ESP8266_Elapsed(link_tick, ESP8266_BOOT_DELAY_MS))
+            {
+                ESP8266_StartScript(0);
+            }
+            break;
+            
+        case ESP8266_LINK_BACKOFF:
+            if (ESP8266_Elapsed(link_tick, ESP8266_BACKOFF_MS))
+            {
+                esp8266_reconnect_count++;
+                ESP8266_StartScript(0);
+            }
+            break;
+            
+        case ESP8266_LINK_CONNECTING:
+            if (ESP8266_AT_IsIdle())
+            {
+                link_state = ESP8266_LINK_ONLINE;  /* 脚本全部完成 */
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    /* 4. 重发串口队列放不下的指令，或发送下一条指令 */
+    if (at_state == AT_STATE_SEND)
+    {
+        ESP8266_AT_SendCurrent();
+    }
+    else if (at_state == AT_STATE_IDLE && at_head != at_tail)
+    {
+        at_attempt = 0;
+        ESP8266_AT_SendCurrent();
+    }
+}
+
+/**
+  * @brief  获取连接状态
+  */
+ESP8266_Link_t ESP8266_GetLink(void)
+{
+    return link_state;
+}
+
+/**
+  * @brief  是否可以立即发布
+  * @note   已连接且没有AT指令在执行时才发送，避免打断指令的应答
+  */
+uint8_t ESP8266_IsReady(void)
+{
+    return (link_state == ESP8266_LINK_ONLINE) && ESP8266_AT_IsIdle();
+}
+
+/**
+  * @brief  格式化一条发布指令并排队
+  * @param  fmt: 格式化字符串（不含\r\n）
+  * @retval 0: 已排队, 1: 未连接、队列已满或指令过长，已计入丢弃次数
+  * @note   与其他AT指令一样经队列发送，应答不会被误认为其他指令的应答；
+  *         指令写入与入队位置对应的缓冲，出队前不会被覆盖
+  *         QoS 1 需等待PUBACK后模块才回复OK，超时留足余量
+  */
+static uint8_t ESP8266_Publish(const char *fmt, ...)
+{
+    ESP8266_AtCmd_t cmd;
+    va_list ap;
+    char *buf;
+    int len;
+    
+    if (link_state != ESP8266_LINK_ONLINE ||
+        (at_head + 1) % ESP8266_AT_QUEUE_SIZE == at_tail)
+    {
+        esp8266_publish_drop++;
+        return 1;
+    }
+    
+    buf = at_pub_buf[at_head];
+    va_start(ap, fmt);
+    len = vsnprintf(buf, ESP8266_PUB_LEN, fmt, ap);
+    va_end(ap);
+    if (len < 0 || len >= ESP8266_PUB_LEN)
+    {
+        esp8266_publish_drop++;
+        return 1;
+    }
+    
+    cmd.cmd = buf;
+    cmd.ack = "OK";
+    cmd.timeout_ms = 2000;
+    cmd.retries = 0;
+    cmd.optional = 1;       /* 单条失败不影响连接 */
+    cmd.delay_ms = 0;
+    
+    return ESP8266_AT_Submit(&cmd);
 }
 
 /**
@@ -108,12 +491,18 @@ void ESP8266_Init(void)
   * @param  waittime: 等待超时时间（单位：10ms）
   * @retval 0: 发送成功（收到期望应答）
   * @retval 1: 发送失败（超时未收到应答）
+  * @note   阻塞等待，仅供调试使用；后台连接运行时请使用 ESP8266_AT_Submit
   */
 uint8_t esp8266_send_cmd(char *cmd, char *ack, uint16_t waittime)
 {
     uint8_t res = 1;  /* 默认失败 */
+    USART2_Line_t line;
     
-    USART2_RX_STA = 0;
+    /* 取出之前残留的行，避免误判为本条指令的应答 */
+    while (USART2_ReadLine(&line))
+    {
+        ESP8266_HandleLine(&line);
+    }
     u2_printf("%s\r\n", cmd);
     
     if (ack == NULL || waittime == 0)
@@ -124,14 +513,10 @@ uint8_t esp8266_send_cmd(char *cmd, char *ack, uint16_t waittime)
     while (waittime--)
     {
         delay_ms(10);
-        if (USART2_RX_STA & 0x8000)
+        if (esp8266_check_cmd(ack))
         {
-            if (esp8266_check_cmd(ack))
-            {
-                res = 0;  /* 收到期望应答，成功 */
-                break;
-            }
-            USART2_RX_STA = 0;  /* 清除后继续等待 */
+            res = 0;  /* 收到期望应答，成功 */
+            break;
         }
     }
     
@@ -143,18 +528,23 @@ uint8_t esp8266_send_cmd(char *cmd, char *ack, uint16_t waittime)
   * @param  str: 期望的应答字符串
   * @retval 0: 未找到期望字符串
   * @retval 1: 找到期望字符串
+  * @note   依次取出已到达的所有行，找到后立即返回，其后的行留给下次处理；
+  *         不匹配的行交给ESP8266_HandleLine，其中的云端下发数据不会丢失
   */
 uint8_t esp8266_check_cmd(char *str)
 {
-    char *strx = NULL;
+    USART2_Line_t line;
     
-    if (USART2_RX_STA & 0x8000)  /* 接收到一次数据 */
+    while (USART2_ReadLine(&line))
     {
-        USART2_RX_BUF[USART2_RX_STA & 0x7FFF] = 0;  /* 添加字符串结束符 */
-        strx = strstr((const char *)USART2_RX_BUF, (const char *)str);
+        if (USART2_LineFind(&line, str) >= 0)
+        {
+            return 1;
+        }
+        ESP8266_HandleLine(&line);
     }
     
-    return (strx != NULL) ? 1 : 0;
+    return 0;
 }
 
 /**
@@ -165,8 +555,7 @@ uint8_t esp8266_check_cmd(char *str)
   */
 void ESP8266_SendToTopic(const char *topic, int Data)
 {
-    USART2_RX_STA = 0;
-    u2_printf("AT+MQTTPUB=0,\"%s\",\"%d\",1,0\r\n", topic, Data);
+    ESP8266_Publish("AT+MQTTPUB=0,\"%s\",\"%d\",1,0", topic, Data);
 }
 
 /**
@@ -177,27 +566,42 @@ void ESP8266_SendToTopic(const char *topic, int Data)
   */
 void ESP8266_Send(char *property, int Data)
 {
-    USART2_RX_STA = 0;
-    u2_printf("AT+MQTTPUB=0,\"%s\",\"{\\\"%s\\\":%d}\",1,0\r\n", MQTT_TOPIC_POST, property, Data);
+    ESP8266_Publish("AT+MQTTPUB=0,\"%s\",\"{\\\"%s\\\":%d}\",1,0", MQTT_TOPIC_POST, property, Data);
 }
 
 /**
-  * @brief  发送ECG单点数据
-  * @param  timestamp: 时间戳（未使用）
-  * @param  data: ECG数据数组
-  * @param  count: 数据点数
-  * @note   每10ms发送1个数据点
+  * @brief  发送一帧ECG数据
+  * @param  payload: 已编码的帧文本（base64，不含引号、逗号和反斜杠）
+  * @retval 0: 已排队, 1: 未连接或上一帧尚未应答，稍后重试
+  * @note   作为AT指令排队，收到OK后才发送下一帧，模块处理不过来时自然限速
+  *         QoS 0: 帧内带序号，服务端可发现丢帧，不再逐条等待PUBACK
   */
-void ESP8266_SendECGBatch(uint32_t timestamp, uint16_t *data, uint8_t count)
+uint8_t ESP8266_SendECGFrame(const char *payload)
 {
-    (void)timestamp;
+    static char pub_cmd[ESP8266_ECG_PUB_LEN];   /* 指令完成前须保持有效 */
+    ESP8266_AtCmd_t cmd;
+    int len;
     
-    if (count == 0)
+    if (!ESP8266_IsReady())
     {
-        return;
+        return 1;
+    }
+    
+    len = snprintf(pub_cmd, sizeof(pub_cmd), "AT+MQTTPUB=0,\"%s\",\"%s\",0,0", MQTT_TOPIC_ECG, payload);
+    if (len < 0 || len >= (int)sizeof(pub_cmd))
+    {
+        esp8266_publish_drop++;
+        return 0;   /* 帧过长，丢弃，避免反复重试 */
     }
     
-    ESP8266_SendToTopic(MQTT_TOPIC_ECG, data[0]);
+    cmd.cmd = pub_cmd;
+    cmd.ack = "OK";
+    cmd.timeout_ms = 1000;
+    cmd.retries = 0;
+    cmd.optional = 1;       /* 单帧失败不影响连接 */
+    cmd.delay_ms = 0;
+    
+    return ESP8266_AT_Submit(&cmd);
 }
 
 /**
@@ -209,9 +613,8 @@ void ESP8266_SendECGBatch(uint32_t timestamp, uint16_t *data, uint8_t count)
   */
 void ESP8266_SendVitalSign(uint16_t heart_rate, uint16_t spo2)
 {
-    USART2_RX_STA = 0;
-    u2_printf("AT+MQTTPUB=0,\"%s\",\"{\\\"heartRate\\\":%d,\\\"oxygenSaturation\\\":%d}\",1,0\r\n",
-              MQTT_TOPIC_VITAL, heart_rate, spo2);
+    ESP8266_Publish("AT+MQTTPUB=0,\"%s\",\"{\\\"heartRate\\\":%d,\\\"oxygenSaturation\\\":%d}\",1,0",
+                    MQTT_TOPIC_VITAL, heart_rate, spo2);
 }
 
 /**
@@ -223,58 +626,33 @@ void ESP8266_SendVitalSign(uint16_t heart_rate, uint16_t spo2)
   */
 void ESP8266_SendAlarm(uint8_t alarm_type, uint8_t severity)
 {
-    USART2_RX_STA = 0;
-    u2_printf("AT+MQTTPUB=0,\"%s\",\"{\\\"type\\\":%d,\\\"severity\\\":%d}\",1,0\r\n",
-              MQTT_TOPIC_ALARM, alarm_type, severity);
+    ESP8266_Publish("AT+MQTTPUB=0,\"%s\",\"{\\\"type\\\":%d,\\\"severity\\\":%d}\",1,0",
+                    MQTT_TOPIC_ALARM, alarm_type, severity);
 }
 
 /**
   * @brief  接收云端下发的数据
   * @param  PRO: 要查找的属性名称
   * @note   解析JSON格式数据，提取属性值存入Property_Data数组
+  *         依次处理所有已到达的行，多条下发数据连续到达时不会丢失
   *         
   *         示例：收到 {"Property":123}
   *         解析后 Property_Data = "123"
   */
 void ESP8266_Received(char *PRO)
 {
-    unsigned char *ret = 0;
-    char *property = 0;
-    unsigned char i;
+    USART2_Line_t line;
     
     if (PRO == NULL)
     {
         return;
     }
     
-    if (USART2_RX_STA & 0x8000)  /* 串口2接收到一帧数据 */
+    esp8266_watch_property = PRO;  /* 之后等待应答时到达的下发数据也按此解析 */
+    
+    while (USART2_ReadLine(&line))
     {
-        ret = USART2_RX_BUF;
-        if (ret != 0)
-        {
-            property = strstr((const char *)ret, (const char *)PRO);
-            if (property != NULL)
-            {
-                /* 提取属性值（数字部分） */
-                for (i = 0; i < 5; i++)
-                {
-                    if ((*(property + 13 + i) >= '0' && *(property + 13 + i) <= '9') ||
-                        (*(property + 13 + i) == '}'))
-                    {
-                        Property_Data[i] = *(property + 13 + i);
-                    }
-                }
-                USART2_RX_STA = 0;
-            }
-            else
-            {
-                USART2_RX_STA = 0;
-            }
-        }
-        else
-        {
-            USART2_RX_STA = 0;
-        }
+        ESP8266_Dispatch(&line);    /* 经过AT引擎，避免吞掉指令应答 */
     }
 }
 
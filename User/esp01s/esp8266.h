@@ -83,23 +83,77 @@
 #define MQTT_Client MQTT_CLIENTID
 #define MQTT_Pass   MQTT_CONN
 
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  AT指令描述
+  */
+typedef struct
+{
+    const char *cmd;        /**< 指令（不含\r\n） */
+    const char *ack;        /**< 期望应答，NULL表示发送后不等待 */
+    uint16_t timeout_ms;    /**< 每次尝试的应答超时 (ms) */
+    uint8_t  retries;       /**< 失败后重试次数 */
+    uint8_t  optional;      /**< 1: 重试用完仍失败时忽略，继续后续指令 */
+    uint16_t delay_ms;      /**< 完成后等待时间 (ms)，如复位、入网后 */
+} ESP8266_AtCmd_t;
+
+/**
+  * @brief  WiFi/MQTT连接状态
+  */
+typedef enum
+{
+    ESP8266_LINK_BOOT = 0,      /**< 等待模块上电启动 */
+    ESP8266_LINK_CONNECTING,    /**< 正在执行连接脚本 */
+    ESP8266_LINK_ONLINE,        /**< MQTT已连接，可以发布 */
+    ESP8266_LINK_BACKOFF        /**< 连接失败，等待后重新连接 */
+} ESP8266_Link_t;
+
 /*============================ 外部变量 ============================*/
 
 extern unsigned char Property_Data[];  /**< 云端属性数据缓冲区 */
+extern uint32_t esp8266_reconnect_count;  /**< 重新连接次数 */
+extern uint32_t esp8266_publish_drop;     /**< 未连接或队列已满时被丢弃的发布次数 */
 
 /*============================ 函数声明 ============================*/
 
 /**
   * @brief  ESP8266模块初始化
+  * @note   立即返回，连接在 ESP8266_Process 中后台完成
   */
 void ESP8266_Init(void);
 
+/**
+  * @brief  ESP8266后台处理（在主循环中调用）
+  * @note   处理应答和断线通知，推进AT指令队列与WiFi/MQTT连接，不阻塞
+  */
+void ESP8266_Process(void);
+
+/**
+  * @brief  获取WiFi/MQTT连接状态
+  */
+ESP8266_Link_t ESP8266_GetLink(void);
+
+/**
+  * @brief  AT指令入队（非阻塞）
+  * @param  cmd: 指令描述，字符串须在指令执行完成前保持有效
+  * @retval 0: 成功, 1: 队列已满
+  */
+uint8_t ESP8266_AT_Submit(const ESP8266_AtCmd_t *cmd);
+
+/**
+  * @brief  AT指令队列是否空闲
+  * @retval 1: 没有正在执行或排队的指令
+  */
+uint8_t ESP8266_AT_IsIdle(void);
+
 /**
   * @brief  向ESP8266发送AT指令
   * @param  cmd: AT指令字符串
   * @param  ack: 期望应答字符串
   * @param  waittime: 超时时间(单位:10ms)
   * @retval 0:成功 1:失败
+  * @note   阻塞等待，仅供调试使用
   */
 uint8_t esp8266_send_cmd(char *cmd, char *ack, uint16_t waittime);
 
@@ -125,14 +179,18 @@ void ESP8266_SendToTopic(const char *topic, int Data);
 void ESP8266_Send(char *property, int Data);
 
 /**
-  * @brief  发送ECG批量数据
-  * @param  timestamp: 时间戳
-  * @param  data: ECG数据数组
-  * @param  count: 数据点数（最多20个）
+  * @brief  发送一帧ECG数据
+  * @param  payload: 已编码的帧文本，格式见 ecg_frame.h
+  * @retval 0: 已排队, 1: 未连接或上一帧尚未应答，稍后重试
   * @note   发送到 health/ecg 主题
-  *         JSON格式: {"ts":123456,"data":[1234,1235,...]}
   */
-void ESP8266_SendECGBatch(uint32_t timestamp, uint16_t *data, uint8_t count);
+uint8_t ESP8266_SendECGFrame(const char *payload);
+
+/**
+  * @brief  是否可以立即发布
+  * @retval 1: MQTT已连接且没有AT指令在执行
+  */
+uint8_t ESP8266_IsReady(void);
 
 /**
   * @brief  发送生命体征数据
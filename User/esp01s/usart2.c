@@ -5,8 +5,24 @@
   * 
   * @details 实现功能：
   *          - USART2初始化 (PA2-TX, PA3-RX)
-  *          - 中断接收（帧结束标志: 0x0D 0x0A）
-  *          - printf风格的格式化发送
+  *          - DMA循环接收 + 空闲线检测，按行（0x0D 0x0A）取出，不拷贝
+  *          - printf风格的格式化发送，经发送队列由TXE中断发出
+  *
+  *          发送队列（单生产者/单消费者）:
+  *
+  *          主循环 u2_printf/USART2_Send --Ring_PutN--> [ USART2_TxRing ] --Ring_Get--> TXE中断 -> DR
+  *
+  *          入队只做内存拷贝，115200波特率下60字节的MQTT消息
+  *          不再阻塞主循环约5ms；队列满时整条丢弃并计数
+  *
+  *          接收缓冲（单生产者/单消费者）:
+  *
+  *          DR --DMA1通道6(循环)--> [ USART2_RxRing ] --USART2_ReadLine--> 行切片
+  *                  │ 半满/全满/空闲中断 Ring_Commit 发布已写入的字节
+  *
+  *          多行应答（OK、+MQTTSUBRECV、ERROR）连续到达时全部保留在缓冲中，
+  *          主循环逐行取出；启用 OLED_USE_HW_I2C 时DMA1通道6被占用，
+  *          改为RXNE中断逐字节写入同一缓冲，接口不变
   ******************************************************************************
   */
 
@@ -15,29 +31,40 @@
 #include "stm32f10x.h"
 #include "stm32f10x_rcc.h"
 #include "stm32f10x_usart.h"
+#include "stm32f10x_dma.h"
 #include "usart2.h"
+#include "module/ring/ring.h"
+#include "module/irqstat/irqstat.h"
 #include "sys.h"
 #include "stdarg.h"
 #include "stdio.h"
 #include "string.h"
 
+#if !RING_IS_POW2(USART2_TX_QUEUE_SIZE) || (USART2_MAX_SEND_LEN > USART2_TX_QUEUE_SIZE)
+#error "USART2_TX_QUEUE_SIZE must be a power of two not smaller than USART2_MAX_SEND_LEN"
+#endif
+
 /*============================ 全局变量 ============================*/
 
-/** @brief 发送缓冲区 (8字节对齐) */
+/** @brief 格式化缓冲区 (8字节对齐) */
 __align(8) uint8_t USART2_TX_BUF[USART2_MAX_SEND_LEN];
 
-/** @brief 接收缓冲区 */
-uint8_t USART2_RX_BUF[USART2_MAX_RECV_LEN];
+/** @brief 发送队列（主循环写入，TXE中断取出；high_water为最高占用字节数） */
+static uint8_t USART2_TxQueue[USART2_TX_QUEUE_SIZE];
+Ring_t USART2_TxRing;
 
-/**
-  * @brief  接收状态标志
-  * @note   帧模式接收，以 0x0D 0x0A (\\r\\n) 作为帧结束标志
-  *         
-  *         bit15:    接收完成标志 (1=收到完整帧)
-  *         bit14:    收到0x0D标志
-  *         bit[13:0]: 已接收数据长度
-  */
-uint16_t USART2_RX_STA = 0;
+uint32_t USART2_TxDropCount = 0;  /**< 队列满被丢弃的消息数 */
+
+/** @brief 接收缓冲区（DMA或RXNE中断写入，主循环按行取出） */
+static uint8_t USART2_RxBuf[USART2_RX_BUF_SIZE];
+static Ring_t USART2_RxRing;
+static uint32_t USART2_RxScan = 0;            /**< 换行符查找位置，避免重复扫描 */
+
+#ifndef OLED_USE_HW_I2C
+static uint16_t USART2_RxDmaPos = 0;          /**< 上次记录的DMA写位置 */
+#endif
+
+uint32_t USART2_RxOverflow = 0;   /**< 接收数据未及时取出被覆盖的次数 */
 
 /*============================ 函数实现 ============================*/
 
@@ -53,6 +80,13 @@ void usart2_init(uint32_t bound)
     NVIC_InitTypeDef NVIC_InitStructure;
     GPIO_InitTypeDef GPIO_InitStructure;
     USART_InitTypeDef USART_InitStructure;
+#ifndef OLED_USE_HW_I2C
+    DMA_InitTypeDef DMA_InitStructure;
+#endif
+
+    Ring_Init(&USART2_TxRing, USART2_TxQueue, 1, USART2_TX_QUEUE_SIZE);
+    Ring_Init(&USART2_RxRing, USART2_RxBuf, 1, USART2_RX_BUF_SIZE);
+    USART2_RxScan = 0;
 
     /* 使能时钟 */
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
@@ -85,87 +119,305 @@ void usart2_init(uint32_t bound)
     USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
 
     USART_Init(USART2, &USART_InitStructure);
+
+#ifndef OLED_USE_HW_I2C
+    /* DMA1通道6: USART2->DR 循环写入接收缓冲 */
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel6);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART2->DR;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)USART2_RxBuf;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = USART2_RX_BUF_SIZE;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_Init(DMA1_Channel6, &DMA_InitStructure);
+
+    /* 半满/全满中断保证写位置每半个缓冲至少记录一次 */
+    DMA_ClearFlag(DMA1_FLAG_GL6);
+    DMA_ITConfig(DMA1_Channel6, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+
+    DMA_Cmd(DMA1_Channel6, ENABLE);
+    USART_DMACmd(USART2, USART_DMAReq_Rx, ENABLE);
+    USART_ITConfig(USART2, USART_IT_IDLE, ENABLE);  /* 使能空闲线中断 */
+#else
     USART_ITConfig(USART2, USART_IT_RXNE, ENABLE);  /* 使能接收中断 */
+#endif
     USART_Cmd(USART2, ENABLE);
 }
 
-#ifdef USART2_RX_EN
+#ifndef OLED_USE_HW_I2C
+/**
+  * @brief  根据DMA剩余计数发布已接收的字节
+  * @note   在空闲、半满、全满中断中调用，两次调用之间最多写入半个缓冲
+  */
+static void USART2_RxDmaUpdate(void)
+{
+    uint16_t pos = USART2_RX_BUF_SIZE - DMA_GetCurrDataCounter(DMA1_Channel6);
+
+    Ring_Commit(&USART2_RxRing, (uint16_t)(pos - USART2_RxDmaPos) & (USART2_RX_BUF_SIZE - 1));
+    USART2_RxDmaPos = pos;
+}
+
+/**
+  * @brief  DMA1通道6中断服务函数（USART2接收）
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+    IRQSTAT_ENTER();
+
+    if (DMA_GetITStatus(DMA1_IT_HT6) == SET)
+    {
+        DMA_ClearITPendingBit(DMA1_IT_HT6);
+    }
+    if (DMA_GetITStatus(DMA1_IT_TC6) == SET)
+    {
+        DMA_ClearITPendingBit(DMA1_IT_TC6);
+    }
+    USART2_RxDmaUpdate();
+
+    IRQSTAT_EXIT(IRQSTAT_DMA6);
+}
+#endif
+
 /**
   * @brief  USART2中断服务函数
-  * @note   帧接收逻辑：
-  *         - 接收数据直到遇到 0x0D (\\r)
-  *         - 下一个字节为 0x0A (\\n) 时，标记接收完成
-  *         - 接收完成后 USART2_RX_STA 的 bit15 置1
+  * @note   发送: 发送数据寄存器空时从队列取下一个字节，队列空则关闭TXE中断
+  *         接收: 空闲线中断时记录DMA写位置（一段数据接收结束）；
+  *               无DMA时RXNE中断逐字节写入接收缓冲
   */
 void USART2_IRQHandler(void)
 {
-    uint8_t Res;
+    uint8_t ch;
+    IRQSTAT_ENTER();
+
+    if (USART_GetITStatus(USART2, USART_IT_TXE) != RESET)
+    {
+        if (Ring_Get(&USART2_TxRing, &ch))
+        {
+            USART_SendData(USART2, ch);
+        }
+        else
+        {
+            USART_ITConfig(USART2, USART_IT_TXE, DISABLE);  /* 队列已空 */
+        }
+    }
 
+#ifdef USART2_RX_EN
+#ifndef OLED_USE_HW_I2C
+    if (USART_GetITStatus(USART2, USART_IT_IDLE) != RESET)
+    {
+        USART_ReceiveData(USART2);  /* 先读SR再读DR，清除IDLE标志 */
+        USART2_RxDmaUpdate();
+    }
+#else
     if (USART_GetITStatus(USART2, USART_IT_RXNE) != RESET)
     {
-        Res = USART_ReceiveData(USART2);
+        ch = (uint8_t)USART_ReceiveData(USART2);
+        Ring_PutOverwrite(&USART2_RxRing, &ch);  /* 与DMA相同，满时覆盖，由主循环检测 */
+    }
+#endif
+#endif /* USART2_RX_EN */
+
+    IRQSTAT_EXIT(IRQSTAT_USART2);
+}
 
-        if ((USART2_RX_STA & 0x8000) == 0)  /* 接收未完成 */
+/**
+  * @brief  取出下一行接收数据
+  * @param  line: 输出的行切片（不含 \r\n）
+  * @retval 1: 取到一行, 0: 没有完整的行
+  * @note   行数据直接指向接收缓冲，不做拷贝；跨越缓冲末尾时分为两段。
+  *         返回后该行占用的空间即交还给DMA，应在收到约半个缓冲的新数据前处理完。
+  *         空行被跳过；超过缓冲长度仍未结束的行被丢弃并计入溢出次数
+  */
+uint8_t USART2_ReadLine(USART2_Line_t *line)
+{
+    uint32_t head = USART2_RxRing.head;
+    uint32_t start, end;
+    uint16_t offset, len;
+
+    /* 未取出的数据已被DMA覆盖，丢弃后重新同步 */
+    if (Ring_Count(&USART2_RxRing) > USART2_RX_BUF_SIZE)
+    {
+        USART2_RxOverflow++;
+        Ring_Flush(&USART2_RxRing);
+        USART2_RxScan = USART2_RxRing.tail;
+        return 0;
+    }
+
+    while (USART2_RxScan != head)
+    {
+        if (*(uint8_t *)Ring_At(&USART2_RxRing, USART2_RxScan++) != '\n')
         {
-            if (USART2_RX_STA & 0x4000)     /* 已收到 0x0D */
-            {
-                if (Res != 0x0A)
-                {
-                    USART2_RX_STA = 0;      /* 接收错误，重新开始 */
-                }
-                else
-                {
-                    USART2_RX_STA |= 0x8000; /* 接收完成 */
-                }
-            }
-            else  /* 未收到 0x0D */
+            continue;
+        }
+
+        /* 找到行尾，去掉 \r\n */
+        start = USART2_RxRing.tail;
+        end = USART2_RxScan - 1;
+        if (end != start && *(uint8_t *)Ring_At(&USART2_RxRing, end - 1) == '\r')
+        {
+            end--;
+        }
+        Ring_Skip(&USART2_RxRing, USART2_RxScan - start);
+
+        if (end == start)
+        {
+            continue;  /* 空行 */
+        }
+
+        offset = start & (USART2_RX_BUF_SIZE - 1);
+        len = end - start;
+        line->seg1 = (const uint8_t *)Ring_At(&USART2_RxRing, start);
+        if (offset + len <= USART2_RX_BUF_SIZE)
+        {
+            line->len1 = len;
+            line->seg2 = 0;
+            line->len2 = 0;
+        }
+        else
+        {
+            line->len1 = USART2_RX_BUF_SIZE - offset;
+            line->seg2 = &USART2_RxBuf[0];
+            line->len2 = len - line->len1;
+        }
+        return 1;
+    }
+
+    /* 一行超过缓冲长度仍无换行，无法完整取出 */
+    if (USART2_RxScan - USART2_RxRing.tail >= USART2_RX_BUF_SIZE)
+    {
+        USART2_RxOverflow++;
+        Ring_Skip(&USART2_RxRing, USART2_RxScan - USART2_RxRing.tail);
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  读取行中第i个字符
+  * @param  line: 行切片
+  * @param  i: 字符位置 (0 ~ 行长度-1)
+  * @retval 字符
+  */
+uint8_t USART2_LineAt(const USART2_Line_t *line, uint16_t i)
+{
+    return (i < line->len1) ? line->seg1[i] : line->seg2[i - line->len1];
+}
+
+/**
+  * @brief  在行中查找字符串
+  * @param  line: 行切片
+  * @param  str: 要查找的字符串
+  * @retval 首次出现的位置, -1: 未找到
+  */
+int16_t USART2_LineFind(const USART2_Line_t *line, const char *str)
+{
+    uint16_t total = line->len1 + line->len2;
+    uint16_t n = strlen(str);
+    uint16_t i, j;
+
+    if (n == 0 || n > total)
+    {
+        return (n == 0) ? 0 : -1;
+    }
+
+    for (i = 0; i + n <= total; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            if (USART2_LineAt(line, i + j) != (uint8_t)str[j])
             {
-                if (Res == 0x0D)
-                {
-                    USART2_RX_STA |= 0x4000; /* 标记收到 0x0D */
-                }
-                else
-                {
-                    USART2_RX_BUF[USART2_RX_STA & 0x3FFF] = Res;
-                    USART2_RX_STA++;
-
-                    /* 溢出保护 */
-                    if (USART2_RX_STA > (USART2_MAX_RECV_LEN - 1))
-                    {
-                        USART2_RX_STA = 0;
-                    }
-                }
+                break;
             }
         }
+        if (j == n)
+        {
+            return i;
+        }
     }
+
+    return -1;
+}
+
+/**
+  * @brief  丢弃所有已接收但未取出的数据
+  */
+void USART2_RxFlush(void)
+{
+    Ring_Flush(&USART2_RxRing);
+    USART2_RxScan = USART2_RxRing.tail;
+}
+
+/**
+  * @brief  获取发送队列剩余空间
+  * @retval 可写入的字节数
+  */
+uint16_t USART2_TxFree(void)
+{
+    return Ring_Free(&USART2_TxRing);
+}
+
+/**
+  * @brief  USART2发送一段数据（非阻塞）
+  * @param  data: 数据指针
+  * @param  len: 数据长度
+  * @retval 0: 成功, 1: 队列空间不足
+  * @note   仅在主循环中调用（单生产者）
+  */
+uint8_t USART2_Send(const uint8_t *data, uint16_t len)
+{
+    /* 整条放不下则整条丢弃，不发送半条消息 */
+    if (len > Ring_Free(&USART2_TxRing))
+    {
+        USART2_TxDropCount++;
+        return 1;
+    }
+
+    Ring_PutN(&USART2_TxRing, data, len);
+
+    /* 启动发送，中断在队列取空后自行关闭 */
+    USART_ITConfig(USART2, USART_IT_TXE, ENABLE);
+    return 0;
 }
-#endif /* USART2_RX_EN */
 
 /**
   * @brief  USART2格式化发送函数
   * @param  fmt: 格式化字符串
   * @param  ...: 可变参数
-  * @note   使用方法与printf相同，最大发送长度为 USART2_MAX_SEND_LEN
+  * @retval 0: 成功, 1: 队列空间不足或超长，本条未发送
+  * @note   使用方法与printf相同，格式化结果须短于 USART2_MAX_SEND_LEN，超长整条丢弃
   * 
   * @example u2_printf("AT+CWJAP=\"%s\",\"%s\"\r\n", ssid, password);
   */
-void u2_printf(char *fmt, ...)
+uint8_t u2_printf(char *fmt, ...)
 {
-    uint16_t i, j;
+    int len;
     va_list ap;
 
     va_start(ap, fmt);
-    vsprintf((char *)USART2_TX_BUF, fmt, ap);
+    len = vsnprintf((char *)USART2_TX_BUF, USART2_MAX_SEND_LEN, fmt, ap);
     va_end(ap);
 
-    i = strlen((const char *)USART2_TX_BUF);
-
-    for (j = 0; j < i; j++)
+    if (len < 0)
     {
-        /* 等待上次发送完成 */
-        while (USART_GetFlagStatus(USART2, USART_FLAG_TC) == RESET);
-        USART_SendData(USART2, (uint8_t)USART2_TX_BUF[j]);
+        return 1;
     }
+    if (len >= USART2_MAX_SEND_LEN)
+    {
+        /* 超长整条丢弃，截断会去掉结尾的\r\n，与下一条指令粘连 */
+        USART2_TxDropCount++;
+        return 1;
+    }
+
+    return USART2_Send(USART2_TX_BUF, (uint16_t)len);
 }
 
 #endif /* USE_STDPERIPH_DRIVER */
@@ -12,17 +12,36 @@
 
 #include "stdint.h"
 #include "stdio.h"
+#include "kconfig.h"
+#include "module/ring/ring.h"
 
 /*============================ 配置宏 ============================*/
 
-#define USART2_MAX_RECV_LEN     600     /**< 最大接收缓冲区大小 (字节) */
-#define USART2_MAX_SEND_LEN     600     /**< 最大发送缓冲区大小 (字节) */
+#define USART2_RX_BUF_SIZE      512     /**< 接收环形缓冲区大小 (字节，必须为2的幂) */
+#define USART2_TX_QUEUE_SIZE    512     /**< 发送队列大小 (字节，必须为2的幂) */
+#define USART2_MAX_SEND_LEN     USART2_TX_QUEUE_SIZE    /**< 单条格式化发送的最大长度 (字节，含结尾0)，不超过发送队列 */
 #define USART2_RX_EN            1       /**< 接收使能: 0=禁用, 1=启用 */
 
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  接收行切片
+  * @note   直接指向接收缓冲中的数据，不含 \r\n，也不以0结尾；
+  *         行跨越缓冲末尾时分为两段，seg2/len2 为回绕部分，否则 len2 为0
+  */
+typedef struct
+{
+    const uint8_t *seg1;    /**< 第一段起始地址 */
+    uint16_t       len1;    /**< 第一段长度 */
+    const uint8_t *seg2;    /**< 第二段起始地址（回绕部分） */
+    uint16_t       len2;    /**< 第二段长度 */
+} USART2_Line_t;
+
 /*============================ 外部变量 ============================*/
 
-extern uint8_t  USART2_RX_BUF[USART2_MAX_RECV_LEN];  /**< 接收缓冲区 */
-extern uint16_t USART2_RX_STA;                        /**< 接收状态标志 */
+extern Ring_t   USART2_TxRing;        /**< 发送队列（high_water: 最高占用字节数） */
+extern uint32_t USART2_TxDropCount;   /**< 队列满或超长被丢弃的消息数 */
+extern uint32_t USART2_RxOverflow;    /**< 接收数据未及时取出被覆盖的次数 */
 
 /*============================ 函数声明 ============================*/
 
@@ -36,11 +55,53 @@ void usart2_init(uint32_t bound);
   * @brief  USART2格式化发送 (类似printf)
   * @param  fmt: 格式化字符串
   * @param  ...: 可变参数
+  * @retval 0: 已放入发送队列, 1: 队列空间不足或超过 USART2_MAX_SEND_LEN，本条未发送
+  * @note   只格式化并入队，立即返回，由TXE中断在后台发送
   * 
   * @example u2_printf("AT+RST\r\n");
   * @example u2_printf("Value: %d\r\n", value);
   */
-void u2_printf(char *fmt, ...);
+uint8_t u2_printf(char *fmt, ...);
+
+/**
+  * @brief  USART2发送一段数据（非阻塞）
+  * @param  data: 数据指针
+  * @param  len: 数据长度
+  * @retval 0: 已放入发送队列, 1: 队列空间不足，本条未发送
+  * @note   整条入队或整条丢弃，不会只发出半条AT指令
+  */
+uint8_t USART2_Send(const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  获取发送队列剩余空间
+  * @retval 可写入的字节数
+  * @note   发送较长的消息前可先检查，空间不足时推迟到下一轮
+  */
+uint16_t USART2_TxFree(void);
+
+/**
+  * @brief  取出下一行接收数据（不拷贝）
+  * @param  line: 输出的行切片
+  * @retval 1: 取到一行, 0: 没有完整的行
+  * @note   可循环调用依次取出所有已到达的行，空行自动跳过
+  */
+uint8_t USART2_ReadLine(USART2_Line_t *line);
+
+/**
+  * @brief  读取行中第i个字符
+  */
+uint8_t USART2_LineAt(const USART2_Line_t *line, uint16_t i);
+
+/**
+  * @brief  在行中查找字符串
+  * @retval 首次出现的位置, -1: 未找到
+  */
+int16_t USART2_LineFind(const USART2_Line_t *line, const char *str);
+
+/**
+  * @brief  丢弃所有已接收但未取出的数据
+  */
+void USART2_RxFlush(void);
 
 #endif /* USE_STDPERIPH_DRIVER */
 
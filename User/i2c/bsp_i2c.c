@@ -2,13 +2,49 @@
   ******************************************************************************
   * @file    bsp_i2c.c
   * @brief   硬件I2C驱动 - 使用STM32标准库
+  *
+  * @details 中断+DMA驱动的异步I2C主机，传输以队列方式依次执行:
+  *
+  *          i2c_submit ──> [队列] ──> START -> 地址 -> 写tx_buf
+  *                                      │ 重复START（不发STOP）
+  *                                      └─> 地址 -> 读rx_buf（2字节以上DMA）
+  *                                            -> STOP -> 回调 -> 下一个传输
+  *
+  *          总线错误、仲裁丢失或超时时，切换为GPIO输出9个SCL时钟和STOP，
+  *          释放被从机拉住的SDA，再复位并重新初始化I2C外设
+  *
+  *          i2c_transmit / i2c_receive / i2c_write_read 为阻塞封装，
+  *          提交后等待完成，供初始化等场合使用
   ******************************************************************************
-  */ 
-  
+  */
+
 #include "./i2c/bsp_i2c.h"
+#include "stm32f10x_dma.h"
+#include "misc.h"
+#include "Timer2.h"
+#include "module/irqstat/irqstat.h"
+
+/* 传输阶段 */
+#define I2C_PHASE_IDLE      0
+#define I2C_PHASE_TX        1   /* 发送写地址和数据 */
+#define I2C_PHASE_RX        2   /* 重复起始后发送读地址和接收数据 */
 
 /* 私有变量 */
-static uint32_t I2C_Timeout;
+static I2C_Xfer_t *i2c_queue[I2C_QUEUE_SIZE];
+static uint8_t i2c_queue_head = 0;              /* 入队位置 */
+static uint8_t i2c_queue_tail = 0;              /* 出队位置 */
+
+static I2C_Xfer_t * volatile i2c_cur = 0;       /* 当前传输 */
+static volatile uint8_t  i2c_phase = I2C_PHASE_IDLE;
+static volatile uint16_t i2c_index = 0;         /* 当前阶段已收发字节数 */
+static volatile uint32_t i2c_start_tick = 0;    /* 当前传输开始时刻 (10us) */
+
+/* 统计 */
+uint32_t i2c_error_count = 0;
+uint32_t i2c_recover_count = 0;
+
+/* 内部函数 */
+static void I2C_StartNext(void);
 
 /**
   * @brief  延时函数 (毫秒)
@@ -19,7 +55,7 @@ void delay_ms(uint16_t ms)
     SysTick->LOAD = (SystemCoreClock / 1000) - 1;
     SysTick->VAL = 0;
     SysTick->CTRL = SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_CLKSOURCE_Msk;
-    
+
     while (ms--) {
         while (!(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk));
     }
@@ -27,52 +63,23 @@ void delay_ms(uint16_t ms)
 }
 
 /**
-  * @brief  等待I2C事件
-  * @param  I2C_EVENT: 等待的事件
-  * @retval 0:成功, 1:超时
+  * @brief  总线恢复时的半个SCL周期延时（约5us）
   */
-static uint8_t I2C_WaitEvent(uint32_t I2C_EVENT)
+static void I2C_BitDelay(void)
 {
-    I2C_Timeout = I2C_LONG_TIMEOUT;
-    while (!I2C_CheckEvent(SENSORS_I2C, I2C_EVENT)) {
-        if ((I2C_Timeout--) == 0) {
-            return 1;
-        }
+    volatile uint16_t i;
+    for (i = 0; i < 40; i++) {
     }
-    return 0;
 }
 
 /**
-  * @brief  等待I2C标志
-  * @param  I2C_FLAG: 等待的标志
-  * @param  Status: SET或RESET
-  * @retval 0:成功, 1:超时
+  * @brief  配置I2C外设、引脚和中断
   */
-static uint8_t I2C_WaitFlag(uint32_t I2C_FLAG, FlagStatus Status)
-{
-    I2C_Timeout = I2C_LONG_TIMEOUT;
-    while (I2C_GetFlagStatus(SENSORS_I2C, I2C_FLAG) != Status) {
-        if ((I2C_Timeout--) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-/**
-  * @brief  I2C主机初始化
-*/
-void I2cMaster_Init(void)
+static void I2C_PeriphInit(void)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
     I2C_InitTypeDef I2C_InitStructure;
 
-    /* 使能GPIO时钟 */
-    RCC_APB2PeriphClockCmd(SENSORS_I2C_SCL_GPIO_CLK | SENSORS_I2C_SDA_GPIO_CLK, ENABLE);
-    
-    /* 使能I2C时钟 */
-    RCC_APB1PeriphClockCmd(SENSORS_I2C_CLK, ENABLE);
-
     /* 配置I2C引脚: SCL */
     GPIO_InitStructure.GPIO_Pin = SENSORS_I2C_SCL_GPIO_PIN;
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_OD;  /* 开漏复用输出 */
@@ -82,7 +89,7 @@ void I2cMaster_Init(void)
     /* 配置I2C引脚: SDA */
     GPIO_InitStructure.GPIO_Pin = SENSORS_I2C_SDA_GPIO_PIN;
     GPIO_Init(SENSORS_I2C_SDA_GPIO_PORT, &GPIO_InitStructure);
-	
+
     /* I2C复位 */
     I2C_DeInit(SENSORS_I2C);
 
@@ -97,57 +104,332 @@ void I2cMaster_Init(void)
     /* 初始化I2C */
     I2C_Init(SENSORS_I2C, &I2C_InitStructure);
 
+    /* 事件和错误中断，缓冲中断按需开启 */
+    I2C_ITConfig(SENSORS_I2C, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+
     /* 使能I2C */
     I2C_Cmd(SENSORS_I2C, ENABLE);
 }
 
 /**
-  * @brief  I2C主机发送数据
-  * @param  pdata: 数据指针
-  * @param  data_size: 数据长度
-  * @retval 0:成功, 非0:失败
+  * @brief  总线恢复
+  * @note   从机在读数据中途被打断时会一直拉低SDA，主机无法产生START。
+  *         将SCL/SDA切换为GPIO开漏输出，输出最多9个SCL时钟直到SDA释放，
+  *         再产生STOP，最后复位I2C外设
   */
-uint8_t i2c_transmit(uint8_t *pdata, uint8_t data_size)
+static void I2C_BusRecover(void)
 {
+    GPIO_InitTypeDef GPIO_InitStructure;
     uint8_t i;
 
-    /* 等待I2C总线空闲 */
-    if (I2C_WaitFlag(I2C_FLAG_BUSY, RESET)) {
-        return 1;
+    I2C_Cmd(SENSORS_I2C, DISABLE);
+
+    GPIO_SetBits(SENSORS_I2C_SCL_GPIO_PORT, SENSORS_I2C_SCL_GPIO_PIN);
+    GPIO_SetBits(SENSORS_I2C_SDA_GPIO_PORT, SENSORS_I2C_SDA_GPIO_PIN);
+
+    GPIO_InitStructure.GPIO_Pin = SENSORS_I2C_SCL_GPIO_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_OD;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(SENSORS_I2C_SCL_GPIO_PORT, &GPIO_InitStructure);
+    GPIO_InitStructure.GPIO_Pin = SENSORS_I2C_SDA_GPIO_PIN;
+    GPIO_Init(SENSORS_I2C_SDA_GPIO_PORT, &GPIO_InitStructure);
+
+    /* 9个SCL时钟，从机移出剩余位后会释放SDA */
+    for (i = 0; i < 9; i++) {
+        if (GPIO_ReadInputDataBit(SENSORS_I2C_SDA_GPIO_PORT, SENSORS_I2C_SDA_GPIO_PIN)) {
+            break;
+        }
+        GPIO_ResetBits(SENSORS_I2C_SCL_GPIO_PORT, SENSORS_I2C_SCL_GPIO_PIN);
+        I2C_BitDelay();
+        GPIO_SetBits(SENSORS_I2C_SCL_GPIO_PORT, SENSORS_I2C_SCL_GPIO_PIN);
+        I2C_BitDelay();
     }
 
-    /* 产生起始信号 */
-    I2C_GenerateSTART(SENSORS_I2C, ENABLE);
+    /* STOP: SCL为高时SDA由低变高 */
+    GPIO_ResetBits(SENSORS_I2C_SCL_GPIO_PORT, SENSORS_I2C_SCL_GPIO_PIN);
+    I2C_BitDelay();
+    GPIO_ResetBits(SENSORS_I2C_SDA_GPIO_PORT, SENSORS_I2C_SDA_GPIO_PIN);
+    I2C_BitDelay();
+    GPIO_SetBits(SENSORS_I2C_SCL_GPIO_PORT, SENSORS_I2C_SCL_GPIO_PIN);
+    I2C_BitDelay();
+    GPIO_SetBits(SENSORS_I2C_SDA_GPIO_PORT, SENSORS_I2C_SDA_GPIO_PIN);
+    I2C_BitDelay();
+
+    /* 软件复位清除BUSY等残留状态，再重新初始化 */
+    I2C_SoftwareResetCmd(SENSORS_I2C, ENABLE);
+    I2C_SoftwareResetCmd(SENSORS_I2C, DISABLE);
+    I2C_PeriphInit();
+
+    i2c_recover_count++;
+}
 
-    /* 等待EV5: 起始信号已发送 */
-    if (I2C_WaitEvent(I2C_EVENT_MASTER_MODE_SELECT)) {
-        return 2;
+/**
+  * @brief  停止接收DMA
+  */
+static void I2C_StopRxDma(void)
+{
+    DMA_Cmd(SENSORS_I2C_RX_DMA_CH, DISABLE);
+    DMA_ClearFlag(SENSORS_I2C_RX_DMA_FLAG_GL);
+    I2C_DMACmd(SENSORS_I2C, DISABLE);
+    I2C_DMALastTransferCmd(SENSORS_I2C, DISABLE);
+}
+
+/**
+  * @brief  结束当前传输，回调后开始下一个
+  * @param  status: I2C_XFER_xxx
+  * @note   在中断中或关中断时调用
+  */
+static void I2C_Finish(uint8_t status)
+{
+    I2C_Xfer_t *xfer = i2c_cur;
+
+    I2C_ITConfig(SENSORS_I2C, I2C_IT_BUF, DISABLE);
+    i2c_cur = 0;
+    i2c_phase = I2C_PHASE_IDLE;
+
+    if (status != I2C_XFER_OK) {
+        i2c_error_count++;
+    }
+
+    if (xfer != 0) {
+        xfer->status = status;
+        if (xfer->callback != 0) {
+            xfer->callback(xfer);   /* 回调中可以提交新的传输 */
+        }
+    }
+
+    I2C_StartNext();
+}
+
+/**
+  * @brief  出错时中止当前传输并恢复总线
+  * @param  status: I2C_XFER_xxx
+  */
+static void I2C_Abort(uint8_t status)
+{
+    I2C_StopRxDma();
+    I2C_BusRecover();
+    I2C_Finish(status);
+}
+
+/**
+  * @brief  开始队列中的下一个传输
+  * @note   在中断中或关中断时调用
+  */
+static void I2C_StartNext(void)
+{
+    uint16_t wait;
+
+    if (i2c_cur != 0 || i2c_queue_tail == i2c_queue_head) {
+        return;
     }
 
-    /* 发送设备地址(写) */
-    I2C_Send7bitAddress(SENSORS_I2C, I2C_WRITE_ADDR, I2C_Direction_Transmitter);
+    i2c_cur = i2c_queue[i2c_queue_tail];
+    i2c_queue_tail = (i2c_queue_tail + 1) % I2C_QUEUE_SIZE;
+
+    i2c_index = 0;
+    i2c_phase = (i2c_cur->tx_len > 0) ? I2C_PHASE_TX : I2C_PHASE_RX;
+    i2c_start_tick = Timer3_GetTick();
 
-    /* 等待EV6: 地址已发送 */
-    if (I2C_WaitEvent(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {
-        return 3;
+    /* 上一个传输的STOP尚未发出时不能产生START */
+    wait = I2C_TIMEOUT;
+    while ((SENSORS_I2C->CR1 & I2C_CR1_STOP) && wait) {
+        wait--;
     }
 
-    /* 发送数据 */
-    for (i = 0; i < data_size; i++) {
-        I2C_SendData(SENSORS_I2C, pdata[i]);
-        
-        /* 等待EV8: 数据已发送 */
-        if (I2C_WaitEvent(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {
-            return 4;
+    I2C_AcknowledgeConfig(SENSORS_I2C, ENABLE);
+    I2C_GenerateSTART(SENSORS_I2C, ENABLE);
+}
+
+/**
+  * @brief  从队列中移除尚未开始的传输
+  * @param  xfer: 传输描述
+  * @note   关中断时调用
+  */
+static void I2C_Remove(I2C_Xfer_t *xfer)
+{
+    uint8_t src = i2c_queue_tail;
+    uint8_t dst = i2c_queue_tail;
+
+    while (src != i2c_queue_head) {
+        if (i2c_queue[src] != xfer) {
+            i2c_queue[dst] = i2c_queue[src];
+            dst = (dst + 1) % I2C_QUEUE_SIZE;
         }
+        src = (src + 1) % I2C_QUEUE_SIZE;
     }
+    i2c_queue_head = dst;
+}
 
-    /* 产生停止信号 */
-    I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+/**
+  * @brief  I2C主机初始化
+*/
+void I2cMaster_Init(void)
+{
+    NVIC_InitTypeDef NVIC_InitStructure;
+    DMA_InitTypeDef DMA_InitStructure;
+
+    /* 使能GPIO时钟 */
+    RCC_APB2PeriphClockCmd(SENSORS_I2C_SCL_GPIO_CLK | SENSORS_I2C_SDA_GPIO_CLK, ENABLE);
+
+    /* 使能I2C和DMA时钟 */
+    RCC_APB1PeriphClockCmd(SENSORS_I2C_CLK, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    /* 接收DMA: DR -> 内存，地址和长度在每次传输时设置 */
+    DMA_DeInit(SENSORS_I2C_RX_DMA_CH);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&SENSORS_I2C->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = 0;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = 1;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(SENSORS_I2C_RX_DMA_CH, &DMA_InitStructure);
+    DMA_ITConfig(SENSORS_I2C_RX_DMA_CH, DMA_IT_TC, ENABLE);
+
+    I2C_PeriphInit();
+
+    /* NVIC: 传感器读取不紧急，使用最低抢占优先级 */
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannel = SENSORS_I2C_EV_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = SENSORS_I2C_ER_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = SENSORS_I2C_RX_DMA_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+}
 
+/**
+  * @brief  提交一个异步传输
+  * @param  xfer: 传输描述，完成前须保持有效
+  * @retval 0:已排队, 1:队列已满
+  * @note   主循环和完成回调中均可调用
+  */
+uint8_t i2c_submit(I2C_Xfer_t *xfer)
+{
+    uint32_t primask;
+    uint8_t next;
+
+    xfer->status = I2C_XFER_PENDING;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    next = (i2c_queue_head + 1) % I2C_QUEUE_SIZE;
+    if (next == i2c_queue_tail) {
+        __set_PRIMASK(primask);
+        return 1;
+    }
+    i2c_queue[i2c_queue_head] = xfer;
+    i2c_queue_head = next;
+
+    I2C_StartNext();
+
+    __set_PRIMASK(primask);
     return 0;
 }
 
+/**
+  * @brief  是否没有进行中和排队的传输
+  * @retval 1:空闲
+  */
+uint8_t i2c_is_idle(void)
+{
+    return (i2c_cur == 0) && (i2c_queue_tail == i2c_queue_head);
+}
+
+/**
+  * @brief  超时检查（主循环调用）
+  * @note   SCL被拉住等情况下不会产生任何中断，由此中止传输并恢复总线
+  */
+void i2c_poll(void)
+{
+    uint32_t primask;
+
+    if (i2c_cur == 0) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (i2c_cur != 0 &&
+        (uint32_t)(Timer3_GetTick() - i2c_start_tick) >= I2C_XFER_TIMEOUT_MS * (TIM3_COUNTER_FREQ / 1000)) {
+        I2C_Abort(I2C_XFER_TIMEOUT);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  阻塞式写后读（重复起始）
+  * @param  addr: 8位写地址
+  * @param  tx_buf: 写数据
+  * @param  tx_len: 写长度
+  * @param  rx_buf: 读缓冲区
+  * @param  rx_len: 读长度
+  * @retval I2C_XFER_OK 或错误码
+  * @note   以循环计数限时，TIM3启动前（初始化阶段）也可使用
+  */
+uint8_t i2c_write_read(uint8_t addr, const uint8_t *tx_buf, uint16_t tx_len, uint8_t *rx_buf, uint16_t rx_len)
+{
+    I2C_Xfer_t xfer;
+    uint32_t primask;
+    uint32_t timeout;
+
+    xfer.addr = addr;
+    xfer.tx_buf = tx_buf;
+    xfer.tx_len = tx_len;
+    xfer.rx_buf = rx_buf;
+    xfer.rx_len = rx_len;
+    xfer.callback = 0;
+
+    timeout = I2C_LONG_TIMEOUT;
+    while (i2c_submit(&xfer)) {
+        if ((timeout--) == 0) {
+            return I2C_XFER_TIMEOUT;
+        }
+    }
+
+    timeout = I2C_LONG_TIMEOUT * 4;
+    while (xfer.status == I2C_XFER_PENDING) {
+        if ((timeout--) == 0) {
+            primask = __get_PRIMASK();
+            __disable_irq();
+            if (xfer.status == I2C_XFER_PENDING) {
+                if (i2c_cur == &xfer) {
+                    I2C_Abort(I2C_XFER_TIMEOUT);
+                }
+                else {
+                    /* 仍在排队（前面的传输卡住）: 移出队列，栈上的描述不能再被使用 */
+                    I2C_Remove(&xfer);
+                    xfer.status = I2C_XFER_TIMEOUT;
+                }
+            }
+            __set_PRIMASK(primask);
+            break;
+        }
+    }
+
+    return xfer.status;
+}
+
+/**
+  * @brief  I2C主机发送数据
+  * @param  pdata: 数据指针
+  * @param  data_size: 数据长度
+  * @retval 0:成功, 非0:失败
+  */
+uint8_t i2c_transmit(uint8_t *pdata, uint8_t data_size)
+{
+    return i2c_write_read(I2C_WRITE_ADDR, pdata, data_size, 0, 0);
+}
+
 /**
   * @brief  I2C主机接收数据
   * @param  pdata: 数据指针
@@ -156,50 +438,150 @@ uint8_t i2c_transmit(uint8_t *pdata, uint8_t data_size)
   */
 uint8_t i2c_receive(uint8_t *pdata, uint8_t data_size)
 {
-    uint8_t i;
+    return i2c_write_read(I2C_WRITE_ADDR, 0, 0, pdata, data_size);
+}
 
-    /* 等待I2C总线空闲 */
-    if (I2C_WaitFlag(I2C_FLAG_BUSY, RESET)) {
-        return 1;
+/**
+  * @brief  I2C事件处理
+  * @note   EV5(SB) -> 发地址; EV6(ADDR) -> 开始收发; EV8(TXE)/BTF -> 发送;
+  *         RXNE -> 单字节接收; 多字节接收由DMA完成
+  */
+static void I2C_EventHandler(void)
+{
+    I2C_Xfer_t *xfer = i2c_cur;
+    uint16_t sr1 = SENSORS_I2C->SR1;
+
+    if (xfer == 0) {
+        /* 无传输时的残留事件: 读SR2/DR清除 */
+        (void)SENSORS_I2C->SR2;
+        (void)SENSORS_I2C->DR;
+        return;
     }
 
-    /* 产生起始信号 */
-    I2C_GenerateSTART(SENSORS_I2C, ENABLE);
-
-    /* 等待EV5 */
-    if (I2C_WaitEvent(I2C_EVENT_MASTER_MODE_SELECT)) {
-        return 2;
+    /* EV5: START已发出，发送地址 */
+    if (sr1 & I2C_SR1_SB) {
+        if (i2c_phase == I2C_PHASE_TX) {
+            I2C_Send7bitAddress(SENSORS_I2C, xfer->addr, I2C_Direction_Transmitter);
+        }
+        else {
+            I2C_Send7bitAddress(SENSORS_I2C, xfer->addr, I2C_Direction_Receiver);
+        }
+        return;
     }
 
-    /* 发送设备地址(读) */
-    I2C_Send7bitAddress(SENSORS_I2C, I2C_READ_ADDR, I2C_Direction_Receiver);
+    /* EV6: 地址已应答 */
+    if (sr1 & I2C_SR1_ADDR) {
+        i2c_index = 0;
 
-    /* 等待EV6 */
-    if (I2C_WaitEvent(I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED)) {
-        return 3;
+        if (i2c_phase == I2C_PHASE_TX) {
+            (void)SENSORS_I2C->SR2;                         /* 清除ADDR */
+            SENSORS_I2C->DR = xfer->tx_buf[i2c_index++];
+            I2C_ITConfig(SENSORS_I2C, I2C_IT_BUF, ENABLE);
+        }
+        else if (xfer->rx_len == 1) {
+            /* 单字节: 清ADDR前关闭ACK，清ADDR后立即STOP */
+            I2C_AcknowledgeConfig(SENSORS_I2C, DISABLE);
+            (void)SENSORS_I2C->SR2;
+            I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+            I2C_ITConfig(SENSORS_I2C, I2C_IT_BUF, ENABLE);
+        }
+        else {
+            /* 多字节: DMA接收，LAST使最后一个字节自动回NACK */
+            SENSORS_I2C_RX_DMA_CH->CMAR = (uint32_t)xfer->rx_buf;
+            SENSORS_I2C_RX_DMA_CH->CNDTR = xfer->rx_len;
+            DMA_ClearFlag(SENSORS_I2C_RX_DMA_FLAG_GL);
+            DMA_Cmd(SENSORS_I2C_RX_DMA_CH, ENABLE);
+            I2C_DMALastTransferCmd(SENSORS_I2C, ENABLE);
+            I2C_DMACmd(SENSORS_I2C, ENABLE);
+            (void)SENSORS_I2C->SR2;
+        }
+        return;
     }
 
-    /* 使能ACK */
-    I2C_AcknowledgeConfig(SENSORS_I2C, ENABLE);
-
-    /* 接收数据 */
-    for (i = 0; i < data_size; i++) {
-        /* 最后一个字节前禁用ACK */
-        if (i == data_size - 1) {
-            I2C_AcknowledgeConfig(SENSORS_I2C, DISABLE);
+    if (i2c_phase == I2C_PHASE_TX) {
+        /* EV8: 发送缓冲空，继续写入 */
+        if ((sr1 & I2C_SR1_TXE) && i2c_index < xfer->tx_len) {
+            SENSORS_I2C->DR = xfer->tx_buf[i2c_index++];
+            return;
         }
 
-        /* 等待EV7: 数据已接收 */
-        if (I2C_WaitEvent(I2C_EVENT_MASTER_BYTE_RECEIVED)) {
-            return 4;
+        /* 全部写入，等待BTF确认最后一个字节发出 */
+        I2C_ITConfig(SENSORS_I2C, I2C_IT_BUF, DISABLE);
+
+        if (sr1 & I2C_SR1_BTF) {
+            if (xfer->rx_len > 0) {
+                /* 重复起始，进入读阶段 */
+                i2c_phase = I2C_PHASE_RX;
+                I2C_GenerateSTART(SENSORS_I2C, ENABLE);
+            }
+            else {
+                I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+                (void)SENSORS_I2C->DR;                      /* 清除BTF */
+                I2C_Finish(I2C_XFER_OK);
+            }
         }
+        return;
+    }
+
+    /* 单字节接收完成（STOP已在ADDR时设置） */
+    if (sr1 & I2C_SR1_RXNE) {
+        xfer->rx_buf[0] = (uint8_t)SENSORS_I2C->DR;
+        I2C_Finish(I2C_XFER_OK);
+    }
+}
 
-        /* 读取数据 */
-        pdata[i] = I2C_ReceiveData(SENSORS_I2C);
+/**
+  * @brief  I2C事件中断
+  * @note   处理中各分支提前返回，在外层统一计时
+  */
+void SENSORS_I2C_EV_IRQHandler(void)
+{
+    IRQSTAT_ENTER();
+
+    I2C_EventHandler();
+
+    IRQSTAT_EXIT(IRQSTAT_I2C_EV);
+}
+
+/**
+  * @brief  I2C错误中断
+  * @note   无应答: 发STOP结束传输; 总线错误/仲裁丢失: 恢复总线
+  */
+void SENSORS_I2C_ER_IRQHandler(void)
+{
+    uint16_t sr1 = SENSORS_I2C->SR1;
+
+    /* 清除错误标志 */
+    SENSORS_I2C->SR1 = sr1 & (uint16_t)~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR | I2C_SR1_TIMEOUT);
+
+    if (i2c_cur == 0) {
+        return;
     }
 
-    /* 产生停止信号 */
-    I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+    if (sr1 & (I2C_SR1_BERR | I2C_SR1_ARLO)) {
+        I2C_Abort(I2C_XFER_BUS_ERROR);
+    }
+    else if (sr1 & I2C_SR1_AF) {
+        I2C_StopRxDma();
+        I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+        I2C_Finish(I2C_XFER_NACK);
+    }
+}
 
-    return 0;
+/**
+  * @brief  I2C接收DMA完成中断
+  * @note   最后一个字节已回NACK，发STOP结束传输
+  */
+void SENSORS_I2C_RX_DMA_IRQHandler(void)
+{
+    IRQSTAT_ENTER();
+
+    if (DMA_GetITStatus(SENSORS_I2C_RX_DMA_IT_TC) == SET) {
+        DMA_ClearITPendingBit(SENSORS_I2C_RX_DMA_IT_TC);
+        I2C_GenerateSTOP(SENSORS_I2C, ENABLE);
+        I2C_StopRxDma();
+        I2C_Finish(I2C_XFER_OK);
+    }
+
+    IRQSTAT_EXIT(IRQSTAT_I2C_DMA);
 }
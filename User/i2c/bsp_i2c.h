@@ -6,11 +6,39 @@
 #include "stm32f10x_i2c.h"
 #include "stm32f10x_gpio.h"
 #include "stm32f10x_rcc.h"
+#include "stm32f10x_dma.h"
+#include "kconfig.h"
 
 /* MAX30102 I2C地址 */
 #define I2C_WRITE_ADDR 0xAE
 #define I2C_READ_ADDR  0xAF
 
+#ifdef OLED_USE_HW_I2C
+/* I2C1已重映射到PB8/PB9供OLED使用，传感器改接I2C2 */
+#define SENSORS_I2C              I2C2
+#define SENSORS_I2C_CLK          RCC_APB1Periph_I2C2
+
+/* I2C引脚定义 */
+#define SENSORS_I2C_SCL_GPIO_PORT   GPIOB
+#define SENSORS_I2C_SCL_GPIO_CLK    RCC_APB2Periph_GPIOB
+#define SENSORS_I2C_SCL_GPIO_PIN    GPIO_Pin_10
+ 
+#define SENSORS_I2C_SDA_GPIO_PORT   GPIOB
+#define SENSORS_I2C_SDA_GPIO_CLK    RCC_APB2Periph_GPIOB
+#define SENSORS_I2C_SDA_GPIO_PIN    GPIO_Pin_11
+
+/* 中断与接收DMA（I2C2_RX固定为DMA1通道5） */
+#define SENSORS_I2C_EV_IRQn         I2C2_EV_IRQn
+#define SENSORS_I2C_ER_IRQn         I2C2_ER_IRQn
+#define SENSORS_I2C_EV_IRQHandler   I2C2_EV_IRQHandler
+#define SENSORS_I2C_ER_IRQHandler   I2C2_ER_IRQHandler
+
+#define SENSORS_I2C_RX_DMA_CH       DMA1_Channel5
+#define SENSORS_I2C_RX_DMA_IRQn     DMA1_Channel5_IRQn
+#define SENSORS_I2C_RX_DMA_IRQHandler DMA1_Channel5_IRQHandler
+#define SENSORS_I2C_RX_DMA_IT_TC    DMA1_IT_TC5
+#define SENSORS_I2C_RX_DMA_FLAG_GL  DMA1_FLAG_GL5
+#else
 /* I2C外设定义 */
 #define SENSORS_I2C              I2C1
 #define SENSORS_I2C_CLK          RCC_APB1Periph_I2C1
@@ -24,12 +52,60 @@
 #define SENSORS_I2C_SDA_GPIO_CLK    RCC_APB2Periph_GPIOB
 #define SENSORS_I2C_SDA_GPIO_PIN    GPIO_Pin_7
 
+/* 中断与接收DMA（I2C1_RX固定为DMA1通道7，通道6留给串口2接收） */
+#define SENSORS_I2C_EV_IRQn         I2C1_EV_IRQn
+#define SENSORS_I2C_ER_IRQn         I2C1_ER_IRQn
+#define SENSORS_I2C_EV_IRQHandler   I2C1_EV_IRQHandler
+#define SENSORS_I2C_ER_IRQHandler   I2C1_ER_IRQHandler
+
+#define SENSORS_I2C_RX_DMA_CH       DMA1_Channel7
+#define SENSORS_I2C_RX_DMA_IRQn     DMA1_Channel7_IRQn
+#define SENSORS_I2C_RX_DMA_IRQHandler DMA1_Channel7_IRQHandler
+#define SENSORS_I2C_RX_DMA_IT_TC    DMA1_IT_TC7
+#define SENSORS_I2C_RX_DMA_FLAG_GL  DMA1_FLAG_GL7
+#endif
+
 /* I2C超时时间 */
 #define I2C_TIMEOUT             ((uint32_t)0x1000)
 #define I2C_LONG_TIMEOUT        ((uint32_t)(10 * I2C_TIMEOUT))
+#define I2C_XFER_TIMEOUT_MS     20      /* 单次传输超时，192字节@400kHz约需5ms */
+
+#define I2C_QUEUE_SIZE          4       /* 传输队列长度 */
+
+/* 传输状态 */
+#define I2C_XFER_OK             0       /* 完成 */
+#define I2C_XFER_PENDING        1       /* 排队或进行中 */
+#define I2C_XFER_NACK           2       /* 地址或数据无应答 */
+#define I2C_XFER_BUS_ERROR      3       /* 总线错误/仲裁丢失，已恢复总线 */
+#define I2C_XFER_TIMEOUT        4       /* 超时，已恢复总线 */
+
+/**
+  * @brief  I2C传输描述
+  * @note   先写tx_buf，再以重复起始读rx_buf；任一长度可为0
+  *         提交后直到回调或status不为PENDING前，描述和缓冲区须保持有效
+  */
+typedef struct I2C_Xfer I2C_Xfer_t;
+
+struct I2C_Xfer {
+    uint8_t  addr;                      /* 8位写地址，如 I2C_WRITE_ADDR */
+    const uint8_t *tx_buf;              /* 写数据（通常为寄存器地址） */
+    uint16_t tx_len;
+    uint8_t  *rx_buf;                   /* 读数据，2字节以上用DMA接收 */
+    uint16_t rx_len;
+    void (*callback)(I2C_Xfer_t *xfer); /* 完成回调，在中断中调用，可为NULL */
+    volatile uint8_t status;            /* I2C_XFER_xxx */
+};
+
+/* 统计 */
+extern uint32_t i2c_error_count;        /* 出错的传输次数 */
+extern uint32_t i2c_recover_count;      /* 总线恢复次数 */
 
 /* 函数声明 */
 void I2cMaster_Init(void);
+uint8_t i2c_submit(I2C_Xfer_t *xfer);
+uint8_t i2c_is_idle(void);
+void i2c_poll(void);
+uint8_t i2c_write_read(uint8_t addr, const uint8_t *tx_buf, uint16_t tx_len, uint8_t *rx_buf, uint16_t rx_len);
 uint8_t i2c_transmit(uint8_t *pdata, uint8_t data_size);
 uint8_t i2c_receive(uint8_t *pdata, uint8_t data_size);
 void delay_ms(uint16_t ms);
@@ -18,7 +18,8 @@
 /**
  * @brief  启用调试页面
  * @note   启用后:
- *         - 新增第3页调试页面，显示循环时间、ADC值等信息
+ *         - 新增第3页调试页面，显示CPU占用率、ADC值和各队列丢弃计数
+ *         - 新增第4页任务统计页面，显示各任务执行时间和错过截止时间次数
  *         - 页面以10Hz刷新
  *         - 会略微增加代码体积
  * 
@@ -28,10 +29,39 @@
 
 /**
  * @brief  启用串口调试输出
- * @note   启用后可通过printf输出调试信息到串口
+ * @note   启用后可通过printf输出调试信息到串口（USART1, PA9, 115200），
+ *         并每100ms输出一行任务统计表
  */
 // #define ENABLE_UART_DEBUG
 
+/**
+ * @brief  启用采样数据记录
+ * @note   启用后PPG的FIFO原始数据、ECG的ADC值和电极状态带时间戳
+ *         以二进制记录格式经USART1 (PA9, 115200) DMA发出（格式见 module/trace/trace.h），
+ *         录下的文件可在主机上用 host_replay 重放。
+ *         与串口调试输出共用USART1，同时启用时不再输出任务统计表
+ */
+// #define ENABLE_TRACE_RECORD
+
+/**
+ * @brief  基准测试版本
+ * @note   启用后上电不启动采样和任务调度，用DWT周期计数器测量各热点函数
+ *         （FIR、心率、血氧、ECG处理与渲染、OLED刷新、串口、I2C）单次调用的周期数，
+ *         每5秒经USART1 (PA9, 115200) 输出一份逗号分隔的报告（格式见 module/bench/bench.h），
+ *         用于建立性能基线和比较不同版本
+ */
+// #define ENABLE_BENCHMARK
+
+/**
+ * @brief  启用中断延迟与抖动统计
+ * @note   启用后各中断服务函数入口和出口用DWT周期计数器打时间戳，
+ *         按中断源统计延迟、执行时间和相邻两次进入的抖动（格式见 module/irqstat/irqstat.h）:
+ *         - 调试页面之后新增第5页，显示各中断源的最大值 (us)
+ *         - 在该页按K2清零；同时启用串口调试输出时先经USART1输出完整直方图再清零
+ *         每次中断增加几十个周期
+ */
+// #define ENABLE_IRQ_STAT
+
 /**
  * @brief  启用LED状态指示
  * @note   启用后LED会根据系统状态闪烁
@@ -67,11 +97,24 @@
 /*============================================================================*/
 
 /**
- * @brief  心率检测缓存数量
- * @note   值越大检测越稳定，但响应越慢
- *         推荐范围: 100-200
+ * @brief  心率输出频率 (Hz)
+ * @note   心率逐点增量检测，每秒按此频率更新显示值
  */
-#define HR_CACHE_NUMS           150
+#define HR_OUTPUT_FREQ          2
+
+/**
+ * @brief  心率取中值的心跳间期个数
+ * @note   值越大越抗误检，但心率变化时跟随越慢
+ *         推荐范围: 3-7
+ */
+#define HR_MEDIAN_BEATS         5
+
+/**
+ * @brief  血氧平均的心跳拍数
+ * @note   每拍计算一次R值，取最近若干拍平均后换算血氧
+ *         推荐范围: 2-8
+ */
+#define SPO2_AVG_BEATS          4
 
 /**
  * @brief  PPG信号检测阈值
@@ -125,22 +168,73 @@
 
 /**
  * @brief  TIM3计数器频率 (Hz)
- * @note   用于ECG采样和时间测量
- *         当前配置: 72MHz / 72 / 10 = 100kHz
+ * @note   TIM3自由运行，兼作10us时间戳和多速率调度的比较基准
+ *         当前配置: 72MHz / 720 = 100kHz
  */
 #define TIM3_COUNTER_FREQ       100000
 
 /**
  * @brief  ECG采样频率 (Hz)
- * @note   TIM3_COUNTER_FREQ / 500 = 200Hz
+ * @note   由TIM2 CC2硬件触发ADC1，DMA搬运，不占用CPU
+ *         可选: 200 / 500 / 1000 (须为200的整数倍，波形按200Hz抽取显示)
  */
 #define ECG_SAMPLE_FREQ         200
 
+/**
+ * @brief  ECG DMA半缓冲回调频率 (Hz)
+ * @note   每个半缓冲包含 ECG_SAMPLE_FREQ / ECG_BLOCK_FREQ 个采样点
+ */
+#define ECG_BLOCK_FREQ          50
+
+/**
+ * @brief  心率血氧处理频率 (Hz)
+ * @note   滤波、心率、血氧均按此频率计算；FIFO由将满中断触发读取，
+ *         ppg任务（MAX30102_Process，每10ms）兼查中断引脚，补读漏掉的下降沿
+ *         默认模式固定为50Hz（片上200sps，4倍平均）
+ *         高采样率模式可选: 50 / 100
+ */
+#define PPG_SAMPLE_FREQ         50
+
+/**
+ * @brief  MAX30102高采样率模式
+ * @note   启用后关闭片上平均，以 MAX30102_RAW_SPS 读取FIFO，
+ *         由MCU抗混叠滤波后抽取到 PPG_SAMPLE_FREQ:
+ *         - 环境光的50/60Hz工频在抽取前滤除，不会混叠进心率频段
+ *         - I2C读取量为默认模式的 MAX30102_RAW_SPS/50 倍
+ *
+ *         关闭: 注释此行
+ */
+// #define MAX30102_HIGH_RATE
+
+/**
+ * @brief  高采样率模式下的MAX30102采样率 (sps)
+ * @note   可选: 400 / 800（LED脉宽215us），须为 PPG_SAMPLE_FREQ 的整数倍
+ */
+#define MAX30102_RAW_SPS        400
+
+/**
+ * @brief  调度基准频率 (Hz)
+ * @note   TIM3按此频率扫描按键并分频出1Hz计时；
+ *         显示任务以此频率调用，各页面刷新频率由此分频得到，必须能被这些频率整除
+ */
+#define SCHED_BASE_FREQ         100
+
+/**
+ * @brief  心率页面刷新频率 (Hz)
+ */
+#define DISPLAY_REFRESH_FREQ    5
+
 /**
  * @brief  调试页面刷新频率 (Hz)
  */
 #define DEBUG_PAGE_REFRESH_FREQ 10
 
+/**
+ * @brief  ECG波形渲染帧率 (Hz)
+ * @note   主循环按此帧率取出新采样点绘制，并只刷新变化的列
+ */
+#define ECG_RENDER_FPS          25
+
 /*============================================================================*/
 /*                              OLED配置                                       */
 /*============================================================================*/
@@ -155,6 +249,18 @@
  */
 #define OLED_HEIGHT             64
 
+/**
+ * @brief  OLED使用硬件I2C + DMA传输
+ * @note   启用后:
+ *         - I2C1重映射到PB8/PB9驱动OLED，页数据由DMA1通道6发送
+ *         - 可使用非阻塞的 OLED_UpdateAsync()，发送在后台完成
+ *         - MAX30102改接I2C2 (SCL-PB10, SDA-PB11)，需同步修改接线
+ *         - DMA1通道6被占用，USART2接收不能再使用DMA
+ * 
+ *         关闭: 注释此行，使用GPIO模拟I2C（PB8/PB9）
+ */
+// #define OLED_USE_HW_I2C
+
 /*============================================================================*/
 /*                              版本信息                                       */
 /*============================================================================*/
@@ -28,6 +28,20 @@
 #include "max30102_fir.h"
 #include "module/display/display.h"
 #include "module/transmit/transmit.h"
+#include "module/scheduler/scheduler.h"
+
+#if defined(ENABLE_UART_DEBUG) || defined(ENABLE_TRACE_RECORD) || defined(ENABLE_BENCHMARK)
+#include "./usart/bsp_debug_usart.h"
+#endif
+#ifdef ENABLE_TRACE_RECORD
+#include "module/trace/trace.h"
+#endif
+#ifdef ENABLE_BENCHMARK
+#include "module/bench/bench.h"
+#endif
+#ifdef ENABLE_IRQ_STAT
+#include "module/irqstat/irqstat.h"
+#endif
 
 /* =========================================函数声明区====================================== */
 
@@ -35,18 +49,32 @@ void SystemClock_Config(void);
 
 /* =========================================变量定义区====================================== */
 
-/* 10Hz显示刷新标志（由定时器置位） */
-volatile uint8_t display_refresh_flag = 0;
-
-#ifdef ENABLE_DEBUG_PAGE
-/* 调试页面刷新控制 */
-volatile uint8_t debug_refresh_flag = 0;  /* 调试页面刷新标志（由定时器置位） */
-
-/* 循环时间测量（使用TIM3的100kHz计数器，单位：10us） */
-static uint32_t loop_start_ms = 0;              /* 循环开始时的计数值 */
-uint32_t display_loop_time_ms = 0;              /* 一次循环时间（10us）- 供显示模块使用 */
-uint32_t display_loop_time_max_ms = 0;          /* 最大循环时间（10us）- 供显示模块使用 */
+/*
+ * 任务表（协作式调度，任务运行到结束，不可阻塞等待）
+ * 周期任务到期后按优先级运行，周期为0的后台任务在空闲时运行；
+ * 截止时间: 周期任务为释放到完成的最长时间，后台任务为最长执行时间
+ */
+static Sched_Task_t tasks[] = {
+    /*         名称     函数                        周期                                 截止时间                          优先级 */
+    SCHED_TASK("ecgup", Transmit_ECGUploadProcess, SCHED_MS(10),                        SCHED_MS(10),                     0),
+    SCHED_TASK("ppg",   MAX30102_Process,          SCHED_MS(10),                        SCHED_MS(20),                     1),
+    SCHED_TASK("key",   Key_Process,               SCHED_MS(20),                        SCHED_MS(50),                     2),
+    SCHED_TASK("disp",  Display_Update,            SCHED_MS(1000 / DISPLAY_TASK_FREQ),  SCHED_MS(1000 / ECG_RENDER_FPS),  3),
+    SCHED_TASK("mqtt",  Transmit_Process,          SCHED_MS(100),                       SCHED_MS(100),                    4),
+#ifdef ENABLE_LED_INDICATOR
+    SCHED_TASK("led",   LED_StatusUpdate,          SCHED_MS(100),                       SCHED_MS(100),                    5),
+#endif
+#if defined(ENABLE_UART_DEBUG) && !defined(ENABLE_TRACE_RECORD)
+    SCHED_TASK("rpt",   Sched_ReportTask,          SCHED_MS(100),                       SCHED_MS(100),                    6),
 #endif
+#ifdef ENABLE_TRACE_RECORD
+    SCHED_TASK("trace", Trace_Process,             SCHED_MS(10),                        SCHED_MS(50),                     7),
+#endif
+#if defined(ENABLE_IRQ_STAT) && defined(ENABLE_UART_DEBUG) && !defined(ENABLE_TRACE_RECORD)
+    SCHED_TASK("irq",   IrqStat_ReportTask,        SCHED_MS(100),                       SCHED_MS(100),                    8),  /* 按K2后输出中断统计 */
+#endif
+    SCHED_TASK("esp",   ESP8266_Process,           0,                                   SCHED_MS(5),                      9),  /* 后台: 应答、连接、重连 */
+};
 
 /**
  * @brief  主函数
@@ -64,6 +92,16 @@ int main(void){
     /* 初始化LED */
     LED_GPIO_Config();
     
+#if defined(ENABLE_UART_DEBUG) || defined(ENABLE_TRACE_RECORD) || defined(ENABLE_BENCHMARK)
+    DEBUG_USART_Config();    /* 调试串口，输出任务统计表、采样记录或基准报告 */
+#endif
+#ifdef ENABLE_TRACE_RECORD
+    Trace_Init();            /* 记录队列须在采集中断开始前就绪 */
+#endif
+#ifdef ENABLE_IRQ_STAT
+    IrqStat_Init();          /* 周期计数器须在各中断使能前启动 */
+#endif
+    
     /* 初始化心率血氧模块 */
     max30102_init();
     
@@ -73,56 +111,25 @@ int main(void){
     OLED_Init();
     
     usart2_init(115200);     /* 串口2初始化(PA2/PA3)为115200 esp-01s通信 */
-    ESP8266_Init();
+    ESP8266_Init();          /* 不阻塞，WiFi/MQTT在主循环中后台连接 */
     Transmit_Init();         /* 传输模块初始化 */
     
-    /* 心电图外设配置 */
-    AD_Init();
+    /* 心电图外设配置（先初始化队列，再启动ADC DMA） */
     AD8232Init();
-    Timer3_Init();
+#ifdef ENABLE_BENCHMARK
+    Bench_Run();             /* 基准测试版本: 不启动采样和调度，循环输出报告 */
+#endif
+    AD_Init();
     
-    /* 按键初始化 */
+    /* 按键初始化（键码队列须在TIM3扫描开始前就绪） */
     Key_Init();
+    Timer3_Init();
+    
+    /* 任务调度（时间基准为TIM3时间戳） */
+    Sched_Init(tasks, sizeof(tasks) / sizeof(tasks[0]));
     
     while(1){
-#ifdef ENABLE_DEBUG_PAGE
-        /* ==================== 记录循环开始时间（使用TIM3的ms计数器） ==================== */
-        loop_start_ms = tim3_ms_counter;
-#endif
-        
-        /* ==================== 按键处理 ==================== */
-        Key_Process();
-        
-        /* ==================== 心率血氧数据采集（50Hz，由定时器触发） ==================== */
-        if (max30102_process_flag)
-        {
-            max30102_process_flag = 0;
-            MAX30102_Process();
-        }
-        
-        /* ==================== 页面显示更新 ==================== */
-        Display_Update();
-        
-        /* ==================== LED状态指示 ==================== */
-#ifdef ENABLE_LED_INDICATOR
-        LED_StatusUpdate();
-#endif
-        
-        /* ==================== 数据传输处理 ==================== */
-        Transmit_Process();
-        
-        /* ==================== ECG上传处理（按键触发后分批上传） ==================== */
-        Transmit_ECGUploadProcess();
-        
-#ifdef ENABLE_DEBUG_PAGE
-        /* ==================== 计算循环时间（使用TIM3的100kHz计数器） ==================== */
-        display_loop_time_ms = tim3_ms_counter - loop_start_ms;
-        
-        /* 更新最大循环时间 */
-        if (display_loop_time_ms > display_loop_time_max_ms){
-            display_loop_time_max_ms = display_loop_time_ms;
-        }
-#endif
+        Sched_Run();
     }
 }
 
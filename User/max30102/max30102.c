@@ -1,6 +1,12 @@
 #include "max30102.h"
 #include "max30102_fir.h"
+#include "max30102_hr.h"
+#include "max30102_spo2.h"
 #include "./i2c/bsp_i2c.h"
+#include "module/ring/ring.h"
+#ifdef ENABLE_TRACE_RECORD
+#include "module/trace/trace.h"
+#endif
 #include "stm32f10x_exti.h"
 #include "misc.h"
 
@@ -11,16 +17,35 @@
 /** @brief 心率血氧数据结构体（全局，供其他模块使用） */
 MAX30102_Data_t g_max30102_data = {0, 0, 0, 0};
 
-/** @brief MAX30102处理标志（由定时器置位，主循环处理） */
-volatile uint8_t max30102_process_flag = 0;
+/** @brief FIFO将满标志（由INT引脚外部中断置位，主循环突发读取） */
+volatile uint8_t max30102_fifo_flag = 0;
+
+/** @brief FIFO溢出丢失的采样点数（读取FIFO_OV_COUNTER累加） */
+uint32_t max30102_fifo_overflow = 0;
+
+/** @brief 已读出的采样点队列（I2C中断写入，主循环取出；overrun为主循环来不及处理丢弃的点数） */
+Ring_t ppg_sample_ring;
 
 /*============================================================================*/
 /*                              私有变量                                       */
 /*============================================================================*/
 
-static float ppg_data_cache_IR[HR_CACHE_NUMS] = {0};   /**< IR通道缓存 */
-static float ppg_data_cache_RED[HR_CACHE_NUMS] = {0};  /**< RED通道缓存 */
-static uint16_t cache_counter = 0;                     /**< 缓存计数器 */
+#define PPG_SAMPLE_RING_SIZE    64  /**< 采样点队列长度（必须为2的幂，不小于FIFO深度） */
+
+#if !RING_IS_POW2(PPG_SAMPLE_RING_SIZE) || (PPG_SAMPLE_RING_SIZE < MAX30102_FIFO_DEPTH)
+#error "PPG_SAMPLE_RING_SIZE must be a power of two not smaller than MAX30102_FIFO_DEPTH"
+#endif
+
+static uint8_t fifo_burst_buf[MAX30102_FIFO_DEPTH * MAX30102_SAMPLE_BYTES];  /**< FIFO突发读取缓冲 */
+static int32_t ppg_ring_buf[PPG_SAMPLE_RING_SIZE * 2];  /**< 采样点队列存储区，IR/RED交织 */
+static int32_t ppg_raw[MAX30102_FIFO_DEPTH * 2];        /**< 取出的原始值，IR/RED交织 */
+static int32_t ppg_filtered[MAX30102_FIFO_DEPTH * 2];   /**< 块滤波输出，IR/RED交织 */
+static const uint8_t fifo_reg_addr[2] = {INTERRUPT_STATUS1, FIFO_DATA};    /**< 两次读取的起始寄存器 */
+static uint8_t fifo_regs[7];                    /**< INTERRUPT_STATUS1 ~ FIFO_RD_POINTER */
+static I2C_Xfer_t fifo_status_xfer;             /**< 状态和指针读取 */
+static I2C_Xfer_t fifo_data_xfer;               /**< FIFO数据读取 */
+static volatile uint8_t fifo_read_busy = 0;     /**< 异步读取进行中 */
+static uint8_t ppg_settle_count = 0;            /**< 手指放上后已滤波的点数，满 MAX30102_FIR_SETTLE 前不计算 */
 
 /*============================================================================*/
 /*                              私有函数                                       */
@@ -44,12 +69,12 @@ void max30102_i2c_write(uint8_t reg_adder, uint8_t data)
   * @param  reg_adder: 寄存器地址
   * @param  pdata: 数据缓冲区
   * @param  data_size: 读取长度
+  * @note   写寄存器地址后重复起始读取，中间不发STOP
   */
 void max30102_i2c_read(uint8_t reg_adder, uint8_t *pdata, uint8_t data_size)
 {
     uint8_t adder = reg_adder;
-    i2c_transmit(&adder, 1);
-    i2c_receive(pdata, data_size);
+    i2c_write_read(I2C_WRITE_ADDR, &adder, 1, pdata, data_size);
 }
 
 /**
@@ -79,10 +104,10 @@ void max30102_int_gpio_init(void)
     EXTI_InitStructure.EXTI_LineCmd = ENABLE;
     EXTI_Init(&EXTI_InitStructure);
 
-    /* 配置NVIC */
+    /* 配置NVIC（分组2，抢占优先级0~3；中断内只置标志，用最低优先级） */
     NVIC_InitStructure.NVIC_IRQChannel = MAX30102_INT_EXTI_IRQn;
-    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 5;
-    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
     NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
     NVIC_Init(&NVIC_InitStructure);
 }
@@ -97,21 +122,31 @@ void max30102_init(void)
     I2cMaster_Init();   /* 初始化I2C接口 */
 	delay_ms(500);
     
+    Ring_Init(&ppg_sample_ring, ppg_ring_buf, sizeof(ppg_ring_buf[0]) * 2, PPG_SAMPLE_RING_SIZE);
+    
     max30102_int_gpio_init();   /* 中断引脚配置 */
     
     max30102_i2c_write(MODE_CONFIGURATION, 0x40);  /* reset the device */
 	
 	delay_ms(5);
 	
-    max30102_i2c_write(INTERRUPT_ENABLE1, 0xE0);
-    max30102_i2c_write(INTERRUPT_ENABLE2, 0x00);  /* interrupt enable: FIFO almost full flag, new FIFO Data Ready,
-                                                     ambient light cancellation overflow, power ready flag, 
-                                                     internal temperature ready flag */
+    max30102_i2c_write(INTERRUPT_ENABLE1, 0x80);
+    max30102_i2c_write(INTERRUPT_ENABLE2, 0x00);  /* interrupt enable: FIFO almost full flag only,
+                                                     one interrupt per 17 samples instead of one per sample */
 	
     max30102_i2c_write(FIFO_WR_POINTER, 0x00);
     max30102_i2c_write(FIFO_OV_COUNTER, 0x00);
     max30102_i2c_write(FIFO_RD_POINTER, 0x00);   /* clear the pointer */
 	
+#ifdef MAX30102_HIGH_RATE
+    max30102_i2c_write(FIFO_CONFIGURATION, 0x0F); /* FIFO configuration: no sample averaging, FIFO rolls on full(0), 
+                                                     FIFO almost full value(15 empty data samples when interrupt is issued) */
+	
+    max30102_i2c_write(MODE_CONFIGURATION, 0x03);  /* MODE configuration: SpO2 mode */
+	
+    max30102_i2c_write(SPO2_CONFIGURATION, MAX30102_SPO2_CONFIG_HIGH_RATE); /* SpO2 configuration: ACD resolution:15.63pA,
+                                                     sample rate control:MAX30102_RAW_SPS, LED pulse width:215 us */
+#else
     max30102_i2c_write(FIFO_CONFIGURATION, 0x4F); /* FIFO configuration: sample averaging(4), FIFO rolls on full(0), 
                                                      FIFO almost full value(15 empty data samples when interrupt is issued) */
 	
@@ -119,6 +154,7 @@ void max30102_init(void)
 	
     max30102_i2c_write(SPO2_CONFIGURATION, 0x2A); /* SpO2 configuration: ACD resolution:15.63pA, sample rate control:200Hz, 
                                                      LED pulse width:215 us */
+#endif
 	
     max30102_i2c_write(LED1_PULSE_AMPLITUDE, 0x2f);   /* IR LED */
     max30102_i2c_write(LED2_PULSE_AMPLITUDE, 0x2f);   /* RED LED current */
@@ -131,9 +167,9 @@ void max30102_init(void)
 
 /**
   * @brief  读取MAX30102 FIFO数据
-  * @param  output_data: 输出数据 (float数组, 至少2个元素)
+  * @param  output_data: 输出数据 (至少2个元素)
   */
-void max30102_fifo_read(float *output_data)
+void max30102_fifo_read(int32_t *output_data)
 {
     uint8_t receive_data[6];
 	uint32_t data[2];
@@ -145,74 +181,107 @@ void max30102_fifo_read(float *output_data)
 }
 
 /**
-  * @brief  计算心率
-  * @param  input_data: 输入PPG数据
-  * @param  cache_nums: 数据点数量
-  * @retval 心率值 (次/分)
+  * @brief  MAX30102 INT引脚是否有效（低电平）
+  * @retval 1: 有未处理的中断
+  * @note   INT为开漏低有效，读INTERRUPT_STATUS1后释放
+  */
+static uint8_t max30102_int_pending(void)
+{
+    return GPIO_ReadInputDataBit(MAX30102_INT_GPIO_Port, MAX30102_INT_Pin) == Bit_RESET;
+}
+
+/**
+  * @brief  FIFO数据读取完成回调（I2C中断中调用）
+  * @note   解包后放入采样点队列，突发缓冲随即可用于下一次读取
   */
-uint16_t max30102_getHeartRate(float *input_data, uint16_t cache_nums)
+static void max30102_fifo_data_done(I2C_Xfer_t *xfer)
 {
-		float input_data_sum_aver = 0;
-    uint16_t i, temp;
-		
-    for(i = 0; i < cache_nums; i++) {
-        input_data_sum_aver += *(input_data + i);
-		}
-    input_data_sum_aver = input_data_sum_aver / cache_nums;
+    uint8_t count;
+    uint8_t i;
+    const uint8_t *p;
+    int32_t sample[2];
     
-    for(i = 0; i < cache_nums; i++) {
-        if((*(input_data + i) > input_data_sum_aver) && (*(input_data + i + 1) < input_data_sum_aver)) {
-					temp = i;
-					break;
-				}
-		}
-		i++;
-    for(; i < cache_nums; i++) {
-        if((*(input_data + i) > input_data_sum_aver) && (*(input_data + i + 1) < input_data_sum_aver)) {
-					temp = i - temp;
-					break;
-				}
-		}
+    if (xfer->status == I2C_XFER_OK)
+    {
+        count = (uint8_t)(xfer->rx_len / MAX30102_SAMPLE_BYTES);
+#ifdef ENABLE_TRACE_RECORD
+        Trace_RecordPPG(fifo_burst_buf, count);
+#endif
+        for (i = 0; i < count; i++)
+        {
+            p = &fifo_burst_buf[i * MAX30102_SAMPLE_BYTES];
+            sample[0] = ((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) & 0x03ffff;
+            sample[1] = ((uint32_t)p[3] << 16 | (uint32_t)p[4] << 8 | p[5]) & 0x03ffff;
+            Ring_Put(&ppg_sample_ring, sample);
+        }
+    }
+    fifo_read_busy = 0;
+}
+
+/**
+  * @brief  状态和FIFO指针读取完成回调（I2C中断中调用）
+  * @note   由 WR_PTR/OVF_COUNTER/RD_PTR 算出未读点数，接着提交FIFO数据读取
+  */
+static void max30102_fifo_status_done(I2C_Xfer_t *xfer)
+{
+    uint8_t count;
     
-    if((temp > 14) && (temp < 100)) {
-        /* SpO2采样频率200Hz，FIFO采样平均设置值为4，所以实际采集采样频率约为50Hz */
-        return 3000 / temp;  /* 计算一次的间隔是0.02s，temp是一个心跳周期中的采样数，所以一次心跳是temp/50秒,一分钟心跳数是60/(temp/50) */
-    } else {
-			return 0;
-		}
+    if (xfer->status != I2C_XFER_OK)
+    {
+        fifo_read_busy = 0;
+        return;
+    }
+    
+    if (fifo_regs[5] != 0)
+    {
+        max30102_fifo_overflow += fifo_regs[5];
+        count = MAX30102_FIFO_DEPTH;
+    }
+    else
+    {
+        count = (fifo_regs[4] - fifo_regs[6]) & (MAX30102_FIFO_DEPTH - 1);
+    }
+    
+    if (count == 0)
+    {
+        fifo_read_busy = 0;
+        return;
+    }
+    
+    fifo_data_xfer.rx_len = count * MAX30102_SAMPLE_BYTES;
+    if (i2c_submit(&fifo_data_xfer))
+    {
+        fifo_read_busy = 0;
+    }
 }
 
 /**
-  * @brief  计算血氧饱和度
-  * @param  ir_input_data: IR通道数据
-  * @param  red_input_data: RED通道数据
-  * @param  cache_nums: 数据点数量
-  * @retval 血氧值 (%)
+  * @brief  开始异步读取FIFO中所有未读采样点
+  * @note   两次I2C传输，均为写寄存器地址后重复起始读取:
+  *         1. 0x00起读7字节: 中断状态（读后INT释放）和 WR_PTR/OVF_COUNTER/RD_PTR
+  *         2. FIFO_DATA读出全部采样，DMA接收
+  *         完成后由回调解包放入 ppg_sample_ring，等待下一次 MAX30102_Process 处理
   */
-float max30102_getSpO2(float *ir_input_data, float *red_input_data, uint16_t cache_nums)
+static void max30102_fifo_read_start(void)
 {
-    float ir_max = *ir_input_data, ir_min = *ir_input_data;
-    float red_max = *red_input_data, red_min = *red_input_data;
-			float R;
-			uint16_t i;
+    fifo_status_xfer.addr = I2C_WRITE_ADDR;
+    fifo_status_xfer.tx_buf = &fifo_reg_addr[0];
+    fifo_status_xfer.tx_len = 1;
+    fifo_status_xfer.rx_buf = fifo_regs;
+    fifo_status_xfer.rx_len = sizeof(fifo_regs);
+    fifo_status_xfer.callback = max30102_fifo_status_done;
     
-    for(i = 1; i < cache_nums; i++) {
-        if(ir_max < *(ir_input_data + i)) {
-            ir_max = *(ir_input_data + i);
-				}
-        if(ir_min > *(ir_input_data + i)) {
-            ir_min = *(ir_input_data + i);
-				}
-        if(red_max < *(red_input_data + i)) {
-            red_max = *(red_input_data + i);
-				}
-        if(red_min > *(red_input_data + i)) {
-            red_min = *(red_input_data + i);
-				}
-			}
+    fifo_data_xfer.addr = I2C_WRITE_ADDR;
+    fifo_data_xfer.tx_buf = &fifo_reg_addr[1];
+    fifo_data_xfer.tx_len = 1;
+    fifo_data_xfer.rx_buf = fifo_burst_buf;
+    fifo_data_xfer.callback = max30102_fifo_data_done;
     
-    R = ((ir_max - ir_min) * red_min) / ((red_max - red_min) * ir_min);
-    return ((-45.060) * R * R + 30.354 * R + 94.845);
+    fifo_read_busy = 1;
+    if (i2c_submit(&fifo_status_xfer))
+    {
+        fifo_read_busy = 0;
+    }
 }
 
 /*============================================================================*/
@@ -221,51 +290,96 @@ float max30102_getSpO2(float *ir_input_data, float *red_input_data, uint16_t cac
 
 /**
  * @brief  心率血氧数据处理
- * @note   在主循环中调用，完成数据采集、滤波和计算
+ * @note   由调度器周期调用（见main.c任务表）:
+ *         1. 取出采样点队列中所有已读出的采样处理
+ *         2. 有中断标志或INT引脚为低（漏掉了下降沿）时，开始下一次异步读取
+ *         I2C收发和解包由中断和DMA完成，主循环只做滤波和计算；
+ *         主循环被阻塞时数据先留在队列，再留在32级FIFO中，恢复后一次处理
  */
 void MAX30102_Process(void)
 {
-    float max30102_data[2];
-    float fir_output[2];
+    uint8_t count;
+    uint8_t i;
     
-    /* 读取FIFO数据 */
-    max30102_fifo_read(max30102_data);
+    i2c_poll();     /* 传输卡死时超时恢复 */
+    
+    /* 1. 处理队列中已读出的采样，每块不超过FIFO深度 */
+    while ((count = (uint8_t)Ring_GetN(&ppg_sample_ring, ppg_raw, MAX30102_FIFO_DEPTH)) > 0)
+    {
+#ifdef MAX30102_HIGH_RATE
+        /* 抗混叠抽取到 PPG_SAMPLE_FREQ，原地输出 */
+        count = (uint8_t)max30102_decimate_block(ppg_raw, ppg_raw, count);
+#endif
+        
+        /* 整块滤波，两通道一趟完成 */
+        max30102_fir_block(ppg_raw, ppg_filtered, count);
+        
+        for (i = 0; i < count; i++)
+        {
+            MAX30102_ProcessSample(&ppg_raw[i * 2], &ppg_filtered[i * 2]);
+        }
+    }
     
-    /* FIR滤波 */
-    ir_max30102_fir(&max30102_data[0], &fir_output[0]);
-    red_max30102_fir(&max30102_data[1], &fir_output[1]);
+    /* 2. 开始下一次读取 */
+    if (fifo_read_busy)
+    {
+        return;
+    }
+    if (!max30102_fifo_flag && !max30102_int_pending())
+    {
+        return;
+    }
+    max30102_fifo_flag = 0;
     
+    max30102_fifo_read_start();
+}
+
+/**
+ * @brief  处理一个采样点
+ * @param  max30102_data: [0]=IR, [1]=RED 原始值
+ * @param  fir_output: [0]=IR, [1]=RED 滤波后的值（max30102_fir_block）
+ * @note   手指检测、逐点更新心率、每拍更新血氧；
+ *         手指放上后先跳过 MAX30102_FIR_SETTLE 点，等滤波器输出稳定
+ */
+void MAX30102_ProcessSample(const int32_t *max30102_data, const int32_t *fir_output)
+{
     /* 检测手指是否放置 */
     if ((max30102_data[0] > PPG_DATA_THRESHOLD) && (max30102_data[1] > PPG_DATA_THRESHOLD))
     {
-        /* 手指检测到，缓存数据 */
+        /* 手指检测到 */
         g_max30102_data.finger_detected = 1;
         
-        ppg_data_cache_IR[cache_counter] = fir_output[0];
-        ppg_data_cache_RED[cache_counter] = fir_output[1];
-        cache_counter++;
+        /* 滤波器历史中还有手指放上前的数据，输出为阶跃响应，
+           用来初始化心率的均值方差和血氧的DC会使其偏离数秒 */
+        if (ppg_settle_count < MAX30102_FIR_SETTLE)
+        {
+            ppg_settle_count++;
+            return;
+        }
+        
+        /* 逐点检测心跳，按 HR_OUTPUT_FREQ 更新心率 */
+        if (MAX30102_HR_Update(fir_output[0]))
+        {
+            g_max30102_data.heart_rate = MAX30102_HR_Get();
+            g_max30102_data.data_ready = 1;
+        }
         
-        /* 缓存满，计算心率和血氧 */
-        if (cache_counter >= HR_CACHE_NUMS)
+        /* 以心跳分段，每拍更新血氧 */
+        if (MAX30102_SpO2_Update(fir_output[0], fir_output[1], MAX30102_HR_IsBeat()))
         {
-            cache_counter = 0;
-            
-            /* 计算心率（带低通滤波） */
-            g_max30102_data.heart_rate =  (uint16_t)max30102_getHeartRate(ppg_data_cache_IR, HR_CACHE_NUMS);
-            
-            /* 计算血氧 */
-            g_max30102_data.spo2 = (uint16_t)max30102_getSpO2(ppg_data_cache_IR, ppg_data_cache_RED, HR_CACHE_NUMS);
-            
-            /* 标记数据就绪 */
+            g_max30102_data.spo2 = MAX30102_SpO2_Get();
             g_max30102_data.data_ready = 1;
         }
     }
     else
     {
         /* 手指未检测到，重置状态 */
-        cache_counter = 0;
+        MAX30102_HR_Reset();
+        MAX30102_SpO2_Reset();
+        ppg_settle_count = 0;
         g_max30102_data.finger_detected = 0;
         g_max30102_data.heart_rate = 0;
+        g_max30102_data.spo2 = 0;
         g_max30102_data.data_ready = 0;
     }
 }
@@ -4,6 +4,7 @@
 #include "stm32f10x.h"
 #include <stdint.h>
 #include "kconfig.h"
+#include "module/ring/ring.h"
 
 /*============================================================================*/
 /*                              数据结构定义                                   */
@@ -26,9 +27,19 @@ typedef struct {
 extern MAX30102_Data_t g_max30102_data;
 
 /**
- * @brief  MAX30102处理标志（由定时器置位，主循环处理）
+ * @brief  FIFO将满标志（由INT引脚外部中断置位，主循环突发读取）
  */
-extern volatile uint8_t max30102_process_flag;
+extern volatile uint8_t max30102_fifo_flag;
+
+/**
+ * @brief  FIFO溢出丢失的采样点数
+ */
+extern uint32_t max30102_fifo_overflow;
+
+/**
+ * @brief  已读出的采样点队列（元素为IR/RED两个int32_t，overrun: 主循环来不及处理丢弃的点数）
+ */
+extern Ring_t ppg_sample_ring;
 
 /*============================================================================*/
 /*                              引脚定义                                       */
@@ -43,6 +54,21 @@ extern volatile uint8_t max30102_process_flag;
 #define MAX30102_INT_EXTI_PinSource GPIO_PinSource5
 #define MAX30102_INT_EXTI_IRQn      EXTI9_5_IRQn
 
+/* FIFO参数 */
+#define MAX30102_FIFO_DEPTH         32  /**< FIFO深度（采样点） */
+#define MAX30102_SAMPLE_BYTES       6   /**< 每个采样点字节数（IR+RED各3字节） */
+
+#ifdef MAX30102_HIGH_RATE
+/* SPO2_CONFIGURATION: ADC量程[6:5]=01, 采样率[4:2], LED脉宽[1:0]=10(215us) */
+#if (MAX30102_RAW_SPS == 400)
+#define MAX30102_SPO2_CONFIG_HIGH_RATE  0x2E
+#elif (MAX30102_RAW_SPS == 800)
+#define MAX30102_SPO2_CONFIG_HIGH_RATE  0x32
+#else
+#error "MAX30102_RAW_SPS must be 400 or 800"
+#endif
+#endif
+
 /* I2C地址 */
 #define I2C_WRITE_ADDR 0xAE
 #define I2C_READ_ADDR  0xAF
@@ -83,24 +109,27 @@ void max30102_int_gpio_init(void);
 void max30102_init(void);
 
 /* 底层读写函数 */
-void max30102_fifo_read(float *data);
+void max30102_fifo_read(int32_t *data);
 void max30102_i2c_read(uint8_t reg_adder, uint8_t *pdata, uint8_t data_size);
 
-/* 数据处理函数（内部使用） */
-uint16_t max30102_getHeartRate(float *input_data, uint16_t cache_nums);
-float max30102_getSpO2(float *ir_input_data, float *red_input_data, uint16_t cache_nums);
-
 /**
  * @brief  心率血氧数据处理（主循环调用）
  * @note   此函数完成以下工作:
- *         1. 读取FIFO数据
- *         2. FIR滤波
- *         3. 数据缓存
- *         4. 计算心率和血氧
+ *         1. 异步突发读取FIFO中全部采样（FIFO将满中断或INT引脚为低时）
+ *         2. 整块FIR滤波（IR/RED交织，对称折叠）
+ *         3. 逐点检测心跳，更新心率
+ *         4. 每拍计算血氧
  *         5. 更新 g_max30102_data 结构体
  */
 void MAX30102_Process(void);
 
+/**
+ * @brief  处理一个采样点
+ * @param  max30102_data: [0]=IR, [1]=RED 原始值
+ * @param  fir_output: [0]=IR, [1]=RED 滤波后的值
+ */
+void MAX30102_ProcessSample(const int32_t *max30102_data, const int32_t *fir_output);
+
 /**
  * @brief  获取心率血氧数据指针
  * @retval 指向 MAX30102_Data_t 结构体的指针
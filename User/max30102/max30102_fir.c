@@ -9,40 +9,71 @@
   *          滤波器参数:
   *          - 类型: 低通滤波器
   *          - 阶数: 29阶
-  *          - 采样率: 50Hz (MAX30102 200Hz采样，4倍平均后为50Hz)
+  *          - 采样率: PPG_SAMPLE_FREQ (默认50Hz，MAX30102 200Hz采样，4倍平均)
   *          - 截止频率: 约5Hz (保留心率信号0.5-4Hz，滤除高频噪声)
   *          
   *          滤波器系数通过MATLAB的fdatool工具生成
+  *
+  *          STM32F103没有FPU，系数表仍写浮点值，由Q31()在编译期换算，
+  *          运算全部为整数乘加（64位累加）。
+  *
+  *          原来每通道每点调用一次arm_fir_q31，每次都要搬状态、建循环；
+  *          现按FIFO突发整块处理，IR和RED交织存放、同一趟循环滤波，
+  *          并利用系数对称 h[k] = h[28-k]，先加后乘，29次乘法减为15次:
+  *
+  *          y = h[14]*x[14] + Σ h[k] * (x[k] + x[28-k]),  k = 0..13
+  *
+  *          高采样率模式(MAX30102_HIGH_RATE)下前面再加一级抽取滤波:
+  *
+  *          MAX30102_RAW_SPS ──> 抗混叠低通，只算保留的输出点 ──> PPG_SAMPLE_FREQ ──> 上述低通
+  *
+  *          抽取比M = MAX30102_RAW_SPS / PPG_SAMPLE_FREQ，抽头数4M，
+  *          每M个输入只计算一个输出（等效于多相结构，丢弃的点不计算），
+  *          系数在初始化时按汉明窗sinc设计，截止频率 PPG_SAMPLE_FREQ/5
   ******************************************************************************
   */
 
 #include "max30102_fir.h"
+#include "kconfig.h"
+#include <string.h>
+#ifdef MAX30102_HIGH_RATE
+#include <math.h>
+#endif
 
 /*============================ 宏定义 ============================*/
 
-#define BLOCK_SIZE    1     /**< 每次调用arm_fir_f32处理的采样点数 */
-#define NUM_TAPS      29    /**< FIR滤波器阶数（抽头数/系数个数）*/
+#define NUM_TAPS      MAX30102_FIR_TAPS    /**< FIR滤波器阶数（抽头数/系数个数）*/
+#define FIR_HALF      (NUM_TAPS / 2)   /**< 中心抽头序号 */
+#define FIR_CH        2     /**< 交织通道数: IR, RED */
 
-/*============================ 私有变量 ============================*/
+#ifdef MAX30102_HIGH_RATE
+#define DEC_FACTOR    (MAX30102_RAW_SPS / PPG_SAMPLE_FREQ)  /**< 抽取比 */
+#define DEC_TAPS      (4 * DEC_FACTOR)     /**< 抽取滤波器抽头数（偶数，对称；改动时同步 MAX30102_FIR_SETTLE） */
+#define DEC_HALF      (DEC_TAPS / 2)
+#define DEC_CUTOFF    ((float)PPG_SAMPLE_FREQ / 5 / MAX30102_RAW_SPS)  /**< 归一化截止频率 */
 
-uint32_t blockSize = BLOCK_SIZE;
-uint32_t numBlocks = BLOCK_SIZE;    /**< 需要调用arm_fir_f32的次数 */
+#if (MAX30102_RAW_SPS % PPG_SAMPLE_FREQ) != 0 || (DEC_FACTOR < 2)
+#error "MAX30102_RAW_SPS must be a multiple (>= 2x) of PPG_SAMPLE_FREQ"
+#endif
+#endif
 
-/**
- * @brief FIR滤波器实例
- * @note  IR通道和RED通道各需要一个独立的滤波器实例
- *        因为每个滤波器需要维护自己的状态缓冲区
- */
-arm_fir_instance_f32 S_ir;      /**< IR通道滤波器实例 */
-arm_fir_instance_f32 S_red;     /**< RED通道滤波器实例 */
+/** 浮点系数编译期转换为Q31（四舍五入） */
+#define Q31(x)  ((q31_t)((x) * 2147483648.0 + (((x) >= 0) ? 0.5 : -0.5)))
+
+/*============================ 私有变量 ============================*/
 
 /**
  * @brief FIR滤波器状态缓冲区
- * @note  状态缓冲区大小 = numTaps + blockSize - 1
- *        用于存储滤波器的历史输入数据
+ * @note  前 NUM_TAPS-1 组为历史数据，后面接本块新数据，IR/RED交织
+ *        大小 = (numTaps - 1 + blockSize) * 通道数
  */
-static float firStateF32_ir[BLOCK_SIZE + NUM_TAPS - 1];     /**< IR通道状态缓冲区 */
-static float firStateF32_red[BLOCK_SIZE + NUM_TAPS - 1];    /**< RED通道状态缓冲区 */
+static q31_t firState[(NUM_TAPS - 1 + MAX30102_FIR_BLOCK_MAX) * FIR_CH];
+
+#ifdef MAX30102_HIGH_RATE
+static q31_t decCoeffs[DEC_HALF];      /**< 抽取滤波器系数（前半，初始化时设计） */
+static q31_t decState[(DEC_TAPS - 1 + MAX30102_FIR_BLOCK_MAX) * FIR_CH];  /**< 抽取滤波器状态，IR/RED交织 */
+static uint8_t decPhase = 0;           /**< 距上一个输出点的输入点数 */
+#endif
 
 /**
  * @brief 低通滤波器系数（通过MATLAB fdatool生成）
@@ -50,7 +81,7 @@ static float firStateF32_red[BLOCK_SIZE + NUM_TAPS - 1];    /**< RED通道状态
  * @details 滤波器特性:
  *          - 窗函数: 汉明窗 (Hamming Window)
  *          - 对称结构: 线性相位FIR滤波器
- *          - 系数呈对称分布: h[n] = h[N-1-n]
+ *          - 系数呈对称分布: h[n] = h[N-1-n]，只存前15个
  *          
  *          系数分布图示:
  *          
@@ -64,98 +95,169 @@ static float firStateF32_red[BLOCK_SIZE + NUM_TAPS - 1];    /**< RED通道状态
  *               └─────────────────────
  *                0                  28 (阶数)
  */
-const float firCoeffs32LP[NUM_TAPS] = {
-    -0.001542701735, -0.002211477375, -0.003286228748, -0.00442651147,  -0.004758632276,
-    -0.003007677384,  0.002192312852,  0.01188309677,   0.02637642808,   0.04498152807,
-     0.06596207619,   0.0867607221,    0.1044560149,    0.1163498312,    0.1205424443,   /* 中心系数最大 */
-     0.1163498312,    0.1044560149,    0.0867607221,    0.06596207619,   0.04498152807,
-     0.02637642808,   0.01188309677,   0.002192312852, -0.003007677384, -0.004758632276,
-    -0.00442651147,  -0.003286228748, -0.002211477375, -0.001542701735
+static const q31_t firCoeffsQ31LP[FIR_HALF + 1] = {
+    Q31(-0.001542701735), Q31(-0.002211477375), Q31(-0.003286228748), Q31(-0.00442651147),  Q31(-0.004758632276),
+    Q31(-0.003007677384), Q31( 0.002192312852), Q31( 0.01188309677),  Q31( 0.02637642808),  Q31( 0.04498152807),
+    Q31( 0.06596207619),  Q31( 0.0867607221),   Q31( 0.1044560149),   Q31( 0.1163498312),   Q31( 0.1205424443)    /* 中心系数最大 */
 };
 
 /*============================ 函数实现 ============================*/
 
+#ifdef MAX30102_HIGH_RATE
+/**
+ * @brief  设计抽取滤波器系数
+ * @note   汉明窗sinc，直流增益归一化为1，浮点运算只在初始化时执行一次
+ */
+static void max30102_decimate_design(void)
+{
+    float h[DEC_HALF];
+    float sum = 0.0f;
+    float t, w;
+    uint16_t k;
+    
+    for (k = 0; k < DEC_HALF; k++)
+    {
+        t = (float)k - (DEC_TAPS - 1) / 2.0f;  /* 偶数抽头，t为半整数，不会为0 */
+        w = 0.54f - 0.46f * cosf(2.0f * PI * k / (DEC_TAPS - 1));
+        h[k] = sinf(2.0f * PI * DEC_CUTOFF * t) / (PI * t) * w;
+        sum += 2.0f * h[k];
+    }
+    
+    for (k = 0; k < DEC_HALF; k++)
+    {
+        decCoeffs[k] = (q31_t)(h[k] / sum * 2147483648.0f + 0.5f);
+    }
+}
+#endif
+
 /**
  * @brief  FIR滤波器初始化
- * 
- * @details 初始化IR和RED两个通道的FIR滤波器实例
- *          使用ARM CMSIS-DSP库的arm_fir_init_f32函数
- *          
- *          初始化后的滤波器结构:
- *          
- *          输入 ──► [Z⁻¹]──► [Z⁻¹]──► ... ──► [Z⁻¹]
- *                     │        │               │
- *                     ▼        ▼               ▼
- *                   [h₀]     [h₁]    ...    [h₂₈]
- *                     │        │               │
- *                     └────────┴───────────────┘
- *                               │
- *                               ▼ Σ
- *                             输出
- * 
- * @param  无
- * @retval 无
+ * @note   清空历史数据，两通道从零状态开始
  */
 void max30102_fir_init(void)
 {
-    /* 初始化IR通道FIR滤波器 */
-    arm_fir_init_f32(&S_ir,                     /* 滤波器实例指针 */
-                     NUM_TAPS,                   /* 滤波器阶数 */
-                     (float32_t *)&firCoeffs32LP[0],  /* 滤波器系数数组 */
-                     &firStateF32_ir[0],         /* 状态缓冲区 */
-                     blockSize);                 /* 每次处理的采样点数 */
+    memset(firState, 0, sizeof(firState));
     
-    /* 初始化RED通道FIR滤波器 */
-    arm_fir_init_f32(&S_red,                    /* 滤波器实例指针 */
-                     NUM_TAPS,                   /* 滤波器阶数 */
-                     (float32_t *)&firCoeffs32LP[0],  /* 滤波器系数数组 */
-                     &firStateF32_red[0],        /* 状态缓冲区 */
-                     blockSize);                 /* 每次处理的采样点数 */
+#ifdef MAX30102_HIGH_RATE
+    memset(decState, 0, sizeof(decState));
+    decPhase = 0;
+    max30102_decimate_design();
+#endif
 }
 
+#ifdef MAX30102_HIGH_RATE
 /**
- * @brief  IR通道FIR滤波
+ * @brief  IR和RED通道抽取滤波
  * 
- * @details 对IR（红外）通道的PPG信号进行低通滤波
- *          滤除高频噪声，保留心率信号成分
- *          
- *          滤波公式:
- *          y[n] = Σ(h[k] * x[n-k]), k = 0 to NUM_TAPS-1
- *          
- *          其中:
- *          - x[n]: 输入信号（当前采样值）
- *          - y[n]: 输出信号（滤波后的值）
- *          - h[k]: 滤波器系数
+ * @details 输入为 MAX30102_RAW_SPS 的原始数据，每 DEC_FACTOR 个点输出一个，
+ *          只计算保留的输出点；系数对称折叠，乘法次数减半
  * 
- * @param  input:  输入数据指针（原始PPG数据）
- * @param  output: 输出数据指针（滤波后的数据）
- * @retval 无
+ * @param  input:  输入数据，IR/RED交织（18位原始值）
+ * @param  output: 输出数据，格式同输入，可与input相同（原地抽取）
+ * @param  count:  输入采样点组数
+ * @retval 输出采样点组数
  */
-void ir_max30102_fir(float *input, float *output)
+uint16_t max30102_decimate_block(const int32_t *input, int32_t *output, uint16_t count)
 {
-    arm_fir_f32(&S_ir,      /* 滤波器实例 */
-                input,       /* 输入数据 */
-                output,      /* 输出数据 */
-                blockSize);  /* 处理的采样点数 */
+    uint16_t blk, n, k;
+    uint16_t out_n = 0;
+    const q31_t *x;
+    int64_t acc_ir, acc_red;
+    
+    while (count > 0)
+    {
+        blk = (count > MAX30102_FIR_BLOCK_MAX) ? MAX30102_FIR_BLOCK_MAX : count;
+        
+        memcpy(&decState[(DEC_TAPS - 1) * FIR_CH], input, blk * FIR_CH * sizeof(q31_t));
+        
+        for (n = 0; n < blk; n++)
+        {
+            if (++decPhase < DEC_FACTOR)
+            {
+                continue;   /* 被抽掉的点不计算 */
+            }
+            decPhase = 0;
+            
+            x = &decState[n * FIR_CH];
+            acc_ir = 0;
+            acc_red = 0;
+            for (k = 0; k < DEC_HALF; k++)
+            {
+                acc_ir  += (int64_t)(x[k * FIR_CH] + x[(DEC_TAPS - 1 - k) * FIR_CH])
+                         * decCoeffs[k];
+                acc_red += (int64_t)(x[k * FIR_CH + 1] + x[(DEC_TAPS - 1 - k) * FIR_CH + 1])
+                         * decCoeffs[k];
+            }
+            
+            /* 输出点不会超过已取走的输入，原地抽取安全 */
+            output[out_n * FIR_CH]     = (int32_t)((acc_ir + ((int64_t)1 << 30)) >> 31);
+            output[out_n * FIR_CH + 1] = (int32_t)((acc_red + ((int64_t)1 << 30)) >> 31);
+            out_n++;
+        }
+        
+        memmove(decState, &decState[blk * FIR_CH], (DEC_TAPS - 1) * FIR_CH * sizeof(q31_t));
+        
+        input += blk * FIR_CH;
+        count -= blk;
+    }
+    
+    return out_n;
 }
+#endif
 
 /**
- * @brief  RED通道FIR滤波
+ * @brief  IR和RED通道块滤波
  * 
- * @details 对RED（红光）通道的PPG信号进行低通滤波
- *          滤除高频噪声，保留心率信号成分
- *          
+ * @details 对PPG信号进行低通滤波，滤除高频噪声，保留心率信号成分
  *          RED通道主要用于血氧饱和度(SpO2)的计算:
  *          SpO2 = f(AC_red/DC_red, AC_ir/DC_ir)
+ *          
+ *          每块先把新数据接在历史数据之后，逐点计算，最后把末尾
+ *          NUM_TAPS-1 组移到缓冲区开头作为下一块的历史
  * 
- * @param  input:  输入数据指针（原始PPG数据）
- * @param  output: 输出数据指针（滤波后的数据）
+ * @param  input:  输入数据，IR/RED交织 [IR0, RED0, IR1, RED1, ...]（18位原始值）
+ * @param  output: 输出数据，格式同输入，可与input相同（原地滤波）
+ * @param  count:  采样点组数，超过 MAX30102_FIR_BLOCK_MAX 时分块处理
  * @retval 无
  */
-void red_max30102_fir(float *input, float *output)
+void max30102_fir_block(const int32_t *input, int32_t *output, uint16_t count)
 {
-    arm_fir_f32(&S_red,     /* 滤波器实例 */
-                input,       /* 输入数据 */
-                output,      /* 输出数据 */
-                blockSize);  /* 处理的采样点数 */
+    uint16_t blk, n, k;
+    const q31_t *x;
+    int64_t acc_ir, acc_red;
+    
+    while (count > 0)
+    {
+        blk = (count > MAX30102_FIR_BLOCK_MAX) ? MAX30102_FIR_BLOCK_MAX : count;
+        
+        /* 新数据接在历史之后（先取走输入，允许原地输出） */
+        memcpy(&firState[(NUM_TAPS - 1) * FIR_CH], input, blk * FIR_CH * sizeof(q31_t));
+        
+        for (n = 0; n < blk; n++)
+        {
+            x = &firState[n * FIR_CH];  /* x[0]最旧，x[(NUM_TAPS-1)*FIR_CH]为当前点 */
+            
+            acc_ir  = (int64_t)x[FIR_HALF * FIR_CH] * firCoeffsQ31LP[FIR_HALF];
+            acc_red = (int64_t)x[FIR_HALF * FIR_CH + 1] * firCoeffsQ31LP[FIR_HALF];
+            
+            /* 对称折叠: 18位采样相加不会溢出 */
+            for (k = 0; k < FIR_HALF; k++)
+            {
+                acc_ir  += (int64_t)(x[k * FIR_CH] + x[(NUM_TAPS - 1 - k) * FIR_CH])
+                         * firCoeffsQ31LP[k];
+                acc_red += (int64_t)(x[k * FIR_CH + 1] + x[(NUM_TAPS - 1 - k) * FIR_CH + 1])
+                         * firCoeffsQ31LP[k];
+            }
+            
+            output[n * FIR_CH]     = (int32_t)((acc_ir + ((int64_t)1 << 30)) >> 31);
+            output[n * FIR_CH + 1] = (int32_t)((acc_red + ((int64_t)1 << 30)) >> 31);
+        }
+        
+        /* 保留最后 NUM_TAPS-1 组作为历史 */
+        memmove(firState, &firState[blk * FIR_CH], (NUM_TAPS - 1) * FIR_CH * sizeof(q31_t));
+        
+        input += blk * FIR_CH;
+        output += blk * FIR_CH;
+        count -= blk;
+    }
 }
@@ -3,10 +3,21 @@
 
 #include "arm_math.h"
 #include "arm_const_structs.h"
+#include "kconfig.h"
 
+#define MAX30102_FIR_BLOCK_MAX  32  /**< 每块最多采样点组数（与FIFO深度相同） */
+#define MAX30102_FIR_TAPS       29  /**< 低通滤波器抽头数 */
+
+/** 滤波器历史全部换成新数据所需的输出点数，手指刚放上时此前的输出含阶跃响应 */
+#ifdef MAX30102_HIGH_RATE
+#define MAX30102_FIR_SETTLE     (MAX30102_FIR_TAPS - 1 + 4)     /* 抽取滤波器4M抽头，折合4个输出点 */
+#else
+#define MAX30102_FIR_SETTLE     (MAX30102_FIR_TAPS - 1)
+#endif
 
 void max30102_fir_init(void);
-void ir_max30102_fir(float *input,float *output);
-void red_max30102_fir(float *input,float *output);
+void max30102_fir_block(const int32_t *input, int32_t *output, uint16_t count);
+#ifdef MAX30102_HIGH_RATE
+uint16_t max30102_decimate_block(const int32_t *input, int32_t *output, uint16_t count);
+#endif
 #endif /* __MAX30102_FIR_H */
-
@@ -0,0 +1,290 @@
+/**
+  ******************************************************************************
+  * @file    max30102_hr.c
+  * @brief   PPG增量心率检测
+  *
+  * @details 原算法攒满150点(3秒)后求均值，只取前两次下降过均值的
+  *          间隔作为单次心跳周期，3秒更新一次。现改为逐点增量处理:
+  *
+  *          采样 ──> 滑动均值/方差 ──> 带回差的下降过零检测 ──> [心跳时刻环形队列]
+  *                                                                    │
+  *          每 1/HR_OUTPUT_FREQ 秒: 最近 HR_MEDIAN_BEATS 个间期取中值 <─┘
+  *
+  *          - 均值和方差为指数滑动平均，整数运算，每点O(1)
+  *          - 均值用双重指数平均补偿滞后，基线缓慢漂移时偏差不会整体偏向一侧
+  *          - 信号先越过 +0.5σ 才允许检测，再越过 -0.5σ 才确认，抑制噪声抖动
+  *          - 过零时刻在两点间线性插值，精度1/16采样点（50Hz下约1.25ms，100Hz下约0.6ms）
+  *          - 间期小于 60/HR_BPM_MAX 秒视为误检，大于 60/HR_BPM_MIN 秒重新计数
+  *          - 偏差达到限幅（基线跳变）时，此后0.6s均值直接跟随输入，方差清零，再照常检测
+  *          - 均值初始化后半个时间常数内的过零不计，避免首个间期偏差
+  *          - 尚无心率时每拍都计算，首个心率不等输出时刻
+  ******************************************************************************
+  */
+
+#include "max30102_hr.h"
+
+/*============================================================================*/
+/*                              宏定义                                         */
+/*============================================================================*/
+
+/* 时间常数按采样率换算，约0.64s */
+#if (HR_SAMPLE_FREQ >= 100)
+#define HR_MEAN_SHIFT       6       /**< 均值时间常数 2^6 = 64点 */
+#else
+#define HR_MEAN_SHIFT       5       /**< 均值时间常数 2^5 = 32点 */
+#endif
+#define HR_VAR_SHIFT        HR_MEAN_SHIFT   /**< 方差时间常数 */
+#define HR_DEV_LIMIT        32767   /**< 偏差限幅，保证平方不溢出 */
+#define HR_RESEED_HOLD      (HR_SAMPLE_FREQ * 3 / 5)   /**< 基线跳变后跟随的点数 (0.6s)，长于低通滤波器的阶跃响应 */
+
+#define HR_FRAC_BITS        4       /**< 心跳时刻小数位（1/16采样点） */
+#define HR_MIN_INTERVAL     ((HR_SAMPLE_FREQ * 60 / HR_BPM_MAX) << HR_FRAC_BITS)
+#define HR_MAX_INTERVAL     ((HR_SAMPLE_FREQ * 60 / HR_BPM_MIN) << HR_FRAC_BITS)
+
+#define HR_BEAT_RING_SIZE   8       /**< 心跳时刻队列长度（2的幂，大于HR_MEDIAN_BEATS） */
+#define HR_BEAT_RING_MASK   (HR_BEAT_RING_SIZE - 1)
+
+#define HR_OUTPUT_DIV       (HR_SAMPLE_FREQ / HR_OUTPUT_FREQ)  /**< 每隔多少点输出一次 */
+
+#if (HR_MEDIAN_BEATS >= HR_BEAT_RING_SIZE)
+#error "HR_MEDIAN_BEATS must be smaller than HR_BEAT_RING_SIZE"
+#endif
+
+/*============================================================================*/
+/*                              私有变量                                       */
+/*============================================================================*/
+
+static uint8_t  hr_initialized = 0;     /**< 均值是否已用首点初始化 */
+static int32_t  hr_mean_acc = 0;        /**< 均值 << HR_MEAN_SHIFT */
+static int32_t  hr_trend_acc = 0;       /**< 均值的均值 << HR_MEAN_SHIFT，用于滞后补偿 */
+static int32_t  hr_var = 0;             /**< 偏差平方的滑动平均 */
+static int32_t  hr_prev_dev = 0;        /**< 上一点偏差 */
+static uint8_t  hr_above = 0;           /**< 1: 已越过上阈值，等待下降 */
+static uint32_t hr_crossing = 0;        /**< 候选下降过零时刻 (Q4) */
+static uint32_t hr_sample_idx = 0;      /**< 采样点计数 */
+static uint8_t  hr_hold = 0;            /**< 基线跳变后剩余的跟随点数 */
+static uint8_t  hr_warmup = 0;          /**< 重新初始化后均值未收敛的剩余点数，其间的过零不计 */
+
+static uint32_t hr_beat_ring[HR_BEAT_RING_SIZE];  /**< 心跳时刻 (Q4) */
+static uint8_t  hr_beat_head = 0;       /**< 写索引 */
+static uint8_t  hr_beat_count = 0;      /**< 连续有效心跳数 */
+static uint8_t  hr_beat_flag = 0;       /**< 本点确认了一次心跳 */
+
+static uint16_t hr_output_div = 0;      /**< 输出分频计数 */
+static uint16_t hr_bpm = 0;             /**< 当前心率 */
+
+/*============================================================================*/
+/*                              私有函数                                       */
+/*============================================================================*/
+
+/**
+ * @brief  以当前点重新初始化均值和方差
+ * @param  sample: 滤波后的IR值
+ * @note   已记录的心跳保留，间期仍按原时刻计算
+ */
+static void MAX30102_HR_Seed(int32_t sample)
+{
+    hr_mean_acc = sample * (1 << HR_MEAN_SHIFT);   /* 负值左移未定义，用乘法 */
+    hr_trend_acc = hr_mean_acc;
+    hr_var = 0;
+    hr_prev_dev = 0;
+    hr_above = 0;
+    hr_warmup = 1 << (HR_MEAN_SHIFT - 1);
+    hr_initialized = 1;
+}
+
+/**
+ * @brief  记录一次心跳
+ * @param  t: 心跳时刻 (Q4)
+ */
+static void MAX30102_HR_AddBeat(uint32_t t)
+{
+    uint32_t interval;
+
+    if (hr_beat_count > 0)
+    {
+        interval = t - hr_beat_ring[(hr_beat_head - 1) & HR_BEAT_RING_MASK];
+
+        if (interval < HR_MIN_INTERVAL)
+        {
+            return;             /* 不应期内，重搏波等误检 */
+        }
+        if (interval > HR_MAX_INTERVAL)
+        {
+            hr_beat_count = 0;  /* 中断过久，重新计数 */
+        }
+    }
+
+    hr_beat_ring[hr_beat_head & HR_BEAT_RING_MASK] = t;
+    hr_beat_head++;
+    hr_beat_flag = 1;
+    if (hr_beat_count < HR_BEAT_RING_SIZE)
+    {
+        hr_beat_count++;
+    }
+}
+
+/**
+ * @brief  由最近的心跳间期计算心率
+ * @retval 心率 (bpm)，有效间期不足2个或信号中断时为0
+ */
+static uint16_t MAX30102_HR_Compute(void)
+{
+    uint32_t intervals[HR_MEDIAN_BEATS];
+    uint32_t last, v;
+    uint8_t n, i, j;
+
+    if (hr_beat_count < 3)
+    {
+        return 0;
+    }
+
+    last = hr_beat_ring[(hr_beat_head - 1) & HR_BEAT_RING_MASK];
+    if (((hr_sample_idx << HR_FRAC_BITS) - last) > HR_MAX_INTERVAL)
+    {
+        return 0;               /* 太久没有心跳 */
+    }
+
+    /* 取最近n个间期，插入排序 */
+    n = hr_beat_count - 1;
+    if (n > HR_MEDIAN_BEATS)
+    {
+        n = HR_MEDIAN_BEATS;
+    }
+    for (i = 0; i < n; i++)
+    {
+        v = hr_beat_ring[(hr_beat_head - 1 - i) & HR_BEAT_RING_MASK]
+          - hr_beat_ring[(hr_beat_head - 2 - i) & HR_BEAT_RING_MASK];
+
+        for (j = i; j > 0 && intervals[j - 1] > v; j--)
+        {
+            intervals[j] = intervals[j - 1];
+        }
+        intervals[j] = v;
+    }
+
+    v = intervals[n / 2];
+
+    return (uint16_t)((((uint32_t)(HR_SAMPLE_FREQ * 60) << HR_FRAC_BITS) + v / 2) / v);
+}
+
+/*============================================================================*/
+/*                              函数实现                                       */
+/*============================================================================*/
+
+/**
+ * @brief  复位心率检测（手指离开时调用）
+ */
+void MAX30102_HR_Reset(void)
+{
+    hr_initialized = 0;
+    hr_hold = 0;
+    hr_var = 0;
+    hr_prev_dev = 0;
+    hr_above = 0;
+    hr_beat_count = 0;
+    hr_beat_flag = 0;
+    hr_output_div = 0;
+    hr_bpm = 0;
+}
+
+/**
+ * @brief  输入一个滤波后的IR采样点
+ * @param  sample: FIR滤波后的IR值
+ * @retval 1: 到达输出时刻（尚无心率时每拍都是），心率已更新; 0: 未更新
+ */
+uint8_t MAX30102_HR_Update(int32_t sample)
+{
+    int32_t dev;
+    int32_t dev2;
+    int32_t threshold2;
+
+    hr_sample_idx++;
+    hr_beat_flag = 0;
+
+    if (!hr_initialized)
+    {
+        MAX30102_HR_Seed(sample);
+    }
+
+    /* 滑动均值（2*e1 - e2 抵消斜坡滞后）与方差 */
+    hr_mean_acc += sample - (hr_mean_acc >> HR_MEAN_SHIFT);
+    hr_trend_acc += (hr_mean_acc >> HR_MEAN_SHIFT) - (hr_trend_acc >> HR_MEAN_SHIFT);
+    dev = sample - 2 * (hr_mean_acc >> HR_MEAN_SHIFT) + (hr_trend_acc >> HR_MEAN_SHIFT);
+    if (dev >= HR_DEV_LIMIT || dev <= -HR_DEV_LIMIT)
+    {
+        /* 基线跳变（手指按压变化、运动），方差会被撑大数秒，
+           等滤波器输出走完阶跃后从新的基线重新开始 */
+        hr_hold = HR_RESEED_HOLD;
+    }
+    if (hr_hold > 0)
+    {
+        hr_hold--;
+        MAX30102_HR_Seed(sample);
+        dev = 0;
+    }
+    dev2 = dev * dev;
+    hr_var += (dev2 - hr_var) >> HR_VAR_SHIFT;
+
+    /* 回差阈值 (0.5σ)^2 */
+    threshold2 = hr_var >> 2;
+
+    /* 下降过零检测 */
+    if (!hr_above)
+    {
+        if (dev > 0 && dev2 > threshold2)
+        {
+            hr_above = 1;
+        }
+    }
+    else
+    {
+        if (hr_prev_dev >= 0 && dev < 0)
+        {
+            /* 过零点在上一点和本点之间线性插值 */
+            hr_crossing = ((hr_sample_idx - 1) << HR_FRAC_BITS)
+                        + (uint32_t)((hr_prev_dev << HR_FRAC_BITS) / (hr_prev_dev - dev));
+        }
+        if (dev < 0 && dev2 > threshold2)
+        {
+            hr_above = 0;
+            if (hr_warmup == 0)
+            {
+                MAX30102_HR_AddBeat(hr_crossing);
+            }
+        }
+    }
+    hr_prev_dev = dev;
+    if (hr_warmup > 0)
+    {
+        hr_warmup--;
+    }
+
+    /* 按输出频率更新心率，尚无心率时每拍即算，首个值不必等到输出时刻 */
+    if (++hr_output_div < HR_OUTPUT_DIV && !(hr_bpm == 0 && hr_beat_flag))
+    {
+        return 0;
+    }
+    hr_output_div = 0;
+    hr_bpm = MAX30102_HR_Compute();
+
+    return 1;
+}
+
+/**
+ * @brief  获取当前心率
+ * @retval 心率 (bpm)，心跳不足或信号中断时为0
+ */
+uint16_t MAX30102_HR_Get(void)
+{
+    return hr_bpm;
+}
+
+/**
+ * @brief  上一次 MAX30102_HR_Update 是否确认了心跳
+ * @retval 1: 是; 0: 否
+ */
+uint8_t MAX30102_HR_IsBeat(void)
+{
+    return hr_beat_flag;
+}
@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    max30102_hr.h
+  * @brief   PPG增量心率检测头文件
+  ******************************************************************************
+  */
+
+#ifndef __MAX30102_HR_H
+#define __MAX30102_HR_H
+
+#include <stdint.h>
+#include "kconfig.h"
+
+/*============================================================================*/
+/*                              参数定义                                       */
+/*============================================================================*/
+
+#define HR_SAMPLE_FREQ      PPG_SAMPLE_FREQ     /**< PPG处理频率 (Hz) */
+#define HR_BPM_MIN          30      /**< 心率下限，间期超过时重新开始计数 */
+#define HR_BPM_MAX          200     /**< 心率上限，间期小于时视为误检（不应期） */
+
+#if (HR_SAMPLE_FREQ != 50) && (HR_SAMPLE_FREQ != 100)
+#error "PPG_SAMPLE_FREQ must be 50 or 100"
+#endif
+
+/*============================================================================*/
+/*                              函数声明                                       */
+/*============================================================================*/
+
+/**
+ * @brief  复位心率检测（手指离开时调用）
+ */
+void MAX30102_HR_Reset(void);
+
+/**
+ * @brief  输入一个滤波后的IR采样点
+ * @param  sample: FIR滤波后的IR值
+ * @retval 1: 到达输出时刻（尚无心率时每拍都是），心率已更新; 0: 未更新
+ * @note   每点O(1)，不再扫描整个缓存
+ */
+uint8_t MAX30102_HR_Update(int32_t sample);
+
+/**
+ * @brief  获取当前心率
+ * @retval 心率 (bpm)，心跳不足或信号中断时为0
+ */
+uint16_t MAX30102_HR_Get(void);
+
+/**
+ * @brief  上一次 MAX30102_HR_Update 是否确认了心跳
+ * @retval 1: 是; 0: 否
+ * @note   供逐拍血氧计算分段使用
+ */
+uint8_t MAX30102_HR_IsBeat(void);
+
+#endif /* __MAX30102_HR_H */
@@ -0,0 +1,234 @@
+/**
+  ******************************************************************************
+  * @file    max30102_spo2.c
+  * @brief   PPG逐拍血氧计算
+  *
+  * @details 原算法在150点(3秒)缓存中找两通道的全局最大/最小值，
+  *          基线漂移和手指移动都会被算进AC分量。现改为逐点处理:
+  *
+  *          - DC: 每通道一个指数低通，时间常数约1.3秒
+  *          - AC: 以心率检测给出的心跳为分段，段内峰谷差
+  *          - 每拍求一次 R = (AC_ir/DC_ir) / (AC_red/DC_red)，
+  *            与原 max30102_getSpO2 的定义相同，标定多项式不变
+  *          - 最近 SPO2_AVG_BEATS 拍的R取平均后换算血氧，每拍更新一次
+  ******************************************************************************
+  */
+
+#include "max30102_spo2.h"
+#include "max30102_hr.h"
+
+/*============================================================================*/
+/*                              宏定义                                         */
+/*============================================================================*/
+
+#if (HR_SAMPLE_FREQ >= 100)
+#define SPO2_DC_SHIFT       7       /**< DC低通时间常数 2^7 = 128点 (1.28s) */
+#else
+#define SPO2_DC_SHIFT       6       /**< DC低通时间常数 2^6 = 64点 (1.28s) */
+#endif
+#define SPO2_R_SHIFT        10      /**< R值定点小数位 (Q10) */
+#define SPO2_R_MAX          (3 << SPO2_R_SHIFT)     /**< R超出此值视为无效拍 */
+#define SPO2_MAX_SEGMENT    (HR_SAMPLE_FREQ * 60 / HR_BPM_MIN)  /**< 最长一拍的点数 */
+
+/*============================================================================*/
+/*                              类型定义                                       */
+/*============================================================================*/
+
+/**
+ * @brief  单通道逐拍统计
+ */
+typedef struct {
+    int32_t dc_acc;     /**< DC << SPO2_DC_SHIFT */
+    int32_t peak;       /**< 本拍最大值 */
+    int32_t trough;     /**< 本拍最小值 */
+} SpO2_Channel_t;
+
+/*============================================================================*/
+/*                              私有变量                                       */
+/*============================================================================*/
+
+static SpO2_Channel_t spo2_ir;
+static SpO2_Channel_t spo2_red;
+static uint8_t  spo2_initialized = 0;   /**< DC是否已用首点初始化 */
+static uint8_t  spo2_in_beat = 0;       /**< 1: 已见到心跳，正在统计一拍 */
+static uint16_t spo2_segment_len = 0;   /**< 本拍已统计的点数 */
+
+static uint16_t spo2_r_ring[SPO2_AVG_BEATS];    /**< 最近各拍的R (Q10) */
+static uint32_t spo2_r_sum = 0;         /**< spo2_r_ring 之和 */
+static uint8_t  spo2_r_head = 0;
+static uint8_t  spo2_r_count = 0;
+
+static uint16_t spo2_value = 0;         /**< 当前血氧 */
+
+/*============================================================================*/
+/*                              私有函数                                       */
+/*============================================================================*/
+
+/**
+ * @brief  更新单通道DC和峰谷
+ */
+static void MAX30102_SpO2_Track(SpO2_Channel_t *ch, int32_t x)
+{
+    ch->dc_acc += x - (ch->dc_acc >> SPO2_DC_SHIFT);
+
+    if (x > ch->peak)
+    {
+        ch->peak = x;
+    }
+    if (x < ch->trough)
+    {
+        ch->trough = x;
+    }
+}
+
+/**
+ * @brief  开始统计新的一拍
+ */
+static void MAX30102_SpO2_StartBeat(int32_t ir, int32_t red)
+{
+    spo2_ir.peak = spo2_ir.trough = ir;
+    spo2_red.peak = spo2_red.trough = red;
+    spo2_segment_len = 0;
+    spo2_in_beat = 1;
+}
+
+/**
+ * @brief  结束一拍，计算R
+ * @retval R (Q10)，无效拍返回0
+ */
+static uint16_t MAX30102_SpO2_BeatRatio(void)
+{
+    int32_t ac_ir = spo2_ir.peak - spo2_ir.trough;
+    int32_t ac_red = spo2_red.peak - spo2_red.trough;
+    int32_t dc_ir = spo2_ir.dc_acc >> SPO2_DC_SHIFT;
+    int32_t dc_red = spo2_red.dc_acc >> SPO2_DC_SHIFT;
+    uint64_t num, den;
+
+    if (ac_ir <= 0 || ac_red <= 0 || dc_ir <= 0 || dc_red <= 0)
+    {
+        return 0;
+    }
+
+    num = ((uint64_t)ac_ir * (uint32_t)dc_red) << SPO2_R_SHIFT;
+    den = (uint64_t)ac_red * (uint32_t)dc_ir;
+    if (num >= den * (SPO2_R_MAX + 1))
+    {
+        return 0;   /* 运动伪影，两通道AC不成比例 */
+    }
+
+    return (uint16_t)(num / den);
+}
+
+/*============================================================================*/
+/*                              函数实现                                       */
+/*============================================================================*/
+
+/**
+ * @brief  复位血氧计算（手指离开时调用）
+ */
+void MAX30102_SpO2_Reset(void)
+{
+    spo2_initialized = 0;
+    spo2_in_beat = 0;
+    spo2_r_sum = 0;
+    spo2_r_head = 0;
+    spo2_r_count = 0;
+    spo2_value = 0;
+}
+
+/**
+ * @brief  输入一对滤波后的采样点
+ * @param  ir: FIR滤波后的IR值
+ * @param  red: FIR滤波后的RED值
+ * @param  beat: 1表示本点检测到心跳（MAX30102_HR_IsBeat）
+ * @retval 1: 完成一拍，血氧已更新; 0: 未更新
+ */
+uint8_t MAX30102_SpO2_Update(int32_t ir, int32_t red, uint8_t beat)
+{
+    uint16_t r;
+
+    if (!spo2_initialized)
+    {
+        spo2_ir.dc_acc = ir * (1 << SPO2_DC_SHIFT);    /* 负值左移未定义，用乘法 */
+        spo2_red.dc_acc = red * (1 << SPO2_DC_SHIFT);
+        spo2_initialized = 1;
+    }
+
+    MAX30102_SpO2_Track(&spo2_ir, ir);
+    MAX30102_SpO2_Track(&spo2_red, red);
+
+    if (spo2_in_beat && ++spo2_segment_len > SPO2_MAX_SEGMENT)
+    {
+        spo2_in_beat = 0;   /* 心跳中断，丢弃本拍 */
+    }
+
+    if (!beat)
+    {
+        return 0;
+    }
+
+    if (!spo2_in_beat)
+    {
+        MAX30102_SpO2_StartBeat(ir, red);
+        return 0;
+    }
+
+    r = MAX30102_SpO2_BeatRatio();
+    MAX30102_SpO2_StartBeat(ir, red);
+    if (r == 0)
+    {
+        return 0;
+    }
+
+    /* 最近 SPO2_AVG_BEATS 拍滑动平均 */
+    if (spo2_r_count < SPO2_AVG_BEATS)
+    {
+        spo2_r_count++;
+    }
+    else
+    {
+        spo2_r_sum -= spo2_r_ring[spo2_r_head];
+    }
+    spo2_r_ring[spo2_r_head] = r;
+    spo2_r_sum += r;
+    if (++spo2_r_head >= SPO2_AVG_BEATS)
+    {
+        spo2_r_head = 0;
+    }
+
+    spo2_value = (uint16_t)(MAX30102_SpO2_FromRatio((uint16_t)(spo2_r_sum / spo2_r_count)) / 1000);
+
+    return 1;
+}
+
+/**
+ * @brief  标定多项式 -45.060R² + 30.354R + 94.845，定点计算
+ * @param  r: R (Q10)，不超过 3 << 10
+ * @retval 血氧饱和度，单位0.001%，限制在 0 ~ 100000
+ */
+uint32_t MAX30102_SpO2_FromRatio(uint16_t r)
+{
+    int32_t R = r;
+    int32_t spo2;
+
+    spo2 = (-45060 * ((R * R) >> SPO2_R_SHIFT) + 30354 * R) >> SPO2_R_SHIFT;
+    spo2 += 94845;
+    if (spo2 < 0)
+    {
+        spo2 = 0;
+    }
+    else if (spo2 > 100000)
+    {
+        spo2 = 100000;
+    }
+    return (uint32_t)spo2;
+}
+
+/**
+ * @brief  获取当前血氧
+ * @retval 血氧饱和度 (%)，有效心跳不足时为0
+ */
+uint16_t MAX30102_SpO2_Get(void)
+{
+    return spo2_value;
+}
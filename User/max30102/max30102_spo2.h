@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file    max30102_spo2.h
+  * @brief   PPG逐拍血氧计算头文件
+  ******************************************************************************
+  */
+
+#ifndef __MAX30102_SPO2_H
+#define __MAX30102_SPO2_H
+
+#include <stdint.h>
+#include "kconfig.h"
+
+/*============================================================================*/
+/*                              函数声明                                       */
+/*============================================================================*/
+
+/**
+ * @brief  复位血氧计算（手指离开时调用）
+ */
+void MAX30102_SpO2_Reset(void);
+
+/**
+ * @brief  输入一对滤波后的采样点
+ * @param  ir: FIR滤波后的IR值
+ * @param  red: FIR滤波后的RED值
+ * @param  beat: 1表示本点检测到心跳（MAX30102_HR_IsBeat）
+ * @retval 1: 完成一拍，血氧已更新; 0: 未更新
+ */
+uint8_t MAX30102_SpO2_Update(int32_t ir, int32_t red, uint8_t beat);
+
+/**
+ * @brief  获取当前血氧
+ * @retval 血氧饱和度 (%)，有效心跳不足时为0
+ */
+uint16_t MAX30102_SpO2_Get(void);
+
+/**
+ * @brief  R值换算血氧（标定多项式）
+ * @param  r: R (Q10)，不超过 3 << 10
+ * @retval 血氧饱和度，单位0.001%，限制在 0 ~ 100000
+ */
+uint32_t MAX30102_SpO2_FromRatio(uint16_t r);
+
+#endif /* __MAX30102_SPO2_H */
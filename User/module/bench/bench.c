@@ -0,0 +1,418 @@
+/**
+  ******************************************************************************
+  * @file    bench.c
+  * @brief   热点函数周期基准测试
+  *
+  * @details 每个项目先调用一次预热，再重复测量，记录单次调用周期数的最少/平均/最多值:
+  *
+  *          | 名称        | 被测函数                          | 每次点数             |
+  *          |-------------|-----------------------------------|----------------------|
+  *          | fir_block   | max30102_fir_block (IR/RED两通道) | 8                    |
+  *          | decimate    | max30102_decimate_block (高采样率) | 32 -> 4              |
+  *          | hr_update   | MAX30102_HR_Update                | 1                    |
+  *          | spo2_update | MAX30102_SpO2_Update              | 1                    |
+  *          | ppg_sample  | MAX30102_ProcessSample            | 1                    |
+  *          | ecg_sample  | ECG_ProcessSample (含QRS检测)      | 1                    |
+  *          | ecg_block   | ECG_ProcessBlock (DMA中断的工作)   | AD_DMA_HALF_LEN      |
+  *          | ecg_render  | ECG_Render (一帧的新增列)          | 每帧新增的采样点     |
+  *          | oled_full   | OLED_Update (整屏全部改动)         | 1                    |
+  *          | oled_area   | OLED_UpdateArea (下方6页全部改动)  | 1                    |
+  *          | oled_none   | OLED_Update (无改动，只比较)       | 1                    |
+  *          | u2_printf   | u2_printf (一条MQTT发布指令)       | 1                    |
+  *          | i2c_receive | i2c_receive (6字节，阻塞)          | 6                    |
+  *
+  *          输入为内置的合成波形（72bpm，与主机 host_bench 相同的形状），
+  *          每个项目开始前复位相关状态，结果可在不同固件版本之间直接比较
+  ******************************************************************************
+  */
+
+#include "bench.h"
+
+#ifdef ENABLE_BENCHMARK
+
+#include "max30102.h"
+#include "max30102_fir.h"
+#include "max30102_hr.h"
+#include "max30102_spo2.h"
+#include "AD8232.h"
+#include "AD.h"
+#include "OLED.h"
+#include "key.h"
+#include "usart2.h"
+#include "./i2c/bsp_i2c.h"
+#include "stdio.h"
+
+/*============================ 私有定义 ============================*/
+
+#define BENCH_VERSION           1
+#define BENCH_REPEAT_S          5       /**< 两次报告之间的间隔 (s) */
+
+#define BENCH_PPG_BEAT          42      /**< 合成PPG一拍的点数 (50Hz下约72bpm) */
+#define BENCH_PPG_LEN           (BENCH_PPG_BEAT * 3)
+#define BENCH_ECG_BEAT          167     /**< 合成ECG一拍的点数 (200Hz下约72bpm) */
+#define BENCH_FIR_COUNT         8       /**< fir_block 每次的点数，与FIFO将满读出的点数相近 */
+#define BENCH_U2_ROOM           64      /**< u2_printf 前等待的发送队列空间 (字节) */
+#define BENCH_OLED_AREA_Y       16      /**< oled_area 的区域: 下方6页 */
+#define BENCH_RENDER_COUNT      (ECG_SAMPLE_FREQ / ECG_RENDER_FPS)
+
+/**
+  * @brief  测量项目
+  */
+typedef struct
+{
+    const char *name;
+    void (*init)(void);         /**< 测量前调用一次，可为NULL */
+    void (*setup)(void);        /**< 每次测量前调用（不计时），可为NULL */
+    void (*run)(void);          /**< 被测调用 */
+    uint16_t iterations;
+    uint16_t items;             /**< 每次调用处理的点数 */
+    uint8_t  irq_off;           /**< 1: 测量时关中断 */
+} Bench_Case_t;
+
+/*============================ 合成波形 ============================*/
+
+/** PPG脉搏波形一拍 (x1000)，收缩峰加重搏波 */
+static const int16_t bench_pulse[BENCH_PPG_BEAT] = {
+      44,   96,  186,  325,  506,  707,  883,  987,  988,  886,  715,  522,  352,  234,
+     171,  158,  178,  219,  266,  310,  339,  350,  339,  309,  264,  212,  160,  114,
+      76,   47,   28,   15,    8,    4,    2,    1,    0,    0,    0,    0,    0,    0,
+};
+
+/** ECG一拍相对基线的ADC值，带P/T波的QRS */
+static const int16_t bench_ecg_beat[BENCH_ECG_BEAT] = {
+       0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    3,    5,    8,   13,   19,   27,
+      36,   45,   53,   58,   60,   58,   53,   45,   36,   27,   19,   13,    8,    5,    3,    1,
+       1,    0,    1,    3,   20,   99,  331,  677,  854,  668,  288,    5,  -84,  -62,  -25,   -7,
+      -1,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    1,
+       1,    1,    2,    2,    3,    5,    7,    9,   12,   16,   20,   26,   32,   40,   49,   58,
+      69,   80,   91,  102,  113,  123,  132,  140,  145,  149,  150,  149,  145,  140,  132,  123,
+     113,  102,   91,   80,   69,   58,   49,   40,   32,   26,   20,   16,   12,    9,    7,    5,
+       3,    2,    2,    1,    1,    1,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,
+};
+
+/*============================ 私有变量 ============================*/
+
+static int32_t bench_ppg_raw[BENCH_PPG_LEN * 2];    /**< 合成PPG原始值，IR/RED交织 */
+static int32_t bench_ppg_fir[BENCH_PPG_LEN * 2];    /**< 滤波后的值 */
+static int32_t bench_out[MAX30102_FIFO_DEPTH * 2];  /**< 块处理输出 */
+static uint16_t bench_ecg_block[AD_DMA_HALF_LEN];
+static uint16_t bench_pos = 0;                      /**< 合成波形当前位置 */
+static uint16_t bench_ecg_pos = 0;
+static uint32_t bench_rand = 1;
+static uint32_t bench_overhead = 0;                 /**< 测量本身的周期数 */
+static uint8_t  bench_i2c_buf[6];
+
+/*============================ 私有函数 ============================*/
+
+/** 均匀噪声 [-range, range] */
+static int32_t Bench_Noise(int32_t range)
+{
+    bench_rand = bench_rand * 1664525u + 1013904223u;
+    return (int32_t)((bench_rand >> 16) % (uint32_t)(2 * range + 1)) - range;
+}
+
+/** 下一个合成ECG采样点 */
+static uint16_t Bench_NextECG(void)
+{
+    uint16_t v = (uint16_t)(2048 + bench_ecg_beat[bench_ecg_pos] + Bench_Noise(8));
+
+    if (++bench_ecg_pos >= BENCH_ECG_BEAT)
+    {
+        bench_ecg_pos = 0;
+    }
+    return v;
+}
+
+/** 合成PPG，R约0.5（血氧约98%），再整段滤波作为心率/血氧项目的输入 */
+static void Bench_PrepareInput(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < BENCH_PPG_LEN; i++)
+    {
+        bench_ppg_raw[i * 2] = 150000 - bench_pulse[i % BENCH_PPG_BEAT] * 3 / 2 + Bench_Noise(20);
+        bench_ppg_raw[i * 2 + 1] = 120000 - bench_pulse[i % BENCH_PPG_BEAT] * 12 / 5 + Bench_Noise(20);
+    }
+
+    /* 两遍，第二遍时滤波器延迟线已填满 */
+    for (i = 0; i < BENCH_PPG_LEN; i += BENCH_FIR_COUNT)
+    {
+        max30102_fir_block(&bench_ppg_raw[i * 2], &bench_ppg_fir[i * 2],
+                           (BENCH_PPG_LEN - i < BENCH_FIR_COUNT) ? BENCH_PPG_LEN - i : BENCH_FIR_COUNT);
+    }
+    for (i = 0; i < BENCH_PPG_LEN; i += BENCH_FIR_COUNT)
+    {
+        max30102_fir_block(&bench_ppg_raw[i * 2], &bench_ppg_fir[i * 2],
+                           (BENCH_PPG_LEN - i < BENCH_FIR_COUNT) ? BENCH_PPG_LEN - i : BENCH_FIR_COUNT);
+    }
+}
+
+/** 合成波形前进一点 */
+static void Bench_Advance(void)
+{
+    if (++bench_pos >= BENCH_PPG_LEN)
+    {
+        bench_pos = 0;
+    }
+}
+
+/*---------------------------- 测量项目 ----------------------------*/
+
+static void Bench_Nop(void)
+{
+}
+
+static void Bench_PosReset(void)
+{
+    bench_pos = 0;
+}
+
+static void Bench_FIR(void)
+{
+    max30102_fir_block(&bench_ppg_raw[bench_pos * 2], bench_out, BENCH_FIR_COUNT);
+    bench_pos = (bench_pos + BENCH_FIR_COUNT) % (BENCH_PPG_LEN - BENCH_FIR_COUNT);
+}
+
+#ifdef MAX30102_HIGH_RATE
+static void Bench_Decimate(void)
+{
+    max30102_decimate_block(bench_ppg_raw, bench_out, MAX30102_FIFO_DEPTH);
+}
+#endif
+
+static void Bench_HRInit(void)
+{
+    MAX30102_HR_Reset();
+    MAX30102_SpO2_Reset();
+    bench_pos = 0;
+}
+
+static void Bench_HR(void)
+{
+    MAX30102_HR_Update(bench_ppg_fir[bench_pos * 2]);
+    Bench_Advance();
+}
+
+static void Bench_SpO2(void)
+{
+    MAX30102_SpO2_Update(bench_ppg_fir[bench_pos * 2], bench_ppg_fir[bench_pos * 2 + 1],
+                         MAX30102_HR_IsBeat());
+    Bench_Advance();
+}
+
+static void Bench_PPGSample(void)
+{
+    MAX30102_ProcessSample(&bench_ppg_raw[bench_pos * 2], &bench_ppg_fir[bench_pos * 2]);
+    Bench_Advance();
+}
+
+static void Bench_ECGInit(void)
+{
+    current_page = PAGE_ECG;
+    ECG_RenderReset();
+}
+
+static void Bench_ECGSample(void)
+{
+    ECG_ProcessSample(Bench_NextECG());
+}
+
+static void Bench_ECGBlockSetup(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < AD_DMA_HALF_LEN; i++)
+    {
+        bench_ecg_block[i] = Bench_NextECG();
+    }
+}
+
+static void Bench_ECGBlock(void)
+{
+    ECG_ProcessBlock(bench_ecg_block, AD_DMA_HALF_LEN);
+}
+
+static void Bench_RenderSetup(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < BENCH_RENDER_COUNT; i++)
+    {
+        ECG_ProcessSample(Bench_NextECG());
+    }
+}
+
+static void Bench_OLEDFullSetup(void)
+{
+    OLED_Reverse();
+}
+
+static void Bench_OLEDAreaSetup(void)
+{
+    OLED_ReverseArea(0, BENCH_OLED_AREA_Y, 128, 64 - BENCH_OLED_AREA_Y);
+}
+
+static void Bench_OLEDArea(void)
+{
+    OLED_UpdateArea(0, BENCH_OLED_AREA_Y, 128, 64 - BENCH_OLED_AREA_Y);
+}
+
+static void Bench_U2Setup(void)
+{
+    while (USART2_TxFree() < BENCH_U2_ROOM);
+}
+
+static void Bench_U2Printf(void)
+{
+    u2_printf("AT+MQTTPUB=0,\"health/heartrate\",\"%d\",1,0\r\n", 72);
+}
+
+static void Bench_I2CSetup(void)
+{
+    uint8_t reg = FIFO_CONFIGURATION;     /* 从配置寄存器开始读，不影响FIFO和中断状态 */
+
+    i2c_transmit(&reg, 1);
+}
+
+static void Bench_I2CReceive(void)
+{
+    i2c_receive(bench_i2c_buf, sizeof(bench_i2c_buf));
+}
+
+static const Bench_Case_t bench_cases[] = {
+    /* 名称          init             setup                 run                    次数  点数                  关中断 */
+    { "fir_block",   Bench_PosReset,  NULL,                 Bench_FIR,             256,  BENCH_FIR_COUNT,      1 },
+#ifdef MAX30102_HIGH_RATE
+    { "decimate",    NULL,            NULL,                 Bench_Decimate,        256,  MAX30102_FIFO_DEPTH,  1 },
+#endif
+    { "hr_update",   Bench_HRInit,    NULL,                 Bench_HR,              1024, 1,                    1 },
+    { "spo2_update", Bench_HRInit,    NULL,                 Bench_SpO2,            1024, 1,                    1 },
+    { "ppg_sample",  Bench_HRInit,    NULL,                 Bench_PPGSample,       1024, 1,                    1 },
+    { "ecg_sample",  Bench_ECGInit,   NULL,                 Bench_ECGSample,       1024, 1,                    1 },
+    { "ecg_block",   Bench_ECGInit,   Bench_ECGBlockSetup,  Bench_ECGBlock,        256,  AD_DMA_HALF_LEN,      1 },
+    { "ecg_render",  Bench_ECGInit,   Bench_RenderSetup,    ECG_Render,            64,   BENCH_RENDER_COUNT,   1 },
+    { "oled_full",   NULL,            Bench_OLEDFullSetup,  OLED_Update,           16,   1,                    0 },
+    { "oled_area",   NULL,            Bench_OLEDAreaSetup,  Bench_OLEDArea,        16,   1,                    0 },
+    { "oled_none",   NULL,            NULL,                 OLED_Update,           64,   1,                    0 },
+    { "u2_printf",   NULL,            Bench_U2Setup,        Bench_U2Printf,        32,   1,                    0 },
+    { "i2c_receive", NULL,            Bench_I2CSetup,       Bench_I2CReceive,      32,   6,                    0 },
+};
+
+/**
+  * @brief  测量一个项目
+  * @param  min, avg, max: 输出单次调用周期数，已减去测量开销
+  */
+static void Bench_Measure(const Bench_Case_t *c, uint32_t *min, uint32_t *avg, uint32_t *max)
+{
+    uint32_t t0, cycles;
+    uint32_t lo = 0xFFFFFFFF, hi = 0;
+    uint64_t sum = 0;
+    uint16_t i;
+
+    if (c->init != NULL)
+    {
+        c->init();
+    }
+    if (c->setup != NULL)
+    {
+        c->setup();
+    }
+    c->run();       /* 预热，首次调用的一次性工作不计入 */
+
+    for (i = 0; i < c->iterations; i++)
+    {
+        if (c->setup != NULL)
+        {
+            c->setup();
+        }
+        if (c->irq_off)
+        {
+            __disable_irq();
+        }
+        t0 = Cycle_Now();
+        c->run();
+        cycles = Cycle_Now() - t0;
+        if (c->irq_off)
+        {
+            __enable_irq();
+        }
+
+        cycles = (cycles > bench_overhead) ? cycles - bench_overhead : 0;
+        if (cycles < lo)
+        {
+            lo = cycles;
+        }
+        if (cycles > hi)
+        {
+            hi = cycles;
+        }
+        sum += cycles;
+    }
+
+    *min = lo;
+    *avg = (uint32_t)(sum / c->iterations);
+    *max = hi;
+}
+
+/**
+  * @brief  运行全部项目并输出一份报告
+  */
+static void Bench_Report(void)
+{
+    static const Bench_Case_t nop = { "nop", NULL, NULL, Bench_Nop, 64, 1, 1 };
+    uint8_t page = current_page;
+    uint32_t min, avg, max;
+    uint8_t i;
+
+    /* 测量开销: 空函数调用的最少周期数 */
+    bench_overhead = 0;
+    Bench_Measure(&nop, &min, &avg, &max);
+    bench_overhead = min;
+
+    printf("bench,begin,version=%d,clock=%lu,overhead=%lu\r\n",
+           BENCH_VERSION, (unsigned long)SystemCoreClock, (unsigned long)bench_overhead);
+    for (i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+    {
+        Bench_Measure(&bench_cases[i], &min, &avg, &max);
+        printf("bench,%s,%u,%u,%lu,%lu,%lu\r\n", bench_cases[i].name,
+               bench_cases[i].iterations, bench_cases[i].items,
+               (unsigned long)min, (unsigned long)avg, (unsigned long)max);
+    }
+    printf("bench,end\r\n");
+
+    current_page = page;
+}
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  运行基准测试并输出报告，不返回
+  */
+void Bench_Run(void)
+{
+    uint32_t t0;
+    uint8_t s;
+
+    if (Cycle_Init())
+    {
+        printf("bench,error,no cycle counter\r\n");
+        while (1);
+    }
+    Bench_PrepareInput();
+
+    while (1)
+    {
+        Bench_Report();
+
+        for (s = 0; s < BENCH_REPEAT_S; s++)
+        {
+            t0 = Cycle_Now();
+            while (Cycle_Now() - t0 < SystemCoreClock);
+        }
+    }
+}
+
+#endif /* ENABLE_BENCHMARK */
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    bench.h
+  * @brief   DWT周期计数与基准测试头文件
+  *
+  * @details Cortex-M3 的DWT周期计数器按内核时钟计数 (72MHz下约14ns)，
+  *          比10us的TIM3时间戳精细约700倍，用于测量单次调用的开销。
+  *
+  *          基准测试版本（ENABLE_BENCHMARK）上电后不启动采样和调度，
+  *          循环运行各热点函数并经调试串口输出报告（每行逗号分隔）:
+  *
+  *          bench,begin,version=1,clock=72000000,overhead=<周期>
+  *          bench,<名称>,<次数>,<每次点数>,<最少周期>,<平均周期>,<最多周期>
+  *          ...
+  *          bench,end
+  *
+  *          周期数已减去测量本身的开销；纯计算的项目测量时关中断，
+  *          使用外设的项目（OLED、串口、I2C）开中断，最多周期可能含中断处理
+  ******************************************************************************
+  */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+#include "stm32f10x.h"
+#include "kconfig.h"
+
+/*============================ 周期计数 ============================*/
+
+/**
+  * @brief  使能DWT周期计数器
+  * @retval 0: 成功, 1: 内核未实现周期计数器
+  */
+__STATIC_INLINE uint8_t Cycle_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    if (DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk)
+    {
+        return 1;
+    }
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    return 0;
+}
+
+/**
+  * @brief  当前周期数（32位，72MHz下约60s回绕，取差值时按无符号相减）
+  */
+__STATIC_INLINE uint32_t Cycle_Now(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*============================ 基准测试 ============================*/
+
+#ifdef ENABLE_BENCHMARK
+/**
+  * @brief  运行基准测试并输出报告，不返回
+  * @note   在各模块初始化之后、启动ADC采样和TIM3之前调用
+  */
+void Bench_Run(void);
+#endif
+
+#endif
@@ -10,14 +10,27 @@
 #include "display.h"
 #include "oled.h"
 #include "ad8232.h"
+#include "ecg_qrs.h"
 #include "AD.h"
 #include "Key.h"
+#include "usart2.h"
+#include "transmit.h"
+#include "module/scheduler/scheduler.h"
+#ifdef ENABLE_IRQ_STAT
+#include "module/irqstat/irqstat.h"
+#endif
+
+#if (DISPLAY_TASK_FREQ % ECG_RENDER_FPS) || (DISPLAY_TASK_FREQ % DISPLAY_REFRESH_FREQ) || \
+    (DISPLAY_TASK_FREQ % DEBUG_PAGE_REFRESH_FREQ)
+#error "DISPLAY_TASK_FREQ must be a multiple of every page refresh rate"
+#endif
 
 /*============================================================================*/
 /*                              私有变量                                       */
 /*============================================================================*/
 
 static uint8_t last_page = 0xFF;          /**< 上一次的页面，用于检测页面切换 */
+static uint16_t display_tick = 0;         /**< 显示任务调用计数，切换页面时清零 */
 
 /* 页面0局部刷新相关 */
 static uint8_t  page0_static_drawn = 0;   /**< 页面0静态内容是否已绘制 */
@@ -25,13 +38,31 @@ static uint16_t last_hr = 0xFFFF;         /**< 上次心率值 */
 static uint16_t last_spo2 = 0xFFFF;       /**< 上次血氧值 */
 static uint8_t  last_finger = 0xFF;       /**< 上次手指检测状态 */
 
+/* 页面1局部刷新相关 */
+static uint8_t  page1_static_drawn = 0;   /**< 页面1静态内容是否已绘制 */
+static uint16_t last_time = 0xFFFF;       /**< 上次运行时间 */
+static uint8_t  last_stream = 0xFF;       /**< 上次连续上传状态 */
+static uint16_t last_ecg_hr = 0xFFFF;     /**< 上次ECG心率 */
+
 /*============================================================================*/
 /*                              显示更新（主入口）                              */
 /*============================================================================*/
 
+/**
+ * @brief  本次调用是否到达页面刷新时刻
+ * @param  freq: 页面刷新频率 (Hz)
+ * @retval 1: 刷新; 0: 跳过
+ * @note   切换页面后的第一次调用总是刷新
+ */
+static uint8_t Display_Due(uint16_t freq)
+{
+    return (display_tick % (DISPLAY_TASK_FREQ / freq)) == 0;
+}
+
 /**
  * @brief  显示更新
- * @note   处理页面切换检测并调用对应页面显示函数
+ * @note   调度器以 DISPLAY_TASK_FREQ 调用，处理页面切换检测，
+ *         按各页面的刷新频率调用对应页面显示函数
  */
 void Display_Update(void)
 {
@@ -40,10 +71,11 @@ void Display_Update(void)
     {
         OLED_Clear();
         last_page = current_page;
+        display_tick = 0;
         page0_static_drawn = 0;  /* 重置页面0静态内容标志 */
+        page1_static_drawn = 0;  /* 重置页面1静态内容标志 */
 #ifdef ENABLE_DEBUG_PAGE
-        extern uint32_t display_loop_time_max_ms;
-        display_loop_time_max_ms = 0;  /* 切换页面时重置最大时间 */
+        Sched_ResetStats();      /* 切换页面时重置任务统计 */
 #endif
     }
     
@@ -51,10 +83,9 @@ void Display_Update(void)
     switch (current_page)
     {
         case PAGE_HEARTRATE:
-            /* 心率页面：10Hz刷新 */
-            if (display_refresh_flag)
+            /* 心率页面：5Hz刷新 */
+            if (Display_Due(DISPLAY_REFRESH_FREQ))
             {
-                display_refresh_flag = 0;
                 Display_Page0_HeartRate();
             }
             break;
@@ -66,18 +97,37 @@ void Display_Update(void)
 #ifdef ENABLE_DEBUG_PAGE
         case PAGE_DEBUG:
             /* 调试页面：10Hz刷新 */
-            if (debug_refresh_flag)
+            if (Display_Due(DEBUG_PAGE_REFRESH_FREQ))
             {
-                debug_refresh_flag = 0;
                 Display_Page2_Debug();
             }
             break;
+            
+        case PAGE_TASKS:
+            /* 任务统计页面：10Hz刷新 */
+            if (Display_Due(DEBUG_PAGE_REFRESH_FREQ))
+            {
+                Display_Page3_Tasks();
+            }
+            break;
+            
+#ifdef ENABLE_IRQ_STAT
+        case PAGE_IRQ:
+            /* 中断统计页面：10Hz刷新 */
+            if (Display_Due(DEBUG_PAGE_REFRESH_FREQ))
+            {
+                Display_Page4_Irq();
+            }
+            break;
+#endif
 #endif
             
         default:
             current_page = PAGE_HEARTRATE;
             break;
     }
+    
+    display_tick++;
 }
 
 /*============================================================================*/
@@ -105,11 +155,7 @@ static void Display_Page0_DrawStatic(void)
     
     /* 页码指示 */
     OLED_ShowString(0, 56, "<K1", OLED_6X8);
-#ifdef ENABLE_DEBUG_PAGE
-    OLED_ShowString(45, 56, "1/3", OLED_6X8);
-#else
-    OLED_ShowString(45, 56, "1/2", OLED_6X8);
-#endif
+    OLED_ShowString(45, 56, "1/" PAGE_MAX_STR, OLED_6X8);
     OLED_ShowString(110, 56, "K3>", OLED_6X8);
     
     page0_static_drawn = 1;
@@ -180,31 +226,74 @@ void Display_Page0_HeartRate(void)
 /*============================================================================*/
 
 /**
- * @brief  页面1: 心电图显示
+ * @brief  页面1: 绘制静态内容（仅在页面切换时调用一次）
  */
-void Display_Page1_ECG(void)
+static void Display_Page1_DrawStatic(void)
 {
     /* 标题 */
     OLED_ShowString(0, 0, "ECG Monitor", OLED_6X8);
     
     /* 坐标系绘制 */
-    OLED_DrawLine(1, 54, 120, 54);     /* X轴 */
-    OLED_DrawLine(1, 10, 1, 54);       /* Y轴 */
-    OLED_DrawTriangle(1, 8, 0, 10, 2, 10, OLED_UNFILLED);    /* Y轴箭头 */
-    OLED_DrawTriangle(120, 55, 120, 53, 123, 54, OLED_UNFILLED);  /* X轴箭头 */
-    
-    /* 显示心电数据（由Timer3中断更新） */
-    OLED_ShowNum(100, 0, test, 3, OLED_6X8);
+    ECG_ClearAndRedraw();
     
     /* 页码指示 */
     OLED_ShowString(0, 56, "<K1", OLED_6X8);
-#ifdef ENABLE_DEBUG_PAGE
-    OLED_ShowString(45, 56, "2/3", OLED_6X8);
-#else
-    OLED_ShowString(45, 56, "2/2", OLED_6X8);
-#endif
+    OLED_ShowString(45, 56, "2/" PAGE_MAX_STR, OLED_6X8);
     OLED_ShowString(110, 56, "K3>", OLED_6X8);
     
+    /* ECG心率标签 */
+    OLED_ShowString(70, 56, "HR", OLED_6X8);
+    
+    page1_static_drawn = 1;
+}
+
+/**
+ * @brief  页面1: 心电图显示
+ * @note   波形点由ADC DMA中断放入队列，这里按 ECG_RENDER_FPS 取出绘制，
+ *         OLED_Update只发送本帧改动的列（新波形段和变化的数字）
+ */
+void Display_Page1_ECG(void)
+{
+    /* 首次进入页面，绘制静态内容并整屏刷新 */
+    if (!page1_static_drawn)
+    {
+        Display_Page1_DrawStatic();
+        ECG_RenderReset();
+        last_time = 0xFFFF;
+        last_stream = 0xFF;
+        last_ecg_hr = 0xFFFF;
+        OLED_Update();
+    }
+    
+    if (!Display_Due(ECG_RENDER_FPS))
+    {
+        return;
+    }
+    
+    /* 心电波形 */
+    ECG_Render();
+    
+    /* 运行时间 */
+    if (test != last_time)
+    {
+        last_time = test;
+        OLED_ShowNum(100, 0, test, 3, OLED_6X8);
+    }
+    
+    /* 连续上传指示 */
+    if (Transmit_IsECGStreaming() != last_stream)
+    {
+        last_stream = Transmit_IsECGStreaming();
+        OLED_ShowString(70, 0, last_stream ? "LIVE" : "    ", OLED_6X8);
+    }
+    
+    /* ECG心率（QRS检测逐拍更新） */
+    if (ECG_QRS_GetHeartRate() != last_ecg_hr)
+    {
+        last_ecg_hr = ECG_QRS_GetHeartRate();
+        OLED_ShowNum(84, 56, last_ecg_hr, 3, OLED_6X8);
+    }
+    
     OLED_Update();
 }
 
@@ -218,14 +307,19 @@ void Display_Page1_ECG(void)
  * 
  * @details 显示内容（10Hz刷新）:
  *          ┌────────────────────────┐
- *          │ [DEBUG] 10Hz           │
+ *          │ [DEBUG]      TxQ: 128  │
  *          │────────────────────────│
- *          │ Loop: 1234 10us        │
- *          │ Max:  5678 10us        │
- *          │ ADC:  2048   HR: 75    │
- *          │ Time: 123 s  SpO2: 98  │
- *          │ [<] Page 3/3     [>]   │
+ *          │ CPU Load: 23%          │
+ *          │ ADC:2048 HR:075 O2:098 │
+ *          │ Time:0123s     OV:000  │
+ *          │ E:000  U:000  P:000    │
+ *          │ K:000  S:000  T:000    │
+ *          │ <K1     3/4       K3>  │
  *          └────────────────────────┘
+ *          第3行为最近一秒任务执行时间占比；OV为MAX30102片上FIFO溢出点数
+ *          最后两行为各队列丢弃计数（只增不减）:
+ *          E: ECG绘图  U: ECG上传  P: PPG采样点  K: 按键
+ *          S: 串口发送丢弃的消息 + 接收覆盖的行  T: 任务错过截止时间（明细见第4页）
  */
 void Display_Page2_Debug(void)
 {
@@ -235,41 +329,188 @@ void Display_Page2_Debug(void)
     /* 读取当前ADC值 */
     adc_raw = AD_GetValue();
     
-    /* 标题 */
-    OLED_ShowString(0, 0, "[DEBUG] 10Hz", OLED_6X8);
+    /* 标题和串口2发送队列最高占用 */
+    OLED_ShowString(0, 0, "[DEBUG]", OLED_6X8);
+    OLED_ShowString(66, 0, "TxQ:", OLED_6X8);
+    OLED_ShowNum(96, 0, USART2_TxRing.high_water, 3, OLED_6X8);
     
     /* 分隔线 */
     OLED_DrawLine(0, 10, 127, 10);
     
-    /* 循环时间（当前） */
-    OLED_ShowString(0, 14, "Loop:", OLED_6X8);
-    OLED_ShowNum(36, 14, display_loop_time_ms, 5, OLED_6X8);
-    OLED_ShowString(72, 14, "10us", OLED_6X8);
-    
-    /* 循环时间（最大） */
-    OLED_ShowString(0, 24, "Max:", OLED_6X8);
-    OLED_ShowNum(30, 24, display_loop_time_max_ms, 5, OLED_6X8);
-    OLED_ShowString(66, 24, "10us", OLED_6X8);
-    
-    /* ADC和心率 */
-    OLED_ShowString(0, 34, "ADC:", OLED_6X8);
-    OLED_ShowNum(30, 34, adc_raw, 4, OLED_6X8);
-    OLED_ShowString(80, 34, "HR:", OLED_6X8);
-    OLED_ShowNum(104, 34, data->heart_rate, 3, OLED_6X8);
-    
-    /* 运行时间和血氧 */
-    OLED_ShowString(0, 44, "Time:", OLED_6X8);
-    OLED_ShowNum(36, 44, test, 4, OLED_6X8);
-    OLED_ShowString(62, 44, "s", OLED_6X8);
-    OLED_ShowString(80, 44, "SpO2:", OLED_6X8);
-    OLED_ShowNum(110, 44, data->spo2, 3, OLED_6X8);
+    /* CPU占用率 */
+    OLED_ShowString(0, 13, "CPU Load:", OLED_6X8);
+    OLED_ShowNum(60, 13, Sched_GetLoad(), 3, OLED_6X8);
+    OLED_ShowString(78, 13, "%", OLED_6X8);
+    
+    /* ADC、心率和血氧 */
+    OLED_ShowString(0, 22, "ADC:", OLED_6X8);
+    OLED_ShowNum(24, 22, adc_raw, 4, OLED_6X8);
+    OLED_ShowString(54, 22, "HR:", OLED_6X8);
+    OLED_ShowNum(72, 22, data->heart_rate, 3, OLED_6X8);
+    OLED_ShowString(92, 22, "O2:", OLED_6X8);
+    OLED_ShowNum(110, 22, data->spo2, 3, OLED_6X8);
+    
+    /* 运行时间和MAX30102 FIFO溢出丢点数 */
+    OLED_ShowString(0, 31, "Time:", OLED_6X8);
+    OLED_ShowNum(30, 31, test, 4, OLED_6X8);
+    OLED_ShowString(54, 31, "s", OLED_6X8);
+    OLED_ShowString(86, 31, "OV:", OLED_6X8);
+    OLED_ShowNum(104, 31, max30102_fifo_overflow, 3, OLED_6X8);
+    
+    /* 采样数据队列丢弃计数 */
+    OLED_ShowString(0, 40, "E:", OLED_6X8);
+    OLED_ShowNum(12, 40, ecg_draw_ring.overrun, 3, OLED_6X8);
+    OLED_ShowString(42, 40, "U:", OLED_6X8);
+    OLED_ShowNum(54, 40, ecg_upload_ring.overrun, 3, OLED_6X8);
+    OLED_ShowString(84, 40, "P:", OLED_6X8);
+    OLED_ShowNum(96, 40, ppg_sample_ring.overrun, 3, OLED_6X8);
+    
+    /* 事件丢弃计数 */
+    OLED_ShowString(0, 48, "K:", OLED_6X8);
+    OLED_ShowNum(12, 48, key_ring.overrun, 3, OLED_6X8);
+    OLED_ShowString(42, 48, "S:", OLED_6X8);
+    OLED_ShowNum(54, 48, USART2_TxDropCount + USART2_RxOverflow, 3, OLED_6X8);
+    OLED_ShowString(84, 48, "T:", OLED_6X8);
+    OLED_ShowNum(96, 48, Sched_GetTotalMisses(), 3, OLED_6X8);
     
     /* 页码指示 */
     OLED_ShowString(0, 56, "<K1", OLED_6X8);
-    OLED_ShowString(45, 56, "3/3", OLED_6X8);
+    OLED_ShowString(45, 56, "3/" PAGE_MAX_STR, OLED_6X8);
     OLED_ShowString(110, 56, "K3>", OLED_6X8);
     
-    OLED_Update();
+    /* 后台发送，上一帧未发完则跳过本帧 */
+    OLED_UpdateAsync();
+}
+
+/*============================================================================*/
+/*                              页面3: 任务统计页面                            */
+/*============================================================================*/
+
+#define TASKS_PAGE_ROWS     7   /**< 表头以下可显示的任务行数 */
+
+/**
+ * @brief  页面3: 任务统计页面
+ * 
+ * @details 显示内容（10Hz刷新，按优先级排列，时间单位10us）:
+ *          ┌────────────────────────┐
+ *          │ Task   Avg   Max   Mis │
+ *          │ ecgup     12    85   0 │
+ *          │ ppg       40   310   0 │
+ *          │ ...                    │
+ *          └────────────────────────┘
+ *          Mis为错过截止时间的次数；离开本页再进入时统计清零。
+ *          屏幕只显示前 TASKS_PAGE_ROWS 个任务，完整统计见调试串口输出
+ */
+void Display_Page3_Tasks(void)
+{
+    const Sched_Task_t *task;
+    uint8_t count = Sched_GetTaskCount();
+    uint8_t i;
+    uint8_t y;
+    
+    /* 表头 */
+    OLED_ShowString(0, 0, "Task", OLED_6X8);
+    OLED_ShowString(42, 0, "Avg", OLED_6X8);
+    OLED_ShowString(78, 0, "Max", OLED_6X8);
+    OLED_ShowString(110, 0, "Mis", OLED_6X8);
+    
+    if (count > TASKS_PAGE_ROWS)
+    {
+        count = TASKS_PAGE_ROWS;
+    }
+    
+    for (i = 0; i < count; i++)
+    {
+        task = Sched_GetTask(i);
+        y = 8 + i * 8;
+        
+        OLED_ShowString(0, y, (char *)task->name, OLED_6X8);
+        OLED_ShowNum(36, y, Sched_GetExecAvg(task), 5, OLED_6X8);
+        OLED_ShowNum(72, y, task->exec_max, 5, OLED_6X8);
+        OLED_ShowNum(110, y, task->misses, 3, OLED_6X8);
+    }
+    
+    /* 后台发送，上一帧未发完则跳过本帧 */
+    OLED_UpdateAsync();
+}
+
+#ifdef ENABLE_IRQ_STAT
+/*============================================================================*/
+/*                              页面4: 中断统计页面                            */
+/*============================================================================*/
+
+/**
+ * @brief  显示一个微秒值，超出位数时显示最大值
+ */
+static void Display_ShowMicros(uint8_t x, uint8_t y, uint32_t cycles, uint8_t digits, uint32_t limit)
+{
+    uint32_t us = IrqStat_ToMicros(cycles);
+    
+    OLED_ShowNum(x, y, (us > limit) ? limit : us, digits, OLED_6X8);
 }
-#endif
 
+/**
+ * @brief  页面4: 中断统计页面
+ * 
+ * @details 显示内容（10Hz刷新，按抢占优先级排列，时间单位us）:
+ *          ┌────────────────────────┐
+ *          │ IRQ    Lat   Dur  Jit  │
+ *          │ adc   0012 00180 0003  │
+ *          │ tim3  0010 00025 0011  │
+ *          │ i2c      - 00004    -  │
+ *          │ ...                    │
+ *          └────────────────────────┘
+ *          Lat为事件到进入中断的最大延迟（只有ADC和TIM3可测），Dur为最长执行时间，
+ *          Jit为进入间隔与标称周期之差的最大值（非周期的源不显示）。
+ *          按K2清零；直方图见调试串口输出
+ */
+void Display_Page4_Irq(void)
+{
+    const IrqStat_t *stat;
+    uint8_t count = IRQSTAT_COUNT;
+    uint8_t i;
+    uint8_t y;
+    
+    /* 表头 */
+    OLED_ShowString(0, 0, "IRQ", OLED_6X8);
+    OLED_ShowString(42, 0, "Lat", OLED_6X8);
+    OLED_ShowString(78, 0, "Dur", OLED_6X8);
+    OLED_ShowString(108, 0, "Jit", OLED_6X8);
+    
+    if (count > TASKS_PAGE_ROWS)
+    {
+        count = TASKS_PAGE_ROWS;
+    }
+    
+    for (i = 0; i < count; i++)
+    {
+        stat = IrqStat_Get((IrqStat_Vector_t)i);
+        y = 8 + i * 8;
+        
+        OLED_ShowString(0, y, (char *)IrqStat_GetName((IrqStat_Vector_t)i), OLED_6X8);
+        
+        /* 没有延迟样本时第0格和最大值都为0 */
+        if (stat->latency_max == 0 && stat->latency[0] == 0)
+        {
+            OLED_ShowString(36, y, "   -", OLED_6X8);
+        }
+        else
+        {
+            Display_ShowMicros(36, y, stat->latency_max, 4, 9999);
+        }
+        Display_ShowMicros(66, y, stat->duration_max, 5, 99999);
+        if (IrqStat_IsPeriodic((IrqStat_Vector_t)i))
+        {
+            Display_ShowMicros(102, y, stat->jitter_max, 4, 9999);
+        }
+        else
+        {
+            OLED_ShowString(102, y, "   -", OLED_6X8);
+        }
+    }
+    
+    /* 后台发送，上一帧未发完则跳过本帧 */
+    OLED_UpdateAsync();
+}
+#endif
+#endif
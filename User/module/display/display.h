@@ -7,6 +7,7 @@
   *          - 页面0: 心率血氧显示
   *          - 页面1: 心电图显示
   *          - 页面2: 调试页面（可选）
+  *          - 页面3: 任务统计页面（可选，与调试页面同时启用）
   ******************************************************************************
   */
 
@@ -17,6 +18,16 @@
 #include "kconfig.h"
 #include "max30102.h"
 
+/*============================================================================*/
+/*                              配置                                          */
+/*============================================================================*/
+
+/**
+ * @brief  显示任务调用频率 (Hz)
+ * @note   各页面刷新频率由此分频得到，必须能被它们整除
+ */
+#define DISPLAY_TASK_FREQ       SCHED_BASE_FREQ
+
 /*============================================================================*/
 /*                              外部变量声明                                   */
 /*============================================================================*/
@@ -24,25 +35,13 @@
 /* 页面控制（来自Key.c） */
 extern uint8_t current_page;
 
-/* 10Hz显示刷新标志（来自main.c，由Timer3置位） */
-extern volatile uint8_t display_refresh_flag;
-
-#ifdef ENABLE_DEBUG_PAGE
-/* 调试数据（来自main.c） */
-extern uint32_t display_loop_time_ms;      /**< 循环时间 (10us) */
-extern uint32_t display_loop_time_max_ms;  /**< 最大循环时间 (10us) */
-
-/* 调试页面刷新标志（来自main.c） */
-extern volatile uint8_t debug_refresh_flag;
-#endif
-
 /*============================================================================*/
 /*                              函数声明                                       */
 /*============================================================================*/
 
 /**
- * @brief  显示更新（主入口函数）
- * @note   处理页面切换检测并调用对应页面显示函数
+ * @brief  显示更新（主入口函数，调度器以 DISPLAY_TASK_FREQ 调用）
+ * @note   处理页面切换检测并按各页面刷新频率调用对应页面显示函数
  */
 void Display_Update(void);
 
@@ -61,8 +60,9 @@ void Display_Page0_HeartRate(void);
  * @note   显示内容:
  *         - 标题: "ECG Monitor"
  *         - XY坐标系
- *         - 心电波形（由Timer3中断绘制）
+ *         - 心电波形（DMA中断入队，按 ECG_RENDER_FPS 帧率绘制）
  *         - 运行时间
+ *         - ECG心率（QRS检测）
  *         - 页码指示
  */
 void Display_Page1_ECG(void);
@@ -71,12 +71,31 @@ void Display_Page1_ECG(void);
 /**
  * @brief  页面2: 调试页面
  * @note   显示内容（10Hz刷新）:
- *         - 循环时间（当前/最大）
+ *         - 串口2发送队列最高占用
+ *         - CPU占用率
  *         - ADC原始值
  *         - 心率/血氧值
  *         - 运行时间
  */
 void Display_Page2_Debug(void);
+
+/**
+ * @brief  页面3: 任务统计页面
+ * @note   显示内容（10Hz刷新）:
+ *         - 各任务平均/最长执行时间 (10us)
+ *         - 各任务错过截止时间的次数
+ */
+void Display_Page3_Tasks(void);
+
+#ifdef ENABLE_IRQ_STAT
+/**
+ * @brief  页面4: 中断统计页面
+ * @note   显示内容（10Hz刷新）:
+ *         - 各中断源的最大延迟、最大执行时间、最大抖动 (us)
+ *         - K2: 清零（启用串口调试时先输出完整直方图）
+ */
+void Display_Page4_Irq(void);
+#endif
 #endif
 
 #endif /* __DISPLAY_H */
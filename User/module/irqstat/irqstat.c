@@ -0,0 +1,250 @@
+/**
+  ******************************************************************************
+  * @file    irqstat.c
+  * @brief   中断延迟与抖动统计
+  *
+  * @details 每次记录只有几十个周期（3次CLZ查格、3次计数加1、若干比较），
+  *          计入被测中断自身的执行时间。
+  *          周期计数器32位，72MHz下约60s回绕，非周期源超过60s的间隔会按回绕后的值统计
+  ******************************************************************************
+  */
+
+#include "irqstat.h"
+
+#ifdef ENABLE_IRQ_STAT
+
+#include "stm32f10x.h"
+#include "Timer2.h"
+#include "string.h"
+#ifdef ENABLE_UART_DEBUG
+#include "stdio.h"
+#endif
+
+/*============================ 私有定义 ============================*/
+
+#define IRQSTAT_CYCLES_PER_US   (SYSTEM_CLOCK_HZ / 1000000)
+#define IRQSTAT_CYCLES_PER_TICK (SYSTEM_CLOCK_HZ / TIM3_COUNTER_FREQ)
+
+/* 报告行: 0 无请求, 1 表头, 之后每个源4行, 最后一行结束 */
+#define IRQSTAT_ROWS_PER_VECTOR 4
+#define IRQSTAT_ROW_END         (2 + IRQSTAT_COUNT * IRQSTAT_ROWS_PER_VECTOR)
+
+/**
+  * @brief  中断源描述
+  */
+typedef struct
+{
+    const char *name;
+    uint32_t period;        /**< 标称周期 (周期数)，0为非周期 */
+} IrqStat_Source_t;
+
+/*============================ 私有变量 ============================*/
+
+static const IrqStat_Source_t irqstat_sources[IRQSTAT_COUNT] = {
+    { "adc",   SYSTEM_CLOCK_HZ / ECG_BLOCK_FREQ },
+    { "tim3",  SYSTEM_CLOCK_HZ / SCHED_BASE_FREQ },
+    { "i2c",   0 },
+    { "i2cdm", 0 },
+    { "exti",  0 },
+    { "dma6",  0 },
+    { "u2",    0 },
+#ifdef OLED_USE_HW_I2C
+    { "oled",  0 },
+#endif
+};
+
+static IrqStat_t irqstat[IRQSTAT_COUNT];
+static volatile uint32_t irqstat_since = 0;     /**< 清零时的10us时间戳 */
+
+#ifdef ENABLE_UART_DEBUG
+static uint8_t irqstat_report_row = 0;
+#endif
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  周期数所在的直方图格
+  */
+static uint8_t IrqStat_Bucket(uint32_t cycles)
+{
+    uint8_t bucket;
+
+    cycles >>= IRQSTAT_HIST_SHIFT;
+    if (cycles == 0)
+    {
+        return 0;
+    }
+    bucket = (uint8_t)(32 - __CLZ(cycles));
+    return (bucket < IRQSTAT_HIST_BUCKETS) ? bucket : (IRQSTAT_HIST_BUCKETS - 1);
+}
+
+/*============================ 中断中调用 ============================*/
+
+/**
+  * @brief  记录一次中断
+  */
+void IrqStat_Record(IrqStat_Vector_t vector, uint32_t entry, uint32_t latency)
+{
+    IrqStat_t *s = &irqstat[vector];
+    uint32_t duration = Cycle_Now() - entry;
+    uint32_t interval, jitter;
+
+    if (latency != IRQSTAT_NO_LATENCY)
+    {
+        s->latency[IrqStat_Bucket(latency)]++;
+        if (latency > s->latency_max)
+        {
+            s->latency_max = latency;
+        }
+    }
+
+    s->duration[IrqStat_Bucket(duration)]++;
+    if (duration > s->duration_max)
+    {
+        s->duration_max = duration;
+    }
+    s->busy += duration;
+
+    /* 清零后的第一次没有上一次可比 */
+    if (s->count > 0)
+    {
+        interval = entry - s->last_entry;
+        jitter = interval;
+        if (irqstat_sources[vector].period != 0)
+        {
+            jitter = (interval > irqstat_sources[vector].period) ?
+                     interval - irqstat_sources[vector].period :
+                     irqstat_sources[vector].period - interval;
+        }
+        s->jitter[IrqStat_Bucket(jitter)]++;
+        if (jitter > s->jitter_max)
+        {
+            s->jitter_max = jitter;
+        }
+    }
+    s->last_entry = entry;
+    s->count++;
+}
+
+/*============================ 公共函数 ============================*/
+
+/**
+  * @brief  使能周期计数器并清零统计
+  */
+void IrqStat_Init(void)
+{
+    Cycle_Init();
+    IrqStat_Reset();
+}
+
+/**
+  * @brief  清零全部统计
+  * @note   每个源单独关中断清零，关中断时间约为清零一个源的时间
+  */
+void IrqStat_Reset(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < IRQSTAT_COUNT; i++)
+    {
+        __disable_irq();
+        memset(&irqstat[i], 0, sizeof(IrqStat_t));
+        __enable_irq();
+    }
+    irqstat_since = Timer3_GetTick();
+}
+
+const IrqStat_t *IrqStat_Get(IrqStat_Vector_t vector)
+{
+    return &irqstat[vector];
+}
+
+const char *IrqStat_GetName(IrqStat_Vector_t vector)
+{
+    return irqstat_sources[vector].name;
+}
+
+uint8_t IrqStat_IsPeriodic(IrqStat_Vector_t vector)
+{
+    return irqstat_sources[vector].period != 0;
+}
+
+uint32_t IrqStat_ToMicros(uint32_t cycles)
+{
+    return cycles / IRQSTAT_CYCLES_PER_US;
+}
+
+#ifdef ENABLE_UART_DEBUG
+/**
+  * @brief  请求经调试串口输出一份报告
+  */
+void IrqStat_RequestReport(void)
+{
+    if (irqstat_report_row == 0)
+    {
+        irqstat_report_row = 1;
+    }
+}
+
+/**
+  * @brief  报告任务，每次输出一行
+  * @note   printf 按字节阻塞发送，一行约100字节（115200下约9ms），
+  *         与 Sched_ReportTask 一样分多次输出，不长时间占用调度
+  */
+void IrqStat_ReportTask(void)
+{
+    const IrqStat_t *s;
+    const uint32_t *hist;
+    uint64_t elapsed;
+    uint8_t vector, kind, i;
+
+    if (irqstat_report_row == 0)
+    {
+        return;
+    }
+
+    if (irqstat_report_row == 1)
+    {
+        printf("\r\nirq,begin,clock=%lu,shift=%u,buckets=%u\r\n",
+               (unsigned long)SYSTEM_CLOCK_HZ, IRQSTAT_HIST_SHIFT, IRQSTAT_HIST_BUCKETS);
+    }
+    else if (irqstat_report_row >= IRQSTAT_ROW_END)
+    {
+        printf("irq,end\r\n");
+        IrqStat_Reset();
+        irqstat_report_row = 0;
+        return;
+    }
+    else
+    {
+        vector = (irqstat_report_row - 2) / IRQSTAT_ROWS_PER_VECTOR;
+        kind = (irqstat_report_row - 2) % IRQSTAT_ROWS_PER_VECTOR;
+        s = &irqstat[vector];
+
+        if (kind == 0)
+        {
+            elapsed = (uint64_t)(Timer3_GetTick() - irqstat_since) * IRQSTAT_CYCLES_PER_TICK;
+            printf("irq,%s,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+                   irqstat_sources[vector].name, (unsigned long)s->count,
+                   (unsigned long)irqstat_sources[vector].period,
+                   (unsigned long)s->latency_max, (unsigned long)s->duration_max,
+                   (unsigned long)s->jitter_max,
+                   (unsigned long)(elapsed ? s->busy * 1000 / elapsed : 0));
+        }
+        else
+        {
+            hist = (kind == 1) ? s->latency : ((kind == 2) ? s->duration : s->jitter);
+            printf("irq,%s,%s", irqstat_sources[vector].name,
+                   (kind == 1) ? "lat" : ((kind == 2) ? "dur" : "jit"));
+            for (i = 0; i < IRQSTAT_HIST_BUCKETS; i++)
+            {
+                printf(",%lu", (unsigned long)hist[i]);
+            }
+            printf("\r\n");
+        }
+    }
+    irqstat_report_row++;
+}
+#endif
+
+#endif /* ENABLE_IRQ_STAT */
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file    irqstat.h
+  * @brief   中断延迟与抖动统计头文件
+  *
+  * @details 各中断服务函数入口和出口用DWT周期计数器打时间戳，按中断源统计:
+  *          - 延迟: 从事件发生到进入中断，只有能读出事件时刻的源才有
+  *                  （ADC: TIM2自采样触发以来的计数，1us分辨率，含ADC采样转换约5.7us，
+  *                         超过一个采样周期的部分回绕；
+  *                   TIM3: 自CC3比较以来的计数，10us分辨率）
+  *          - 执行时间: 入口到出口
+  *          - 抖动: 周期性的源为相邻两次进入的间隔与标称周期之差的绝对值，
+  *                  非周期的源为间隔本身
+  *
+  *          三项各一个对数直方图，单位为周期，第0格 [0, 64)，第k格 [64x2^(k-1), 64x2^k)，
+  *          最后一格为 >= 64x2^14（约14.6ms）。
+  *
+  *          中断服务函数中的用法（局部变量之后、第一条语句之前）:
+  *
+  *          IRQSTAT_ENTER();
+  *          ...
+  *          IRQSTAT_LATENCY(自事件以来的周期数);    // 可选
+  *          IRQSTAT_EXIT(IRQSTAT_xxx);
+  *
+  *          未启用 ENABLE_IRQ_STAT 时这些宏为空。
+  *          每个源的统计只由它自己的中断写入，同一中断不会嵌套，不需要关中断
+  ******************************************************************************
+  */
+
+#ifndef __IRQSTAT_H
+#define __IRQSTAT_H
+
+#include <stdint.h>
+#include "kconfig.h"
+
+/*============================ 宏定义 ============================*/
+
+#define IRQSTAT_HIST_BUCKETS    16      /**< 直方图格数 */
+#define IRQSTAT_HIST_SHIFT      6       /**< 第0格宽度 2^6 = 64 周期 */
+#define IRQSTAT_NO_LATENCY      0xFFFFFFFFUL
+
+/**
+  * @brief  中断源（按抢占优先级排列）
+  */
+typedef enum
+{
+    IRQSTAT_ADC_DMA = 0,    /**< DMA1通道1: ECG半缓冲处理 (2/0) */
+    IRQSTAT_TIM3,           /**< TIM3 CC3: 100Hz节拍 (2/1)，只统计CC3 */
+    IRQSTAT_I2C_EV,         /**< 传感器I2C事件 (3/0) */
+    IRQSTAT_I2C_DMA,        /**< 传感器I2C接收DMA (3/0) */
+    IRQSTAT_EXTI,           /**< MAX30102 FIFO将满 (3/1) */
+    IRQSTAT_DMA6,           /**< DMA1通道6: 串口2接收，或硬件I2C时OLED发送 (3/3, 3/0) */
+    IRQSTAT_USART2,         /**< 串口2 (3/3) */
+#ifdef OLED_USE_HW_I2C
+    IRQSTAT_OLED_EV,        /**< OLED I2C1事件 (3/0) */
+#endif
+    IRQSTAT_COUNT
+} IrqStat_Vector_t;
+
+/**
+  * @brief  一个中断源的统计
+  */
+typedef struct
+{
+    uint32_t count;                             /**< 进入次数 */
+    uint32_t last_entry;                        /**< 上次进入的周期数 */
+    uint32_t latency_max;
+    uint32_t duration_max;
+    uint32_t jitter_max;
+    uint64_t busy;                              /**< 执行时间累计 */
+    uint32_t latency[IRQSTAT_HIST_BUCKETS];
+    uint32_t duration[IRQSTAT_HIST_BUCKETS];
+    uint32_t jitter[IRQSTAT_HIST_BUCKETS];
+} IrqStat_t;
+
+/*============================ 中断中使用 ============================*/
+
+#ifdef ENABLE_IRQ_STAT
+
+#include "module/bench/bench.h"
+
+#define IRQSTAT_ENTER()         uint32_t irqstat_entry = Cycle_Now(), irqstat_latency = IRQSTAT_NO_LATENCY
+#define IRQSTAT_LATENCY(cycles) (irqstat_latency = (cycles))
+#define IRQSTAT_EXIT(vector)    IrqStat_Record((vector), irqstat_entry, irqstat_latency)
+
+/**
+  * @brief  记录一次中断
+  * @param  vector: 中断源
+  * @param  entry: 入口的周期数
+  * @param  latency: 延迟周期数，IRQSTAT_NO_LATENCY 表示未知
+  */
+void IrqStat_Record(IrqStat_Vector_t vector, uint32_t entry, uint32_t latency);
+
+#else
+
+#define IRQSTAT_ENTER()
+#define IRQSTAT_LATENCY(cycles)
+#define IRQSTAT_EXIT(vector)
+
+#endif
+
+/*============================ 读取与输出 ============================*/
+
+#ifdef ENABLE_IRQ_STAT
+/**
+  * @brief  使能周期计数器并清零统计
+  * @note   在使能各中断之前调用
+  */
+void IrqStat_Init(void);
+
+/**
+  * @brief  清零全部统计
+  */
+void IrqStat_Reset(void);
+
+/**
+  * @brief  读取一个中断源的统计
+  */
+const IrqStat_t *IrqStat_Get(IrqStat_Vector_t vector);
+
+/**
+  * @brief  中断源名称（不超过5个字符）
+  */
+const char *IrqStat_GetName(IrqStat_Vector_t vector);
+
+/**
+  * @brief  是否为周期性的源（抖动相对标称周期计算）
+  */
+uint8_t IrqStat_IsPeriodic(IrqStat_Vector_t vector);
+
+/**
+  * @brief  周期数换算为微秒
+  */
+uint32_t IrqStat_ToMicros(uint32_t cycles);
+
+#ifdef ENABLE_UART_DEBUG
+/**
+  * @brief  请求经调试串口输出一份报告，输出完成后清零统计
+  */
+void IrqStat_RequestReport(void);
+
+/**
+  * @brief  报告任务，每次输出一行（逗号分隔）:
+  *
+  *         irq,begin,clock=72000000,shift=6,buckets=16
+  *         irq,<名称>,<次数>,<标称周期>,<最大延迟>,<最大执行>,<最大抖动>,<占用千分比>
+  *         irq,<名称>,lat,<第0格>,...,<第15格>
+  *         irq,<名称>,dur,...
+  *         irq,<名称>,jit,...
+  *         irq,end
+  *
+  *         时间单位均为周期；没有报告请求时直接返回
+  */
+void IrqStat_ReportTask(void);
+#endif
+#endif
+
+#endif
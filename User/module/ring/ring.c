@@ -0,0 +1,300 @@
+/**
+  ******************************************************************************
+  * @file    ring.c
+  * @brief   单生产者/单消费者无锁环形队列实现
+  *
+  * @details 原先各模块各自实现环形队列（ECG绘图/上传、串口收发），
+  *          索引位宽、满判断和内存屏障写法不一；统一为本模块后:
+  *          - 所有中断与主循环之间的数据都经队列传递，不再依赖单个标志位
+  *          - 丢弃计数和最高占用由队列自身统计，调试页面直接读取
+  *
+  *          多元素读写按存储区末尾分两段memcpy，单元素读写也走同一路径
+  ******************************************************************************
+  */
+
+#include "ring.h"
+#include "stm32f10x.h"
+#include "string.h"
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  从pos开始向存储区拷入n个元素（可跨越末尾）
+  */
+static void Ring_CopyIn(Ring_t *r, uint32_t pos, const uint8_t *src, uint16_t n)
+{
+    uint16_t offset = (uint16_t)(pos & r->mask);
+    uint16_t first = (uint16_t)(r->mask + 1 - offset);
+
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(r->buf + offset * r->elem_size, src, first * r->elem_size);
+    if (n > first)
+    {
+        memcpy(r->buf, src + first * r->elem_size, (n - first) * r->elem_size);
+    }
+}
+
+/**
+  * @brief  从pos开始由存储区拷出n个元素（可跨越末尾）
+  */
+static void Ring_CopyOut(const Ring_t *r, uint32_t pos, uint8_t *dst, uint16_t n)
+{
+    uint16_t offset = (uint16_t)(pos & r->mask);
+    uint16_t first = (uint16_t)(r->mask + 1 - offset);
+
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(dst, r->buf + offset * r->elem_size, first * r->elem_size);
+    if (n > first)
+    {
+        memcpy(dst + first * r->elem_size, r->buf, (n - first) * r->elem_size);
+    }
+}
+
+/**
+  * @brief  更新最高占用
+  */
+static void Ring_UpdateHighWater(Ring_t *r, uint32_t used)
+{
+    if (used > r->high_water)
+    {
+        r->high_water = (uint16_t)used;
+    }
+}
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  初始化队列
+  * @param  r: 队列
+  * @param  buf: 存储区，至少 elem_size * count 字节
+  * @param  elem_size: 元素大小 (字节)
+  * @param  count: 元素个数，必须为2的幂
+  */
+void Ring_Init(Ring_t *r, void *buf, uint16_t elem_size, uint16_t count)
+{
+    r->buf = (uint8_t *)buf;
+    r->elem_size = elem_size;
+    r->mask = count - 1;
+    r->head = 0;
+    r->tail = 0;
+    r->overrun = 0;
+    r->high_water = 0;
+}
+
+/**
+  * @brief  写入一个元素（生产者）
+  * @param  r: 队列
+  * @param  elem: 元素
+  * @retval 0: 成功, 1: 队列满，已丢弃并计数
+  */
+uint8_t Ring_Put(Ring_t *r, const void *elem)
+{
+    uint32_t head = r->head;
+    uint32_t used = head - r->tail;
+
+    if (used > r->mask)
+    {
+        r->overrun++;
+        return 1;
+    }
+
+    Ring_CopyIn(r, head, (const uint8_t *)elem, 1);
+    __DMB();                  /* 先写数据再发布索引 */
+    r->head = head + 1;
+
+    Ring_UpdateHighWater(r, used + 1);
+    return 0;
+}
+
+/**
+  * @brief  写入多个元素（生产者）
+  * @param  r: 队列
+  * @param  elems: 元素数组
+  * @param  n: 元素个数
+  * @retval 实际写入的个数，放不下的部分丢弃并计数
+  */
+uint16_t Ring_PutN(Ring_t *r, const void *elems, uint16_t n)
+{
+    uint32_t head = r->head;
+    uint32_t used = head - r->tail;
+    uint16_t space = (used > r->mask) ? 0 : (uint16_t)(r->mask + 1 - used);
+
+    if (n > space)
+    {
+        r->overrun += n - space;
+        n = space;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    Ring_CopyIn(r, head, (const uint8_t *)elems, n);
+    __DMB();
+    r->head = head + n;
+
+    Ring_UpdateHighWater(r, used + n);
+    return n;
+}
+
+/**
+  * @brief  不检查空间写入一个元素（生产者）
+  * @param  r: 队列
+  * @param  elem: 元素
+  */
+void Ring_PutOverwrite(Ring_t *r, const void *elem)
+{
+    uint32_t head = r->head;
+
+    Ring_CopyIn(r, head, (const uint8_t *)elem, 1);
+    __DMB();
+    r->head = head + 1;
+}
+
+/**
+  * @brief  发布已由外部写入存储区的n个元素（生产者）
+  * @param  r: 队列
+  * @param  n: 元素个数
+  */
+void Ring_Commit(Ring_t *r, uint16_t n)
+{
+    uint32_t head = r->head + n;
+
+    __DMB();
+    r->head = head;
+
+    Ring_UpdateHighWater(r, head - r->tail);
+}
+
+/**
+  * @brief  取出一个元素（消费者）
+  * @param  r: 队列
+  * @param  elem: 输出
+  * @retval 1: 取到, 0: 队列空
+  */
+uint8_t Ring_Get(Ring_t *r, void *elem)
+{
+    uint32_t tail = r->tail;
+
+    if (tail == r->head)
+    {
+        return 0;
+    }
+    __DMB();                  /* 先读索引再读数据 */
+
+    Ring_CopyOut(r, tail, (uint8_t *)elem, 1);
+    __DMB();                  /* 数据读完再释放空间 */
+    r->tail = tail + 1;
+
+    return 1;
+}
+
+/**
+  * @brief  取出多个元素（消费者）
+  * @param  r: 队列
+  * @param  elems: 输出数组
+  * @param  n: 最多取出的个数
+  * @retval 实际取出的个数
+  */
+uint16_t Ring_GetN(Ring_t *r, void *elems, uint16_t n)
+{
+    uint32_t tail = r->tail;
+    uint32_t avail = r->head - tail;
+
+    if (n > avail)
+    {
+        n = (uint16_t)avail;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    __DMB();
+
+    Ring_CopyOut(r, tail, (uint8_t *)elems, n);
+    __DMB();
+    r->tail = tail + n;
+
+    return n;
+}
+
+/**
+  * @brief  丢弃最早的n个元素（消费者）
+  * @param  r: 队列
+  * @param  n: 元素个数
+  */
+void Ring_Skip(Ring_t *r, uint32_t n)
+{
+    __DMB();
+    r->tail += n;
+}
+
+/**
+  * @brief  丢弃全部未取出的元素（消费者）
+  * @param  r: 队列
+  */
+void Ring_Flush(Ring_t *r)
+{
+    __DMB();
+    r->tail = r->head;
+}
+
+/**
+  * @brief  读位置回退到最近写入的n个元素之前（消费者）
+  * @param  r: 队列
+  * @param  n: 元素个数
+  */
+void Ring_Rewind(Ring_t *r, uint32_t n)
+{
+    r->tail = r->head - n;
+    __DMB();                  /* 先设置读索引，再让生产者检查队列满 */
+}
+
+/**
+  * @brief  未取出的元素个数
+  * @param  r: 队列
+  * @retval 元素个数
+  */
+uint32_t Ring_Count(const Ring_t *r)
+{
+    return r->head - r->tail;
+}
+
+/**
+  * @brief  剩余空间
+  * @param  r: 队列
+  * @retval 元素个数
+  */
+uint16_t Ring_Free(const Ring_t *r)
+{
+    uint32_t used = r->head - r->tail;
+
+    return (used > r->mask) ? 0 : (uint16_t)(r->mask + 1 - used);
+}
+
+/**
+  * @brief  队列长度
+  * @param  r: 队列
+  * @retval 元素个数
+  */
+uint16_t Ring_Size(const Ring_t *r)
+{
+    return r->mask + 1;
+}
+
+/**
+  * @brief  按元素序号取存储区地址
+  * @param  r: 队列
+  * @param  pos: 元素序号
+  * @retval 元素地址
+  */
+void *Ring_At(const Ring_t *r, uint32_t pos)
+{
+    return r->buf + (pos & r->mask) * r->elem_size;
+}
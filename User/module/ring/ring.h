@@ -0,0 +1,129 @@
+/**
+  ******************************************************************************
+  * @file    ring.h
+  * @brief   单生产者/单消费者无锁环形队列头文件
+  *
+  * @details 中断与主循环之间传递数据的通用队列:
+  *
+  *          生产者 --Ring_Put--> [ buf[head & mask] ... buf[tail & mask] ] --Ring_Get--> 消费者
+  *
+  *          - 长度为2的幂，head/tail为自由递增的元素总数，取下标时按位与
+  *          - head仅生产者修改，tail仅消费者修改，无需关中断
+  *          - 写数据与发布head之间、读数据与释放tail之间有内存屏障
+  *          - 队列满时丢弃新数据并计入overrun，不覆盖未取出的数据
+  *          - 元素大小任意，一个队列只能有一个生产者和一个消费者
+  ******************************************************************************
+  */
+
+#ifndef __RING_H
+#define __RING_H
+
+#include <stdint.h>
+
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  环形队列
+  */
+typedef struct
+{
+    uint8_t *buf;                 /**< 存储区，长度 elem_size * (mask + 1) */
+    uint16_t elem_size;           /**< 元素大小 (字节) */
+    uint16_t mask;                /**< 元素个数 - 1 */
+    volatile uint32_t head;       /**< 已写入元素总数（仅生产者修改） */
+    volatile uint32_t tail;       /**< 已取出元素总数（仅消费者修改） */
+    uint32_t overrun;             /**< 队列满被丢弃的元素数（生产者计数） */
+    uint16_t high_water;          /**< 最高占用 (元素) */
+} Ring_t;
+
+/** 编译期检查队列长度为2的幂 */
+#define RING_IS_POW2(n)     ((n) != 0 && ((n) & ((n) - 1)) == 0)
+
+/*============================ 函数声明 ============================*/
+
+/**
+  * @brief  初始化队列
+  * @param  r: 队列
+  * @param  buf: 存储区，至少 elem_size * count 字节
+  * @param  elem_size: 元素大小 (字节)
+  * @param  count: 元素个数，必须为2的幂
+  * @note   在使能相关中断之前调用
+  */
+void Ring_Init(Ring_t *r, void *buf, uint16_t elem_size, uint16_t count);
+
+/**
+  * @brief  写入一个元素（生产者）
+  * @retval 0: 成功, 1: 队列满，已丢弃并计数
+  */
+uint8_t Ring_Put(Ring_t *r, const void *elem);
+
+/**
+  * @brief  写入多个元素（生产者）
+  * @retval 实际写入的个数，放不下的部分丢弃并计数
+  */
+uint16_t Ring_PutN(Ring_t *r, const void *elems, uint16_t n);
+
+/**
+  * @brief  不检查空间写入一个元素（生产者）
+  * @note   用作历史缓存: 消费者不读取期间覆盖最旧的数据，
+  *         消费者开始读取前用 Ring_Rewind 重新定位
+  */
+void Ring_PutOverwrite(Ring_t *r, const void *elem);
+
+/**
+  * @brief  发布已由外部（如DMA）写入存储区的n个元素（生产者）
+  * @note   不检查空间，消费者由 Ring_Count() > Ring_Size() 判断数据已被覆盖
+  */
+void Ring_Commit(Ring_t *r, uint16_t n);
+
+/**
+  * @brief  取出一个元素（消费者）
+  * @retval 1: 取到, 0: 队列空
+  */
+uint8_t Ring_Get(Ring_t *r, void *elem);
+
+/**
+  * @brief  取出多个元素（消费者）
+  * @retval 实际取出的个数
+  */
+uint16_t Ring_GetN(Ring_t *r, void *elems, uint16_t n);
+
+/**
+  * @brief  丢弃最早的n个元素（消费者，n不超过 Ring_Count）
+  */
+void Ring_Skip(Ring_t *r, uint32_t n);
+
+/**
+  * @brief  丢弃全部未取出的元素（消费者）
+  */
+void Ring_Flush(Ring_t *r);
+
+/**
+  * @brief  读位置回退到最近写入的n个元素之前（消费者）
+  * @note   配合 Ring_PutOverwrite 取出历史数据，n不超过队列长度和已写入总数
+  */
+void Ring_Rewind(Ring_t *r, uint32_t n);
+
+/**
+  * @brief  未取出的元素个数
+  * @note   仅 Ring_PutOverwrite / Ring_Commit 可能使其超过队列长度
+  */
+uint32_t Ring_Count(const Ring_t *r);
+
+/**
+  * @brief  剩余空间 (元素)
+  */
+uint16_t Ring_Free(const Ring_t *r);
+
+/**
+  * @brief  队列长度 (元素)
+  */
+uint16_t Ring_Size(const Ring_t *r);
+
+/**
+  * @brief  按元素序号取存储区地址（不拷贝读取或DMA写入时使用）
+  * @param  pos: 元素序号，与head/tail同一计数
+  */
+void *Ring_At(const Ring_t *r, uint32_t pos);
+
+#endif
@@ -0,0 +1,299 @@
+/**
+  ******************************************************************************
+  * @file    scheduler.c
+  * @brief   协作式任务调度器实现
+  *
+  * @details 原主循环把各模块处理函数依次调用一遍，只测量整圈时间，
+  *          某个模块耗时过长时看不出是谁；各任务的执行频率也靠TIM3中断
+  *          置标志位决定。现由本模块按任务表调度:
+  *
+  *          Sched_Run ──> 有到期周期任务? ──是──> 运行优先级最高的一个 ──> 统计/推进释放时刻
+  *                              │否
+  *                              └──> 各后台任务运行一次
+  *
+  *          - 每次运行前后读取10us时间戳，记录最短/平均/最长执行时间
+  *          - 周期任务从释放到完成超过截止时间记一次错过；落后一个周期以上时
+  *            跳过错过的释放，每跳过一次也记一次，不会连续补跑
+  *          - 周期任务执行时间累计为每秒占用率；后台任务空闲时轮询，不计入
+  ******************************************************************************
+  */
+
+#include "scheduler.h"
+#include "Timer2.h"
+
+#ifdef ENABLE_UART_DEBUG
+#include "stdio.h"
+#endif
+
+/*============================ 私有变量 ============================*/
+
+#define SCHED_LOAD_WINDOW   SCHED_MS(1000)  /**< 占用率统计窗口 */
+
+static Sched_Task_t *sched_tasks = 0;   /**< 任务表（已按优先级排序） */
+static uint8_t  sched_count = 0;        /**< 任务个数 */
+
+static uint32_t load_window_start = 0;  /**< 本统计窗口起始时刻 */
+static uint32_t load_busy = 0;          /**< 本窗口内任务执行时间累计 */
+static uint8_t  load_percent = 0;       /**< 上一窗口的占用率 */
+
+#ifdef ENABLE_UART_DEBUG
+static uint8_t  report_row = 0;         /**< 统计表下一行，0为表头 */
+#endif
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  清零一个任务的统计
+  */
+static void Sched_ClearStats(Sched_Task_t *task)
+{
+    task->runs = 0;
+    task->exec_min = 0xFFFFFFFF;
+    task->exec_max = 0;
+    task->exec_sum = 0;
+    task->misses = 0;
+}
+
+/**
+  * @brief  运行一个任务并记录执行时间
+  * @retval 完成时刻
+  */
+static uint32_t Sched_Exec(Sched_Task_t *task)
+{
+    uint32_t start = Timer3_GetTick();
+    uint32_t end;
+    uint32_t exec;
+
+    task->func();
+
+    end = Timer3_GetTick();
+    exec = end - start;
+
+    task->runs++;
+    task->exec_sum += exec;
+    if (exec < task->exec_min)
+    {
+        task->exec_min = exec;
+    }
+    if (exec > task->exec_max)
+    {
+        task->exec_max = exec;
+    }
+
+    return end;
+}
+
+/**
+  * @brief  周期任务运行后推进释放时刻，检查截止时间
+  * @param  end: 完成时刻
+  */
+static void Sched_Advance(Sched_Task_t *task, uint32_t end)
+{
+    uint32_t late;
+
+    if (task->deadline != 0 && (uint32_t)(end - task->release) > task->deadline)
+    {
+        task->misses++;
+    }
+
+    task->release += task->period;
+
+    /* 落后一个周期以上: 跳过错过的释放，从下一个未来时刻继续 */
+    late = end - task->release;
+    if ((int32_t)late >= (int32_t)task->period)
+    {
+        late = late / task->period + 1;
+        task->misses += late;
+        task->release += late * task->period;
+    }
+}
+
+/**
+  * @brief  更新占用率统计窗口
+  */
+static void Sched_UpdateLoad(uint32_t now)
+{
+    uint32_t window = now - load_window_start;
+
+    if (window >= SCHED_LOAD_WINDOW)
+    {
+        load_percent = (uint8_t)((uint64_t)load_busy * 100 / window);
+        load_busy = 0;
+        load_window_start = now;
+    }
+}
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  初始化调度器
+  * @param  tasks: 任务表，按优先级原地排序
+  * @param  count: 任务个数
+  */
+void Sched_Init(Sched_Task_t *tasks, uint8_t count)
+{
+    Sched_Task_t tmp;
+    uint32_t now = Timer3_GetTick();
+    uint8_t i, j;
+
+    /* 按优先级插入排序，同优先级保持任务表顺序 */
+    for (i = 1; i < count; i++)
+    {
+        tmp = tasks[i];
+        for (j = i; j > 0 && tasks[j - 1].priority > tmp.priority; j--)
+        {
+            tasks[j] = tasks[j - 1];
+        }
+        tasks[j] = tmp;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        tasks[i].release = now;
+        Sched_ClearStats(&tasks[i]);
+    }
+
+    sched_tasks = tasks;
+    sched_count = count;
+    load_window_start = now;
+    load_busy = 0;
+}
+
+/**
+  * @brief  调度一次
+  */
+void Sched_Run(void)
+{
+    Sched_Task_t *task;
+    uint32_t now = Timer3_GetTick();
+    uint32_t end;
+    uint8_t i;
+
+    Sched_UpdateLoad(now);
+
+    /* 优先级最高的到期周期任务 */
+    for (i = 0; i < sched_count; i++)
+    {
+        task = &sched_tasks[i];
+        if (task->period != 0 && (int32_t)(now - task->release) >= 0)
+        {
+            end = Sched_Exec(task);
+            load_busy += end - now;
+            Sched_Advance(task, end);
+            return;
+        }
+    }
+
+    /* 没有到期任务: 后台任务各运行一次 */
+    for (i = 0; i < sched_count; i++)
+    {
+        task = &sched_tasks[i];
+        if (task->period == 0)
+        {
+            now = Timer3_GetTick();
+            end = Sched_Exec(task);
+            if (task->deadline != 0 && (uint32_t)(end - now) > task->deadline)
+            {
+                task->misses++;
+            }
+        }
+    }
+}
+
+/**
+  * @brief  清零所有任务的统计
+  */
+void Sched_ResetStats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < sched_count; i++)
+    {
+        Sched_ClearStats(&sched_tasks[i]);
+    }
+}
+
+/**
+  * @brief  任务个数
+  * @retval 任务个数
+  */
+uint8_t Sched_GetTaskCount(void)
+{
+    return sched_count;
+}
+
+/**
+  * @brief  按优先级顺序取任务
+  * @param  index: 序号
+  * @retval 任务，序号越界时为0
+  */
+const Sched_Task_t *Sched_GetTask(uint8_t index)
+{
+    return (index < sched_count) ? &sched_tasks[index] : 0;
+}
+
+/**
+  * @brief  任务平均执行时间
+  * @param  task: 任务
+  * @retval 平均执行时间 (10us)
+  */
+uint32_t Sched_GetExecAvg(const Sched_Task_t *task)
+{
+    return (task->runs == 0) ? 0 : (uint32_t)(task->exec_sum / task->runs);
+}
+
+/**
+  * @brief  所有任务的截止时间错过次数之和
+  * @retval 次数
+  */
+uint32_t Sched_GetTotalMisses(void)
+{
+    uint32_t total = 0;
+    uint8_t i;
+
+    for (i = 0; i < sched_count; i++)
+    {
+        total += sched_tasks[i].misses;
+    }
+    return total;
+}
+
+/**
+  * @brief  CPU占用率
+  * @retval 最近一秒周期任务执行时间占比 (%)
+  */
+uint8_t Sched_GetLoad(void)
+{
+    return load_percent;
+}
+
+#ifdef ENABLE_UART_DEBUG
+/**
+  * @brief  经调试串口输出任务统计表
+  * @note   时间单位10us，min在未运行时显示0
+  */
+void Sched_ReportTask(void)
+{
+    const Sched_Task_t *task;
+
+    if (report_row == 0)
+    {
+        printf("\r\ntask  prio     runs   min   avg   max  miss  load %u%%\r\n", load_percent);
+        report_row = 1;
+        return;
+    }
+
+    task = &sched_tasks[report_row - 1];
+    printf("%-5s %4u %8lu %5lu %5lu %5lu %5lu\r\n",
+           task->name, task->priority, (unsigned long)task->runs,
+           (unsigned long)(task->runs ? task->exec_min : 0),
+           (unsigned long)Sched_GetExecAvg(task),
+           (unsigned long)task->exec_max,
+           (unsigned long)task->misses);
+
+    if (++report_row > sched_count)
+    {
+        report_row = 0;
+    }
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file    scheduler.h
+  * @brief   协作式任务调度器头文件
+  *
+  * @details 任务运行到结束后才调度下一个，不抢占，任务函数内不可阻塞等待。
+  *          任务表由调用者静态定义，每个任务声明周期、截止时间和优先级:
+  *
+  *          static Sched_Task_t tasks[] = {
+  *                         名称      函数            周期           截止时间       优先级
+  *              SCHED_TASK("ecgup", Upload_Task,  SCHED_MS(10),  SCHED_MS(10),  0),
+  *              SCHED_TASK("esp",   ESP_Task,     0,             SCHED_MS(5),   9),
+  *          };
+  *
+  *          - 周期任务: 到期后按优先级（数值小者优先）逐个运行
+  *          - 周期为0的后台任务: 没有到期的周期任务时各运行一次
+  *          - 时间基准为 Timer3_GetTick()，单位10us
+  ******************************************************************************
+  */
+
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <stdint.h>
+#include "kconfig.h"
+
+/*============================ 宏定义 ============================*/
+
+/** 毫秒换算为调度时间单位 (10us) */
+#define SCHED_MS(ms)        ((uint32_t)(ms) * (TIM3_COUNTER_FREQ / 1000))
+
+/** 任务表中的一项: 只给出前5项，其余由调度器维护（指定初始化，未给出的成员为0） */
+#define SCHED_TASK(n, f, p, d, prio) \
+    { .name = (n), .func = (f), .period = (p), .deadline = (d), .priority = (prio) }
+
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  任务
+  * @note   前5项在任务表中静态给出，其余由调度器维护
+  */
+typedef struct
+{
+    const char *name;           /**< 任务名（调试输出用，不超过5个字符） */
+    void (*func)(void);         /**< 任务函数 */
+    uint32_t period;            /**< 周期 (10us)，0为后台任务 */
+    uint32_t deadline;          /**< 周期任务: 释放到完成的最长时间；后台任务: 最长执行时间 (10us)，0不检查 */
+    uint8_t  priority;          /**< 优先级，数值小者优先 */
+
+    uint32_t release;           /**< 下一次释放时刻 */
+    uint32_t runs;              /**< 运行次数 */
+    uint32_t exec_min;          /**< 最短执行时间 (10us) */
+    uint32_t exec_max;          /**< 最长执行时间 (10us) */
+    uint64_t exec_sum;          /**< 执行时间累计 (10us) */
+    uint32_t misses;            /**< 超过截止时间或被跳过的次数 */
+} Sched_Task_t;
+
+/*============================ 函数声明 ============================*/
+
+/**
+  * @brief  初始化调度器
+  * @param  tasks: 任务表，按优先级原地排序
+  * @param  count: 任务个数
+  * @note   在Timer3_Init之后调用，所有周期任务立即到期
+  */
+void Sched_Init(Sched_Task_t *tasks, uint8_t count);
+
+/**
+  * @brief  调度一次（主循环中反复调用）
+  * @note   运行优先级最高的一个到期周期任务；没有到期任务时各后台任务运行一次
+  */
+void Sched_Run(void);
+
+/**
+  * @brief  清零所有任务的统计
+  */
+void Sched_ResetStats(void);
+
+/**
+  * @brief  任务个数
+  */
+uint8_t Sched_GetTaskCount(void);
+
+/**
+  * @brief  按优先级顺序取任务
+  * @param  index: 0 ~ Sched_GetTaskCount()-1
+  */
+const Sched_Task_t *Sched_GetTask(uint8_t index);
+
+/**
+  * @brief  任务平均执行时间
+  * @retval 平均执行时间 (10us)，未运行过为0
+  */
+uint32_t Sched_GetExecAvg(const Sched_Task_t *task);
+
+/**
+  * @brief  所有任务的截止时间错过次数之和
+  */
+uint32_t Sched_GetTotalMisses(void);
+
+/**
+  * @brief  CPU占用率
+  * @retval 最近一秒周期任务执行时间占比 (%)，后台任务不计入
+  */
+uint8_t Sched_GetLoad(void);
+
+#ifdef ENABLE_UART_DEBUG
+/**
+  * @brief  经调试串口输出任务统计表（作为周期任务注册）
+  * @note   每次调用输出一行，避免一次阻塞过久；一轮输出完后从表头重新开始
+  */
+void Sched_ReportTask(void);
+#endif
+
+#endif
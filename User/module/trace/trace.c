@@ -0,0 +1,473 @@
+/**
+  ******************************************************************************
+  * @file    trace.c
+  * @brief   采样数据记录格式与记录器实现
+  *
+  * @details 格式部分（编码、解析）不依赖外设，主机上的重放程序也使用。
+  *
+  *          记录器（ENABLE_TRACE_RECORD）:
+  *
+  *          I2C中断 --Trace_RecordPPG--> [ PPG队列 ] --+
+  *                                                     +--Trace_Process--> 发送缓冲 --DMA--> USART1
+  *          DMA中断 --Trace_RecordECG--> [ ECG队列 ] --+     (按时间戳合并)
+  *
+  *          - 两个采集中断各自一个字节队列，中断中只写入完整的记录，
+  *            放不下时整条丢弃并计数，由任务补发LOST记录
+  *          - 任务每次把两个队列中的记录按时间戳先后拷入发送缓冲，
+  *            上一次DMA发送完成前不取数据，积压留在队列中
+  *          - 每秒插入一条INFO记录，接收端可从任意时刻开始录制；
+  *            INFO带当前页面，页面切换时立即补发，重放时按记录切换页面
+  ******************************************************************************
+  */
+
+#include "trace.h"
+#include "string.h"
+
+#ifdef ENABLE_TRACE_RECORD
+#include "Timer2.h"
+#include "module/ring/ring.h"
+#include "./usart/bsp_debug_usart.h"
+#include "key.h"
+#include "max30102.h"
+#endif
+
+/*============================ 私有定义 ============================*/
+
+/* 解析器状态 */
+#define TRACE_ST_SYNC           0
+#define TRACE_ST_TYPE           1
+#define TRACE_ST_LEN            2
+#define TRACE_ST_TICK           3
+#define TRACE_ST_PAYLOAD        4
+#define TRACE_ST_CRC            5
+
+/** CRC-8 查表 (多项式0x07)，中断中每条记录要算约200字节 */
+static const uint8_t trace_crc_table[256] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
+};
+
+/*============================ 私有函数 ============================*/
+
+/**
+  * @brief  写入记录头（同步、类型、长度、时间戳）
+  * @retval TRACE_HEAD_LEN
+  */
+static uint8_t Trace_PutHead(uint8_t *out, uint8_t type, uint32_t tick, uint8_t len)
+{
+    out[0] = TRACE_SYNC;
+    out[1] = type;
+    out[2] = len;
+    out[3] = (uint8_t)tick;
+    out[4] = (uint8_t)(tick >> 8);
+    out[5] = (uint8_t)(tick >> 16);
+    out[6] = (uint8_t)(tick >> 24);
+    return TRACE_HEAD_LEN;
+}
+
+/*============================ 格式函数 ============================*/
+
+/**
+  * @brief  CRC-8 (多项式0x07)
+  */
+uint8_t Trace_CRC8(uint8_t crc, const uint8_t *data, uint16_t len)
+{
+    while (len--)
+    {
+        crc = trace_crc_table[crc ^ *data++];
+    }
+    return crc;
+}
+
+/**
+  * @brief  编码一条记录
+  */
+uint16_t Trace_Encode(uint8_t *out, uint8_t type, uint32_t tick, const uint8_t *payload, uint8_t len)
+{
+    uint8_t n = Trace_PutHead(out, type, tick, len);
+
+    memcpy(out + n, payload, len);
+    out[n + len] = Trace_CRC8(0, out + 1, (uint16_t)(n - 1 + len));
+    return (uint16_t)(n + len + 1);
+}
+
+/**
+  * @brief  打包INFO记录的payload
+  */
+void Trace_PackInfo(uint8_t *payload, const Trace_Info_t *info)
+{
+    payload[0] = info->version;
+    payload[1] = info->flags;
+    payload[2] = (uint8_t)info->ecg_rate;
+    payload[3] = (uint8_t)(info->ecg_rate >> 8);
+    payload[4] = (uint8_t)info->ppg_rate;
+    payload[5] = (uint8_t)(info->ppg_rate >> 8);
+    payload[6] = info->page;
+}
+
+/**
+  * @brief  解出INFO记录
+  */
+void Trace_GetInfo(const Trace_Record_t *rec, Trace_Info_t *info)
+{
+    info->version = rec->payload[0];
+    info->flags = rec->payload[1];
+    info->ecg_rate = (uint16_t)(rec->payload[2] | rec->payload[3] << 8);
+    info->ppg_rate = (uint16_t)(rec->payload[4] | rec->payload[5] << 8);
+    info->page = (rec->len >= TRACE_INFO_LEN) ? rec->payload[6] : TRACE_PAGE_UNKNOWN;
+}
+
+/**
+  * @brief  初始化解析器
+  */
+void Trace_ParserInit(Trace_Parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->state = TRACE_ST_SYNC;
+}
+
+/**
+  * @brief  送入一个字节
+  */
+uint8_t Trace_ParserFeed(Trace_Parser_t *p, uint8_t byte)
+{
+    switch (p->state)
+    {
+    case TRACE_ST_SYNC:
+        if (byte == TRACE_SYNC)
+        {
+            p->state = TRACE_ST_TYPE;
+        }
+        else
+        {
+            p->skipped++;
+        }
+        break;
+
+    case TRACE_ST_TYPE:
+        p->rec.type = byte;
+        p->rec.tick = 0;
+        p->crc = trace_crc_table[byte];
+        p->state = TRACE_ST_LEN;
+        break;
+
+    case TRACE_ST_LEN:
+        p->rec.len = byte;
+        p->crc = trace_crc_table[p->crc ^ byte];
+        p->pos = 0;
+        p->state = TRACE_ST_TICK;
+        break;
+
+    case TRACE_ST_TICK:
+        p->rec.tick |= (uint32_t)byte << (8 * p->pos);
+        p->crc = trace_crc_table[p->crc ^ byte];
+        if (++p->pos >= 4)
+        {
+            p->pos = 0;
+            p->state = (p->rec.len > 0) ? TRACE_ST_PAYLOAD : TRACE_ST_CRC;
+        }
+        break;
+
+    case TRACE_ST_PAYLOAD:
+        p->rec.payload[p->pos] = byte;
+        p->crc = trace_crc_table[p->crc ^ byte];
+        if (++p->pos >= p->rec.len)
+        {
+            p->state = TRACE_ST_CRC;
+        }
+        break;
+
+    default:
+        p->state = TRACE_ST_SYNC;
+        if (byte == p->crc)
+        {
+            return 1;
+        }
+        p->crc_errors++;
+        break;
+    }
+    return 0;
+}
+
+/**
+  * @brief  取PPG记录中的第i个采样点
+  */
+void Trace_GetPPG(const Trace_Record_t *rec, uint8_t i, int32_t *out)
+{
+    const uint8_t *p = &rec->payload[i * TRACE_PPG_SAMPLE_BYTES];
+
+    out[0] = ((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) & 0x03ffff;
+    out[1] = ((uint32_t)p[3] << 16 | (uint32_t)p[4] << 8 | p[5]) & 0x03ffff;
+}
+
+/**
+  * @brief  取ECG记录中的第i个采样点
+  */
+uint16_t Trace_GetECG(const Trace_Record_t *rec, uint8_t i)
+{
+    const uint8_t *p = &rec->payload[1 + i * 2];
+
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+/*============================ 记录器 ============================*/
+
+#ifdef ENABLE_TRACE_RECORD
+
+#define TRACE_RING_SIZE         512     /**< 每个队列的字节数，须为2的幂，至少放下一条最长的记录 */
+#define TRACE_TX_SIZE           256     /**< 一次DMA发送的最大字节数，至少放下一条最长的记录 */
+#define TRACE_INFO_PERIOD       TIM3_COUNTER_FREQ   /**< INFO记录间隔 (10us) */
+#define TRACE_ECG_PERIOD        (TIM3_COUNTER_FREQ / ECG_SAMPLE_FREQ)   /**< ECG采样间隔 (10us) */
+
+/* 一条ECG记录的最多点数，同时受payload长度和发送缓冲限制；
+   放不进发送缓冲的记录会一直留在队列头部，记录器从此只能丢弃 */
+#if TRACE_TX_SIZE - TRACE_OVERHEAD < TRACE_PAYLOAD_MAX
+#define TRACE_ECG_MAX           ((TRACE_TX_SIZE - TRACE_OVERHEAD - 1) / 2)
+#else
+#define TRACE_ECG_MAX           TRACE_ECG_COUNT_MAX
+#endif
+
+#ifdef MAX30102_HIGH_RATE
+#define TRACE_PPG_RATE          MAX30102_RAW_SPS
+#define TRACE_FLAGS             TRACE_FLAG_PPG_HIGH_RATE
+#else
+#define TRACE_PPG_RATE          PPG_SAMPLE_FREQ
+#define TRACE_FLAGS             0
+#endif
+
+#if !RING_IS_POW2(TRACE_RING_SIZE)
+#error "TRACE_RING_SIZE must be a power of 2"
+#endif
+#if MAX30102_FIFO_DEPTH * TRACE_PPG_SAMPLE_BYTES > TRACE_PAYLOAD_MAX || \
+    MAX30102_FIFO_DEPTH * TRACE_PPG_SAMPLE_BYTES + TRACE_OVERHEAD > TRACE_TX_SIZE
+#error "TRACE_TX_SIZE must hold a PPG record of a full FIFO read"
+#endif
+#if TRACE_RING_SIZE < TRACE_TX_SIZE
+#error "TRACE_RING_SIZE must hold the longest record"
+#endif
+
+static uint8_t trace_ppg_buf[TRACE_RING_SIZE];
+static uint8_t trace_ecg_buf[TRACE_RING_SIZE];
+static Ring_t trace_ppg_ring;
+static Ring_t trace_ecg_ring;
+
+static volatile uint16_t trace_ppg_lost = 0;    /**< 丢弃的PPG记录数（中断计数） */
+static volatile uint16_t trace_ecg_lost = 0;    /**< 丢弃的ECG记录数（中断计数） */
+static uint16_t trace_ppg_lost_sent = 0;        /**< 已由LOST记录报告的数量 */
+static uint16_t trace_ecg_lost_sent = 0;
+
+static uint8_t trace_tx_buf[TRACE_TX_SIZE];     /**< DMA发送缓冲 */
+static uint32_t trace_info_tick = 0;            /**< 上次发送INFO的时刻 */
+static uint8_t trace_info_sent = 0;
+static uint8_t trace_info_page = 0;             /**< 上一条INFO记录的页面 */
+
+/**
+  * @brief  向队列写入一条完整的记录（生产者，中断中调用）
+  * @param  tick: 记录的时间戳
+  * @param  pre: payload前缀（ECG电极状态），可为NULL
+  * @note   放不下时整条丢弃，不写入残缺的记录
+  */
+static void Trace_Put(Ring_t *r, volatile uint16_t *lost, uint8_t type, uint32_t tick,
+                      const uint8_t *pre, uint8_t pre_len, const uint8_t *data, uint8_t data_len)
+{
+    uint8_t head[TRACE_HEAD_LEN + 1];
+    uint8_t len = (uint8_t)(pre_len + data_len);
+    uint8_t n;
+    uint8_t crc;
+
+    if (Ring_Free(r) < len + TRACE_OVERHEAD)
+    {
+        (*lost)++;
+        return;
+    }
+
+    n = Trace_PutHead(head, type, tick, len);
+    if (pre_len > 0)
+    {
+        memcpy(head + n, pre, pre_len);
+        n += pre_len;
+    }
+    crc = Trace_CRC8(0, head + 1, n - 1);
+    crc = Trace_CRC8(crc, data, data_len);
+
+    Ring_PutN(r, head, n);
+    Ring_PutN(r, data, data_len);
+    Ring_PutN(r, &crc, 1);
+}
+
+/**
+  * @brief  查看队列中最早的一条记录（消费者）
+  * @param  tick: 输出该记录的时间戳
+  * @retval 记录总字节数，0: 没有完整的记录
+  */
+static uint16_t Trace_Peek(const Ring_t *r, uint32_t *tick)
+{
+    uint32_t count = Ring_Count(r);
+    uint32_t tail = r->tail;
+    uint16_t total;
+    uint8_t i;
+
+    if (count < TRACE_OVERHEAD)
+    {
+        return 0;
+    }
+    total = (uint16_t)(*(const uint8_t *)Ring_At(r, tail + 2) + TRACE_OVERHEAD);
+    if (count < total)
+    {
+        return 0;
+    }
+
+    *tick = 0;
+    for (i = 0; i < 4; i++)
+    {
+        *tick |= (uint32_t)*(const uint8_t *)Ring_At(r, tail + 3 + i) << (8 * i);
+    }
+    return total;
+}
+
+/**
+  * @brief  补发LOST记录
+  * @retval 写入后发送缓冲中的字节数
+  */
+static uint16_t Trace_PutLost(uint16_t n, uint8_t source, uint16_t lost, uint16_t *sent, uint32_t now)
+{
+    uint16_t dropped = (uint16_t)(lost - *sent);
+    uint8_t payload[TRACE_LOST_LEN];
+
+    if (dropped == 0)
+    {
+        return n;
+    }
+    payload[0] = source;
+    payload[1] = (uint8_t)dropped;
+    payload[2] = (uint8_t)(dropped >> 8);
+    *sent = lost;
+    return (uint16_t)(n + Trace_Encode(trace_tx_buf + n, TRACE_REC_LOST, now, payload, TRACE_LOST_LEN));
+}
+
+/**
+  * @brief  初始化记录器
+  */
+void Trace_Init(void)
+{
+    Ring_Init(&trace_ppg_ring, trace_ppg_buf, 1, TRACE_RING_SIZE);
+    Ring_Init(&trace_ecg_ring, trace_ecg_buf, 1, TRACE_RING_SIZE);
+}
+
+/**
+  * @brief  记录一次FIFO读出（I2C中断中调用）
+  */
+void Trace_RecordPPG(const uint8_t *fifo_bytes, uint8_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    Trace_Put(&trace_ppg_ring, &trace_ppg_lost, TRACE_REC_PPG, Timer3_GetTick(),
+              NULL, 0, fifo_bytes, (uint8_t)(count * TRACE_PPG_SAMPLE_BYTES));
+}
+
+/**
+  * @brief  记录一块ECG采样（DMA中断中调用）
+  * @note   ADC值按内存中的小端字节直接写入；超过 TRACE_ECG_MAX 点时分为多条，
+  *         各条的时间戳为其最后一点的采样时刻
+  */
+void Trace_RecordECG(const uint16_t *samples, uint16_t count, uint8_t connected)
+{
+    uint32_t now = Timer3_GetTick();
+    uint16_t n;
+
+    while (count > 0)
+    {
+        n = (count > TRACE_ECG_MAX) ? TRACE_ECG_MAX : count;
+        count -= n;
+        Trace_Put(&trace_ecg_ring, &trace_ecg_lost, TRACE_REC_ECG, now - (uint32_t)count * TRACE_ECG_PERIOD,
+                  &connected, 1, (const uint8_t *)samples, (uint8_t)(n * 2));
+        samples += n;
+    }
+}
+
+/**
+  * @brief  经调试串口DMA发出已记录的数据
+  * @note   上一次发送未完成时直接返回，记录留在队列中，队列满后由中断侧丢弃计数
+  */
+void Trace_Process(void)
+{
+    uint32_t now = Timer3_GetTick();
+    uint32_t ppg_tick = 0, ecg_tick = 0;
+    uint16_t ppg_len, ecg_len, len;
+    uint16_t n = 0;
+    uint8_t payload[TRACE_INFO_LEN];
+    Trace_Info_t info;
+    Ring_t *r;
+
+    if (Usart_TxBusy())
+    {
+        return;
+    }
+
+    if (!trace_info_sent || now - trace_info_tick >= TRACE_INFO_PERIOD || current_page != trace_info_page)
+    {
+        info.version = TRACE_VERSION;
+        info.flags = TRACE_FLAGS;
+        info.ecg_rate = ECG_SAMPLE_FREQ;
+        info.ppg_rate = TRACE_PPG_RATE;
+        info.page = current_page;
+        trace_info_page = current_page;
+        Trace_PackInfo(payload, &info);
+        n += Trace_Encode(trace_tx_buf + n, TRACE_REC_INFO, now, payload, TRACE_INFO_LEN);
+        trace_info_tick = now;
+        trace_info_sent = 1;
+    }
+    n = Trace_PutLost(n, TRACE_REC_PPG, trace_ppg_lost, &trace_ppg_lost_sent, now);
+    n = Trace_PutLost(n, TRACE_REC_ECG, trace_ecg_lost, &trace_ecg_lost_sent, now);
+
+    /* 两个队列按时间戳先后合并，直到发送缓冲放不下 */
+    while (1)
+    {
+        ppg_len = Trace_Peek(&trace_ppg_ring, &ppg_tick);
+        ecg_len = Trace_Peek(&trace_ecg_ring, &ecg_tick);
+        if (ppg_len != 0 && (ecg_len == 0 || (int32_t)(ppg_tick - ecg_tick) <= 0))
+        {
+            r = &trace_ppg_ring;
+            len = ppg_len;
+        }
+        else if (ecg_len != 0)
+        {
+            r = &trace_ecg_ring;
+            len = ecg_len;
+        }
+        else
+        {
+            break;
+        }
+
+        if (n + len > TRACE_TX_SIZE)
+        {
+            break;
+        }
+        Ring_GetN(r, trace_tx_buf + n, len);
+        n += len;
+    }
+
+    if (n > 0)
+    {
+        Usart_SendDMA(trace_tx_buf, n);
+    }
+}
+
+#endif /* ENABLE_TRACE_RECORD */
@@ -0,0 +1,182 @@
+/**
+  ******************************************************************************
+  * @file    trace.h
+  * @brief   采样数据记录格式与记录器头文件
+  *
+  * @details 把传感器实际读到的原始数据（PPG的IR/RED、ECG的ADC值和电极状态）
+  *          按时间戳记录下来，经调试串口发出，主机上用 host_replay 重放。
+  *
+  *          记录格式（字节流，可从任意位置开始接收，按同步字节和CRC重新对齐）:
+  *
+  *          | 0xA5 | type | len | tick (4B) | payload (len B) | crc8 |
+  *
+  *          - tick: 10us时间戳（Timer3_GetTick），小端
+  *          - crc8: 多项式0x07，初值0，覆盖 type ~ payload
+  *          - TRACE_REC_INFO: version, flags, ecg_rate(2B), ppg_rate(2B), page(1B)，
+  *                            每秒一条，页面切换时立即补发一条；版本1没有page
+  *          - TRACE_REC_PPG:  n x (IR 3B, RED 3B)，与FIFO中的字节相同（大端，18位有效），
+  *                            tick为读出时刻，各点按 ppg_rate 等间隔、最后一点在tick
+  *          - TRACE_REC_ECG:  电极状态(1B, 1=连接) + n x ADC值(2B小端)，
+  *                            tick为最后一点的时刻（DMA半缓冲完成时刻），
+  *                            一块超过一条记录的长度时分为多条，各条的tick按采样间隔前推
+  *          - TRACE_REC_LOST: 来源(1B) + 丢弃的记录数(2B)，记录器队列满时在下一条之前插入
+  *          多字节字段除PPG采样外均为小端
+  ******************************************************************************
+  */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdint.h>
+#include "kconfig.h"
+
+/*============================ 格式定义 ============================*/
+
+#define TRACE_SYNC              0xA5
+#define TRACE_VERSION           2
+
+#define TRACE_HEAD_LEN          7       /**< 同步 + 类型 + 长度 + 时间戳 */
+#define TRACE_OVERHEAD          (TRACE_HEAD_LEN + 1)    /**< 每条记录除payload外的字节数 */
+#define TRACE_PAYLOAD_MAX       255
+
+/* 记录类型 */
+#define TRACE_REC_INFO          0x01
+#define TRACE_REC_PPG           0x02
+#define TRACE_REC_ECG           0x03
+#define TRACE_REC_LOST          0x04
+
+/* INFO flags */
+#define TRACE_FLAG_PPG_HIGH_RATE    0x01    /**< PPG为未抽取的原始采样率 */
+
+#define TRACE_INFO_LEN          7
+#define TRACE_INFO_LEN_V1       6       /**< 版本1的INFO记录长度，没有page */
+#define TRACE_PAGE_UNKNOWN      0xFF    /**< 版本1的记录没有页面信息 */
+#define TRACE_PPG_SAMPLE_BYTES  6
+#define TRACE_LOST_LEN          3
+
+/** PPG记录的采样点数 */
+#define TRACE_PPG_COUNT(rec)    ((rec)->len / TRACE_PPG_SAMPLE_BYTES)
+/** ECG记录的采样点数 */
+#define TRACE_ECG_COUNT(rec)    (((rec)->len - 1) / 2)
+/** 一条ECG记录最多的采样点数，更长的一块分为多条 */
+#define TRACE_ECG_COUNT_MAX     ((TRACE_PAYLOAD_MAX - 1) / 2)
+
+/*============================ 类型定义 ============================*/
+
+/**
+  * @brief  INFO记录内容
+  */
+typedef struct
+{
+    uint8_t  version;
+    uint8_t  flags;                         /**< TRACE_FLAG_xxx */
+    uint16_t ecg_rate;                      /**< ECG采样率 (sps) */
+    uint16_t ppg_rate;                      /**< PPG记录中的采样率 (sps) */
+    uint8_t  page;                          /**< 当前页面 (current_page)，版本1为 TRACE_PAGE_UNKNOWN */
+} Trace_Info_t;
+
+/**
+  * @brief  一条记录
+  */
+typedef struct
+{
+    uint8_t  type;                          /**< TRACE_REC_xxx */
+    uint8_t  len;                           /**< payload长度 */
+    uint32_t tick;                          /**< 10us时间戳 */
+    uint8_t  payload[TRACE_PAYLOAD_MAX];
+} Trace_Record_t;
+
+/**
+  * @brief  字节流解析器
+  */
+typedef struct
+{
+    uint8_t  state;                         /**< 当前等待的字段 */
+    uint8_t  pos;                           /**< 字段内位置 */
+    uint8_t  crc;
+    Trace_Record_t rec;                     /**< 正在接收/已完成的记录 */
+    uint32_t crc_errors;                    /**< CRC错误丢弃的记录数 */
+    uint32_t skipped;                       /**< 对齐时跳过的字节数 */
+} Trace_Parser_t;
+
+/*============================ 格式函数 ============================*/
+
+/**
+  * @brief  CRC-8 (多项式0x07)
+  * @param  crc: 上一段的结果，首段为0
+  */
+uint8_t Trace_CRC8(uint8_t crc, const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  编码一条记录
+  * @param  out: 输出，至少 len + TRACE_OVERHEAD 字节
+  * @retval 写入的字节数
+  */
+uint16_t Trace_Encode(uint8_t *out, uint8_t type, uint32_t tick, const uint8_t *payload, uint8_t len);
+
+/**
+  * @brief  打包INFO记录的payload
+  * @param  payload: 输出，TRACE_INFO_LEN 字节
+  */
+void Trace_PackInfo(uint8_t *payload, const Trace_Info_t *info);
+
+/**
+  * @brief  解出INFO记录
+  * @note   兼容版本1的6字节记录，page为 TRACE_PAGE_UNKNOWN
+  */
+void Trace_GetInfo(const Trace_Record_t *rec, Trace_Info_t *info);
+
+/**
+  * @brief  初始化解析器
+  */
+void Trace_ParserInit(Trace_Parser_t *p);
+
+/**
+  * @brief  送入一个字节
+  * @retval 1: p->rec 中得到一条完整且校验正确的记录, 0: 未完成
+  * @note   CRC错误时丢弃整条记录，从其后重新寻找同步字节
+  */
+uint8_t Trace_ParserFeed(Trace_Parser_t *p, uint8_t byte);
+
+/**
+  * @brief  取PPG记录中的第i个采样点
+  * @param  out: [0]=IR, [1]=RED
+  */
+void Trace_GetPPG(const Trace_Record_t *rec, uint8_t i, int32_t *out);
+
+/**
+  * @brief  取ECG记录中的第i个采样点
+  */
+uint16_t Trace_GetECG(const Trace_Record_t *rec, uint8_t i);
+
+/*============================ 记录器 ============================*/
+
+#ifdef ENABLE_TRACE_RECORD
+/**
+  * @brief  初始化记录器
+  * @note   在 DEBUG_USART_Config 之后、采集中断使能之前调用
+  */
+void Trace_Init(void);
+
+/**
+  * @brief  记录一次FIFO读出（I2C中断中调用）
+  * @param  fifo_bytes: FIFO原始字节，每点6字节
+  * @param  count: 采样点数
+  */
+void Trace_RecordPPG(const uint8_t *fifo_bytes, uint8_t count);
+
+/**
+  * @brief  记录一块ECG采样（DMA中断中调用）
+  * @param  samples: ADC值
+  * @param  count: 采样点数
+  * @param  connected: 电极状态，1=连接
+  */
+void Trace_RecordECG(const uint16_t *samples, uint16_t count, uint8_t connected);
+
+/**
+  * @brief  经调试串口DMA发出已记录的数据（作为周期任务注册）
+  */
+void Trace_Process(void);
+#endif
+
+#endif
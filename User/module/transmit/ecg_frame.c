@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file    ecg_frame.c
+  * @brief   ECG上传帧编码实现
+  *
+  * @details 帧格式见 ecg_frame.h
+  *          原来每个采样点一次MQTTPUB，约50字节开销传一个12位数据；
+  *          打包后每点约2字节文本，上传速度可超过实时采样速度
+  ******************************************************************************
+  */
+
+#include "ecg_frame.h"
+
+/*============================ 私有变量 ============================*/
+
+static const char base64_table[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*============================ 函数实现 ============================*/
+
+/**
+  * @brief  base64编码
+  * @param  in: 输入数据
+  * @param  len: 输入长度
+  * @param  out: 输出缓冲区，至少 ((len + 2) / 3) * 4 字节
+  * @retval 输出字符数
+  */
+static uint16_t ECG_Frame_Base64(const uint8_t *in, uint16_t len, char *out)
+{
+    uint16_t i;
+    uint16_t o = 0;
+    uint32_t v;
+
+    for (i = 0; i + 2 < len; i += 3)
+    {
+        v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+        out[o++] = base64_table[(v >> 18) & 0x3F];
+        out[o++] = base64_table[(v >> 12) & 0x3F];
+        out[o++] = base64_table[(v >> 6) & 0x3F];
+        out[o++] = base64_table[v & 0x3F];
+    }
+
+    /* 剩余1或2字节，以'='补齐 */
+    if (i < len)
+    {
+        v = (uint32_t)in[i] << 16;
+        if (i + 1 < len)
+        {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        out[o++] = base64_table[(v >> 18) & 0x3F];
+        out[o++] = base64_table[(v >> 12) & 0x3F];
+        out[o++] = (i + 1 < len) ? base64_table[(v >> 6) & 0x3F] : '=';
+        out[o++] = '=';
+    }
+
+    return o;
+}
+
+/**
+  * @brief  编码一帧ECG数据
+  * @param  seq: 帧序号
+  * @param  timestamp_ms: 首个采样点时间戳 (ms)
+  * @param  flags: 帧标志 (ECG_FRAME_FLAG_xxx)
+  * @param  samples: 采样点（仅使用低12位）
+  * @param  count: 采样点数 (1 ~ ECG_FRAME_MAX_SAMPLES)
+  * @param  out: 输出文本缓冲区
+  * @param  out_size: 输出缓冲区大小，至少 ECG_FRAME_TEXT_LEN(count) + 1
+  * @retval 编码后的字符数，参数错误返回0
+  */
+uint16_t ECG_Frame_Encode(uint16_t seq, uint32_t timestamp_ms, uint8_t flags,
+                          const uint16_t *samples, uint8_t count,
+                          char *out, uint16_t out_size)
+{
+    uint8_t frame[ECG_FRAME_BIN_LEN(ECG_FRAME_MAX_SAMPLES)];
+    uint16_t len = ECG_FRAME_HEADER_LEN;
+    uint16_t a, b;
+    uint8_t i;
+
+    if (count == 0 || count > ECG_FRAME_MAX_SAMPLES || out_size <= ECG_FRAME_TEXT_LEN(count))
+    {
+        return 0;
+    }
+
+    /* 帧头，多字节字段为小端 */
+    frame[0] = (uint8_t)((ECG_FRAME_VERSION << 4) | (flags & 0x0F));
+    frame[1] = (uint8_t)seq;
+    frame[2] = (uint8_t)(seq >> 8);
+    frame[3] = (uint8_t)timestamp_ms;
+    frame[4] = (uint8_t)(timestamp_ms >> 8);
+    frame[5] = (uint8_t)(timestamp_ms >> 16);
+    frame[6] = (uint8_t)(timestamp_ms >> 24);
+    frame[7] = count;
+
+    /* 每2个12位采样点打包为3字节 */
+    for (i = 0; i + 1 < count; i += 2)
+    {
+        a = samples[i] & 0x0FFF;
+        b = samples[i + 1] & 0x0FFF;
+        frame[len++] = (uint8_t)a;
+        frame[len++] = (uint8_t)((a >> 8) | (b << 4));
+        frame[len++] = (uint8_t)(b >> 4);
+    }
+    if (i < count)
+    {
+        a = samples[i] & 0x0FFF;
+        frame[len++] = (uint8_t)a;
+        frame[len++] = (uint8_t)(a >> 8);
+    }
+
+    len = ECG_Frame_Base64(frame, len, out);
+    out[len] = '\0';
+
+    return len;
+}
@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file    ecg_frame.h
+  * @brief   ECG上传帧编码头文件
+  *
+  * @details 一帧打包多个12位采样点，以base64文本发送到 health/ecg 主题:
+  *
+  *          偏移  长度  内容
+  *          0     1     高4位版本号(ECG_FRAME_VERSION)，低4位标志
+  *          1     2     帧序号 (小端)
+  *          3     4     首个采样点时间戳 ms (小端)，由采样点序号换算
+  *          7     1     采样点数 n
+  *          8     ...   采样点，每2点打包为3字节:
+  *                      [a7:0] [b3:0|a11:8] [b11:4]，n为奇数时最后一点占2字节
+  *
+  *          50点的帧为83字节，编码后112个字符，一次MQTTPUB即可发送
+  ******************************************************************************
+  */
+
+#ifndef __ECG_FRAME_H
+#define __ECG_FRAME_H
+
+#include <stdint.h>
+
+/*============================ 帧格式配置 ============================*/
+
+#define ECG_FRAME_VERSION       1       /**< 帧格式版本 */
+#define ECG_FRAME_HEADER_LEN    8       /**< 帧头长度 (字节) */
+#define ECG_FRAME_MAX_SAMPLES   50      /**< 每帧最多采样点数 */
+
+#define ECG_FRAME_FLAG_LAST     0x01    /**< 单次上传的最后一帧 */
+#define ECG_FRAME_FLAG_GAP      0x02    /**< 与上一帧之间有丢点（连续上传队列满） */
+#define ECG_FRAME_FLAG_LEADOFF  0x04    /**< 电极脱落 */
+
+/** 帧二进制长度 */
+#define ECG_FRAME_BIN_LEN(n)    (ECG_FRAME_HEADER_LEN + ((n) * 3 + 1) / 2)
+
+/** base64编码后长度（不含结束符） */
+#define ECG_FRAME_TEXT_LEN(n)   (((ECG_FRAME_BIN_LEN(n) + 2) / 3) * 4)
+
+/*============================ 函数声明 ============================*/
+
+/**
+  * @brief  编码一帧ECG数据
+  * @param  seq: 帧序号
+  * @param  timestamp_ms: 首个采样点时间戳 (ms)
+  * @param  flags: 帧标志 (ECG_FRAME_FLAG_xxx)
+  * @param  samples: 采样点（仅使用低12位）
+  * @param  count: 采样点数 (1 ~ ECG_FRAME_MAX_SAMPLES)
+  * @param  out: 输出文本缓冲区
+  * @param  out_size: 输出缓冲区大小，至少 ECG_FRAME_TEXT_LEN(count) + 1
+  * @retval 编码后的字符数，参数错误返回0
+  */
+uint16_t ECG_Frame_Encode(uint16_t seq, uint32_t timestamp_ms, uint8_t flags,
+                          const uint16_t *samples, uint8_t count,
+                          char *out, uint16_t out_size);
+
+#endif /* __ECG_FRAME_H */
@@ -10,6 +10,7 @@
   */
 
 #include "transmit.h"
+#include "ecg_frame.h"
 #include "esp8266.h"
 #include "max30102.h"
 #include "ad8232.h"
@@ -22,8 +23,10 @@ static uint16_t transmit_counter = 0;   /**< 传输计时器 (秒) */
 static uint16_t alarm_counter = 0;      /**< 报警检测计时器 (秒) */
 
 /* ECG上传相关 */
-static uint16_t ecg_batch_buffer[1];    /**< ECG批次缓冲区 */
-static uint32_t ecg_batch_timestamp = 0; /**< 批次时间戳 */
+static uint16_t ecg_batch_buffer[ECG_FRAME_MAX_SAMPLES];            /**< ECG批次缓冲区 */
+static char     ecg_frame_text[ECG_FRAME_TEXT_LEN(ECG_FRAME_MAX_SAMPLES) + 1]; /**< 编码后的帧 */
+static uint16_t ecg_frame_seq = 0;       /**< 帧序号，持续递增，服务端据此发现丢帧 */
+static uint32_t ecg_next_position = 0;   /**< 下一帧首点应有的采样点序号，不等时与上一帧之间有丢点 */
 
 /*============================================================================*/
 /*                              全局变量                                       */
@@ -31,7 +34,6 @@ static uint32_t ecg_batch_timestamp = 0; /**< 批次时间戳 */
 
 volatile uint8_t transmit_flag = 0;     /**< 传输触发标志 */
 volatile uint8_t alarm_check_flag = 0;  /**< 报警检测标志 */
-volatile uint8_t ecg_upload_flag = 0;   /**< ECG上传触发标志（100ms一次） */
 
 /*============================================================================*/
 /*                              函数实现                                       */
@@ -163,47 +165,101 @@ void Transmit_TimerCallback(void)
 /*============================================================================*/
 
 /**
- * @brief  开始ECG上传（由按键触发）
- * @param  timestamp: 当前时间戳
+ * @brief  开始单次ECG上传（由按键触发）
+ * @note   上传按键前最近3秒的数据
  */
-void Transmit_StartECGUpload(uint32_t timestamp)
+void Transmit_StartECGUpload(void)
 {
-    ecg_batch_timestamp = timestamp;
-    ECG_StartUpload(timestamp);
+    ECG_StartUpload();
+    ecg_next_position = ECG_GetUploadPosition();
+}
+
+/**
+ * @brief  切换连续ECG上传（由按键触发）
+ */
+void Transmit_ToggleECGStream(void)
+{
+    if (ECG_GetUploadMode() == ECG_UPLOAD_STREAM)
+    {
+        ECG_StopUpload();
+    }
+    else
+    {
+        ECG_StartStream();
+        ecg_next_position = ECG_GetUploadPosition();
+    }
 }
 
 /**
  * @brief  ECG上传处理（在主循环中调用）
- * @note   每100ms发送一批数据（20个采样点）
+ * @note   由调度器每10ms调用一次，上一帧已应答时打包最多ECG_FRAME_MAX_SAMPLES个点发送
+ *         一帧50点(250ms数据)，上传速度由模块应答决定，远快于实时采样
+ *         连续上传时攒满一帧再发送；模块跟不上时数据留在队列中，队列满则丢点
+ *         帧排队成功后才取出数据，发不出去的数据留在队列中下次重发
  */
 void Transmit_ECGUploadProcess(void)
 {
     uint16_t count;
+    uint16_t len;
+    uint8_t flags = 0;
+    uint32_t position;
+    uint32_t timestamp_ms;
+    uint8_t mode = ECG_GetUploadMode();
     
     /* 检查是否有上传任务 */
-    if (ECG_IsUploadComplete())
+    if (mode == ECG_UPLOAD_IDLE)
+    {
+        return;
+    }
+    
+    /* 模块忙时不取数据，避免取出后发不出去 */
+    if (!ESP8266_IsReady())
+    {
+        return;
+    }
+    
+    /* 连续上传: 攒满一帧再发 */
+    if (mode == ECG_UPLOAD_STREAM && ECG_GetUploadDataCount() < ECG_FRAME_MAX_SAMPLES)
     {
         return;
     }
     
-    /* 检查上传标志（100ms触发一次） */
-    if (!ecg_upload_flag)
+    /* 读取一批数据（先不取出） */
+    position = ECG_GetUploadPosition();
+    count = ECG_PeekUploadBatch(ecg_batch_buffer, ECG_FRAME_MAX_SAMPLES);
+    if (count == 0)
     {
         return;
     }
-    ecg_upload_flag = 0;
     
-    /* 获取一批数据 */
-    count = ECG_GetUploadBatch(ecg_batch_buffer, 1);
+    if (mode == ECG_UPLOAD_ONESHOT && count >= ECG_GetUploadDataCount())
+    {
+        flags |= ECG_FRAME_FLAG_LAST;
+    }
+    if (position != ecg_next_position)
+    {
+        flags |= ECG_FRAME_FLAG_GAP;    /* 与上一帧之间有丢点 */
+    }
+    if (!GetConnect())
+    {
+        flags |= ECG_FRAME_FLAG_LEADOFF;
+    }
+    
+    /* 首个采样点时间 = 采样点序号 / 采样率，分两步计算避免溢出 */
+    timestamp_ms = (position / ECG_SAMPLE_FREQ) * 1000
+                 + (position % ECG_SAMPLE_FREQ) * 1000 / ECG_SAMPLE_FREQ;
     
-    if (count > 0)
+    len = ECG_Frame_Encode(ecg_frame_seq, timestamp_ms, flags,
+                           ecg_batch_buffer, (uint8_t)count,
+                           ecg_frame_text, sizeof(ecg_frame_text));
+    if (len == 0 || ESP8266_SendECGFrame(ecg_frame_text) != 0)
     {
-        /* 发送到MQTT */
-        ESP8266_SendECGBatch(ecg_batch_timestamp, ecg_batch_buffer, (uint8_t)count);
-        
-        /* 更新时间戳（每批20个点，200Hz采样 = 100ms） */
-        ecg_batch_timestamp += 10;  /* 1点，每10ms发送 */
+        return;
     }
+    
+    ECG_ConsumeUpload(count);
+    ecg_next_position = position + count;
+    ecg_frame_seq++;
 }
 
 /**
@@ -224,3 +280,12 @@ uint8_t Transmit_IsECGUploadComplete(void)
     return ECG_IsUploadComplete();
 }
 
+/**
+ * @brief  是否处于连续上传
+ * @retval 1: 连续上传中, 0: 否
+ */
+uint8_t Transmit_IsECGStreaming(void)
+{
+    return ECG_GetUploadMode() == ECG_UPLOAD_STREAM;
+}
+
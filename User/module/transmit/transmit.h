@@ -86,18 +86,21 @@ void Transmit_TimerCallback(void);
 
 /*============================ ECG上传接口 ============================*/
 
-/* ECG上传标志（由定时器设置，100ms一次） */
-extern volatile uint8_t ecg_upload_flag;
+/**
+ * @brief  开始单次ECG上传（由按键触发）
+ * @note   上传按键前最近3秒的数据
+ */
+void Transmit_StartECGUpload(void);
 
 /**
- * @brief  开始ECG上传（由按键触发）
- * @param  timestamp: 当前时间戳
+ * @brief  切换连续ECG上传（由按键触发）
+ * @note   开启后持续上传，离开心电图页面也不停止，再次调用关闭
  */
-void Transmit_StartECGUpload(uint32_t timestamp);
+void Transmit_ToggleECGStream(void);
 
 /**
- * @brief  ECG上传处理（在主循环中调用）
- * @note   每100ms发送一批数据（20个采样点）
+ * @brief  ECG上传处理（调度器每10ms调用）
+ * @note   模块空闲时打包一帧（最多50个采样点）发送，帧格式见 ecg_frame.h
  */
 void Transmit_ECGUploadProcess(void);
 
@@ -113,5 +116,11 @@ uint8_t Transmit_GetECGProgress(void);
  */
 uint8_t Transmit_IsECGUploadComplete(void);
 
+/**
+ * @brief  是否处于连续上传
+ * @retval 1: 连续上传中, 0: 否
+ */
+uint8_t Transmit_IsECGStreaming(void);
+
 #endif /* __TRANSMIT_H */
 
@@ -23,7 +23,11 @@
 #include "stm32f10x.h"
 #include "stm32f10x_rcc.h"     // 包含 RCC 外设定义
 #include "stm32f10x_gpio.h"
+#include "stm32f10x_i2c.h"
+#include "stm32f10x_dma.h"
 #include "OLED.h"
+#include "Timer2.h"
+#include "module/irqstat/irqstat.h"
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
@@ -85,11 +89,53 @@
   */
 uint8_t OLED_DisplayBuf[8][128];
 
+/**
+  * 脏区记录
+  * 绘图函数改动显存时记录每页被改动的列范围[OLED_DirtyX0, OLED_DirtyX1]，X0大于X1表示该页未改动
+  * OLED_ShadowBuf是屏幕上实际内容的副本，更新时在脏区内与之比较，只发送不同的字节
+  */
+static uint8_t OLED_ShadowBuf[8][128];
+static uint8_t OLED_DirtyX0[8];
+static uint8_t OLED_DirtyX1[8];
+
+/**
+  * 本次更新各页需要发送的范围，由OLED_CollectSpans计算
+  */
+static uint8_t OLED_SpanX[8];					//各页发送的起始列
+static uint8_t OLED_SpanWidth[8];				//各页发送的列数，0表示该页不发送
+
+/**
+  * 异步更新完成回调，为0时不回调
+  */
+static void (*OLED_DoneCallback)(void);
+
+#ifdef OLED_USE_HW_I2C
+/**
+  * 硬件I2C传输状态
+  * 每页为一次I2C传输：7字节页/列地址命令头 + 该页需要发送的显存数据
+  * 发送某页前才把该页显存复制到OLED_TxBuf，DMA发送期间可以继续写显存
+  */
+#define OLED_I2C_ADDR		0x78				//OLED的I2C从机地址（写）
+#define OLED_TX_HEAD_LEN	7					//命令头长度
+#define OLED_TX_TIMEOUT_MS	50					//一帧发送超时，整屏8页@400kHz约需25ms
+#define OLED_TX_WAIT_SPIN	0x80000				//阻塞等待的循环次数上限，TIM3启动前（初始化阶段）以此限时
+
+static uint8_t OLED_TxBuf[OLED_TX_HEAD_LEN + 128];	//单页DMA发送缓冲
+static volatile uint8_t OLED_TxPage;			//当前正在发送的页
+static volatile uint8_t OLED_TxBusy;			//帧发送中标志
+static volatile uint8_t OLED_TxRetry;			//出错未发完的页（按位），下次计算范围时重新标记为脏
+static uint32_t OLED_TxStartTick;				//本帧开始发送的时刻 (10us)
+uint32_t OLED_TxErrorCount;						//总线错误次数（NACK、仲裁丢失、超时等）
+uint32_t OLED_TxRecoverCount;					//总线恢复次数
+#endif
+
 /*********************全局变量*/
 
 
 /*引脚配置*********************/
 
+#ifndef OLED_USE_HW_I2C
+
 /**
   * 函    数：OLED写SCL高低电平
   * 参    数：要写入SCL的电平值，范围：0/1
@@ -157,11 +203,165 @@ void OLED_GPIO_Init(void)
 	OLED_W_SDA(1);
 }
 
+#else
+
+/**
+  * 函    数：I2C1外设初始化
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：400kHz主机发送，引脚和DMA由OLED_GPIO_Init配置
+  */
+static void OLED_HW_PeriphInit(void)
+{
+	I2C_InitTypeDef I2C_InitStructure;
+	
+	I2C_DeInit(I2C1);
+	I2C_InitStructure.I2C_Mode = I2C_Mode_I2C;
+	I2C_InitStructure.I2C_DutyCycle = I2C_DutyCycle_2;
+	I2C_InitStructure.I2C_OwnAddress1 = 0x00;
+	I2C_InitStructure.I2C_Ack = I2C_Ack_Disable;			//只发送，不需要应答
+	I2C_InitStructure.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+	I2C_InitStructure.I2C_ClockSpeed = 400000;				//400kHz
+	I2C_Init(I2C1, &I2C_InitStructure);
+	I2C_Cmd(I2C1, ENABLE);
+}
+
+/**
+  * 函    数：总线恢复时的半个SCL周期延时（约5us）
+  * 参    数：无
+  * 返 回 值：无
+  */
+static void OLED_HW_BitDelay(void)
+{
+	volatile uint16_t i;
+	for (i = 0; i < 40; i ++);
+}
+
+/**
+  * 函    数：I2C1总线恢复
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：仲裁丢失、总线错误后BUSY可能一直置位，从机也可能拉住SDA，
+  *           之后START不会产生任何中断。与传感器I2C的恢复方法相同：
+  *           PB8/PB9切换为GPIO开漏输出，输出最多9个SCL时钟直到SDA释放，
+  *           再产生STOP，最后软件复位并重新初始化I2C1
+  */
+static void OLED_HW_BusRecover(void)
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	uint8_t i;
+	
+	I2C_Cmd(I2C1, DISABLE);
+	
+	GPIO_SetBits(GPIOB, GPIO_Pin_8 | GPIO_Pin_9);
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_OD;
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_8 | GPIO_Pin_9;
+	GPIO_Init(GPIOB, &GPIO_InitStructure);
+	
+	/*9个SCL时钟，从机移出剩余位后会释放SDA*/
+	for (i = 0; i < 9; i ++)
+	{
+		if (GPIO_ReadInputDataBit(GPIOB, GPIO_Pin_9)) {break;}
+		GPIO_ResetBits(GPIOB, GPIO_Pin_8);
+		OLED_HW_BitDelay();
+		GPIO_SetBits(GPIOB, GPIO_Pin_8);
+		OLED_HW_BitDelay();
+	}
+	
+	/*STOP：SCL为高时SDA由低变高*/
+	GPIO_ResetBits(GPIOB, GPIO_Pin_8);
+	OLED_HW_BitDelay();
+	GPIO_ResetBits(GPIOB, GPIO_Pin_9);
+	OLED_HW_BitDelay();
+	GPIO_SetBits(GPIOB, GPIO_Pin_8);
+	OLED_HW_BitDelay();
+	GPIO_SetBits(GPIOB, GPIO_Pin_9);
+	OLED_HW_BitDelay();
+	
+	/*引脚交还I2C1，软件复位清除BUSY等残留状态，再重新初始化*/
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_OD;
+	GPIO_Init(GPIOB, &GPIO_InitStructure);
+	I2C_SoftwareResetCmd(I2C1, ENABLE);
+	I2C_SoftwareResetCmd(I2C1, DISABLE);
+	OLED_HW_PeriphInit();
+	
+	OLED_TxRecoverCount ++;
+}
+
+/**
+  * 函    数：OLED引脚及硬件I2C初始化
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：I2C1重映射到PB8/PB9（与软件I2C接线相同），400kHz
+  *           DMA1通道6负责I2C1_TX，传输过程由I2C1事件/错误中断和DMA中断推进
+  */
+void OLED_GPIO_Init(void)
+{
+	uint32_t i, j;
+	
+	/*在初始化前，加入适量延时，待OLED供电稳定*/
+	for (i = 0; i < 1000; i ++)
+	{
+		for (j = 0; j < 1000; j ++);
+	}
+	
+	/*开启时钟*/
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB | RCC_APB2Periph_AFIO, ENABLE);
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+	
+	/*I2C1重映射到PB8(SCL)/PB9(SDA)，复用开漏输出*/
+	GPIO_PinRemapConfig(GPIO_Remap_I2C1, ENABLE);
+	
+	GPIO_InitTypeDef GPIO_InitStructure;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_OD;
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_8 | GPIO_Pin_9;
+	GPIO_Init(GPIOB, &GPIO_InitStructure);
+	
+	/*I2C1初始化*/
+	OLED_HW_PeriphInit();
+	
+	/*DMA1通道6初始化，OLED_TxBuf -> I2C1->DR，长度在每页发送前设置*/
+	DMA_DeInit(DMA1_Channel6);
+	DMA_InitTypeDef DMA_InitStructure;
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&I2C1->DR;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)OLED_TxBuf;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;		//存储器到外设
+	DMA_InitStructure.DMA_BufferSize = 0;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_Init(DMA1_Channel6, &DMA_InitStructure);
+	DMA_ITConfig(DMA1_Channel6, DMA_IT_TC, ENABLE);
+	
+	/*中断配置，I2C主机发送时可拉低SCL等待，优先级放在最低一级*/
+	NVIC_InitTypeDef NVIC_InitStructure;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_InitStructure.NVIC_IRQChannel = I2C1_EV_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
+	NVIC_InitStructure.NVIC_IRQChannel = I2C1_ER_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
+}
+
+#endif
+
 /*********************引脚配置*/
 
 
 /*通信协议*********************/
 
+#ifndef OLED_USE_HW_I2C
+
 /**
   * 函    数：I2C起始
   * 参    数：无
@@ -245,6 +445,297 @@ void OLED_WriteData(uint8_t *Data, uint8_t Count)
 	OLED_I2C_Stop();				//I2C终止
 }
 
+#else
+
+/**
+  * 函    数：等待硬件I2C事件
+  * 参    数：Event 等待的事件
+  * 返 回 值：0：成功，1：超时
+  */
+static uint8_t OLED_HW_WaitEvent(uint32_t Event)
+{
+	uint32_t Timeout = 0x10000;
+	while (I2C_CheckEvent(I2C1, Event) != SUCCESS)
+	{
+		if (--Timeout == 0) {return 1;}
+	}
+	return 0;
+}
+
+/**
+  * 函    数：中止正在发送的帧并恢复总线
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：在I2C1错误中断中或关中断时调用
+  *           当前页和之后未发送的页记入OLED_TxRetry，由OLED_CollectSpans重新标记为脏；
+  *           绘图函数在帧发送期间仍会改写脏区记录，这里只改副本，不直接改脏区
+  */
+static void OLED_HW_AbortFrame(void)
+{
+	uint8_t Page;
+	
+	I2C_ITConfig(I2C1, I2C_IT_EVT | I2C_IT_ERR, DISABLE);
+	I2C_DMACmd(I2C1, DISABLE);
+	DMA_Cmd(DMA1_Channel6, DISABLE);
+	DMA_ClearFlag(DMA1_FLAG_GL6);
+	
+	for (Page = OLED_TxPage; Page < 8; Page ++)
+	{
+		if (OLED_SpanWidth[Page] == 0) {continue;}
+		OLED_TxRetry |= 1 << Page;
+		
+		/*当前页的副本已在发送前更新，屏幕上实际写到哪里未知*/
+		if (Page == OLED_TxPage)
+		{
+			memset(&OLED_ShadowBuf[Page][OLED_SpanX[Page]], 0xFF, OLED_SpanWidth[Page]);
+		}
+	}
+	
+	OLED_HW_BusRecover();
+	
+	OLED_TxErrorCount ++;
+	OLED_TxBusy = 0;
+	if (OLED_DoneCallback) {OLED_DoneCallback();}
+}
+
+/**
+  * 函    数：查询帧是否仍在发送，超时则中止
+  * 参    数：Force 1：不论是否超时都中止
+  * 返 回 值：1：正在发送，0：空闲
+  * 说    明：SB不置位（BUSY残留）、从机拉住SCL等情况不会产生错误中断，
+  *           由此在OLED_TX_TIMEOUT_MS后中止本帧并恢复总线
+  */
+static uint8_t OLED_HW_PollBusy(uint8_t Force)
+{
+	uint32_t primask;
+	
+	if (!OLED_TxBusy) {return 0;}
+	
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (OLED_TxBusy && (Force ||
+		(uint32_t)(Timer3_GetTick() - OLED_TxStartTick) >= OLED_TX_TIMEOUT_MS * (TIM3_COUNTER_FREQ / 1000)))
+	{
+		OLED_HW_AbortFrame();
+	}
+	__set_PRIMASK(primask);
+	
+	return OLED_TxBusy;
+}
+
+/**
+  * 函    数：等待异步帧发送完成
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：超时由OLED_HW_PollBusy处理；TIM3启动前时间戳不变，另以循环次数限时
+  */
+static void OLED_HW_WaitIdle(void)
+{
+	uint32_t Spin = OLED_TX_WAIT_SPIN;
+	
+	while (OLED_HW_PollBusy(Spin == 0))
+	{
+		if (Spin > 0) {Spin --;}
+	}
+}
+
+/**
+  * 函    数：硬件I2C阻塞写入（查询方式）
+  * 参    数：Control 控制字节，0x00写命令，0x40写数据
+  * 参    数：Data 要写入数据的起始地址
+  * 参    数：Count 要写入数据的数量
+  * 返 回 值：无
+  * 说    明：用于初始化命令等少量数据，先等待异步帧发送完成，避免打断DMA传输
+  */
+static void OLED_HW_Write(uint8_t Control, uint8_t *Data, uint8_t Count)
+{
+	uint8_t i;
+	
+	OLED_HW_WaitIdle();								//等待异步帧发送完成
+	
+	I2C_GenerateSTART(I2C1, ENABLE);				//I2C起始
+	if (OLED_HW_WaitEvent(I2C_EVENT_MASTER_MODE_SELECT)) {goto error;}
+	
+	I2C_Send7bitAddress(I2C1, OLED_I2C_ADDR, I2C_Direction_Transmitter);
+	if (OLED_HW_WaitEvent(I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED)) {goto error;}
+	
+	I2C_SendData(I2C1, Control);					//控制字节
+	for (i = 0; i < Count; i ++)
+	{
+		if (OLED_HW_WaitEvent(I2C_EVENT_MASTER_BYTE_TRANSMITTING)) {goto error;}
+		I2C_SendData(I2C1, Data[i]);
+	}
+	if (OLED_HW_WaitEvent(I2C_EVENT_MASTER_BYTE_TRANSMITTED)) {goto error;}
+	
+	I2C_GenerateSTOP(I2C1, ENABLE);					//I2C终止
+	return;
+	
+error:
+	OLED_TxErrorCount ++;
+	OLED_HW_BusRecover();
+}
+
+/**
+  * 函    数：OLED写命令
+  * 参    数：Command 要写入的命令值，范围：0x00~0xFF
+  * 返 回 值：无
+  */
+void OLED_WriteCommand(uint8_t Command)
+{
+	OLED_HW_Write(0x00, &Command, 1);
+}
+
+/**
+  * 函    数：OLED写数据
+  * 参    数：Data 要写入数据的起始地址
+  * 参    数：Count 要写入数据的数量
+  * 返 回 值：无
+  */
+void OLED_WriteData(uint8_t *Data, uint8_t Count)
+{
+	OLED_HW_Write(0x40, Data, Count);
+}
+
+/**
+  * 函    数：启动下一页的DMA发送
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：从OLED_TxPage开始查找需要发送的页，全部发送完后结束本帧并回调
+  *           一页的数据格式：0x80 页地址 0x80 列高4位 0x80 列低4位 0x40 显存数据...
+  *           0x80表示后面跟一个命令字节，0x40表示后面全部为数据
+  */
+static void OLED_HW_StartPage(void)
+{
+	uint8_t Page, X, Width;
+	
+	/*跳过不需要发送的页*/
+	Page = OLED_TxPage;
+	while (Page < 8 && OLED_SpanWidth[Page] == 0)
+	{
+		Page ++;
+	}
+	OLED_TxPage = Page;
+	
+	/*全部页发送完成*/
+	if (Page >= 8)
+	{
+		OLED_TxBusy = 0;
+		if (OLED_DoneCallback) {OLED_DoneCallback();}
+		return;
+	}
+	
+	X = OLED_SpanX[Page];
+	Width = OLED_SpanWidth[Page];
+	
+	/*命令头：设置页地址和列地址（1.3寸SH1106屏需要在此把X加2）*/
+	OLED_TxBuf[0] = 0x80;
+	OLED_TxBuf[1] = 0xB0 | Page;
+	OLED_TxBuf[2] = 0x80;
+	OLED_TxBuf[3] = 0x10 | ((X & 0xF0) >> 4);
+	OLED_TxBuf[4] = 0x80;
+	OLED_TxBuf[5] = 0x00 | (X & 0x0F);
+	OLED_TxBuf[6] = 0x40;
+	memcpy(&OLED_TxBuf[OLED_TX_HEAD_LEN], &OLED_DisplayBuf[Page][X], Width);
+	memcpy(&OLED_ShadowBuf[Page][X], &OLED_TxBuf[OLED_TX_HEAD_LEN], Width);	//副本与实际发送内容一致
+	
+	/*DMA在地址发送完成(EV6)后由TXE请求开始搬运*/
+	DMA_SetCurrDataCounter(DMA1_Channel6, OLED_TX_HEAD_LEN + Width);
+	DMA_Cmd(DMA1_Channel6, ENABLE);
+	I2C_DMACmd(I2C1, ENABLE);
+	
+	I2C_ITConfig(I2C1, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+	I2C_GenerateSTART(I2C1, ENABLE);
+}
+
+/**
+  * 函    数：启动一帧异步发送
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：OLED_SpanX/OLED_SpanWidth需已填好，调用前OLED_TxBusy必须为0
+  */
+static void OLED_HW_StartFrame(void)
+{
+	OLED_TxStartTick = Timer3_GetTick();
+	OLED_TxBusy = 1;
+	OLED_TxPage = 0;
+	OLED_HW_StartPage();
+}
+
+/**
+  * 函    数：I2C1事件中断服务函数
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：EV5发送地址，EV6后交给DMA，数据发送完(BTF)后产生停止条件并启动下一页
+  */
+void I2C1_EV_IRQHandler(void)
+{
+	uint32_t Event = I2C_GetLastEvent(I2C1);	//读SR1和SR2，同时清除ADDR标志
+	uint16_t Timeout;
+	IRQSTAT_ENTER();
+	
+	if (Event & I2C_SR1_SB)					//EV5：起始条件已发送
+	{
+		I2C_Send7bitAddress(I2C1, OLED_I2C_ADDR, I2C_Direction_Transmitter);
+	}
+	else if (Event & I2C_SR1_ADDR)			//EV6：地址已应答，DMA开始搬运
+	{
+		I2C_ITConfig(I2C1, I2C_IT_EVT, DISABLE);	//DMA发送期间不需要事件中断
+	}
+	else if (Event & I2C_SR1_BTF)			//EV8_2：最后一个字节已发送
+	{
+		I2C_ITConfig(I2C1, I2C_IT_EVT | I2C_IT_ERR, DISABLE);
+		I2C_GenerateSTOP(I2C1, ENABLE);
+		
+		/*等待停止条件发出，约一个SCL周期*/
+		Timeout = 1000;
+		while ((I2C1->CR1 & I2C_CR1_STOP) && --Timeout);
+		
+		OLED_TxPage ++;
+		OLED_HW_StartPage();
+	}
+	
+	IRQSTAT_EXIT(IRQSTAT_OLED_EV);
+}
+
+/**
+  * 函    数：I2C1错误中断服务函数
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：无应答、总线错误或仲裁丢失时放弃本帧并恢复总线，下次更新时重新发送
+  */
+void I2C1_ER_IRQHandler(void)
+{
+	I2C_ClearITPendingBit(I2C1, I2C_IT_AF | I2C_IT_BERR | I2C_IT_ARLO | I2C_IT_OVR);
+	
+	/*本帧已因超时中止*/
+	if (!OLED_TxBusy) {return;}
+	
+	OLED_HW_AbortFrame();
+}
+
+/**
+  * 函    数：DMA1通道6中断服务函数
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：DMA搬运完成时最后一个字节可能还在移位，打开事件中断等待BTF
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+	IRQSTAT_ENTER();
+	
+	if (DMA_GetITStatus(DMA1_IT_TC6) == SET)
+	{
+		DMA_ClearITPendingBit(DMA1_IT_TC6);
+		DMA_Cmd(DMA1_Channel6, DISABLE);
+		I2C_DMACmd(I2C1, DISABLE);
+		I2C_ITConfig(I2C1, I2C_IT_EVT, ENABLE);
+	}
+	
+	IRQSTAT_EXIT(IRQSTAT_DMA6);
+}
+
+#endif
+
 /*********************通信协议*/
 
 
@@ -300,6 +791,7 @@ void OLED_Init(void)
 	OLED_WriteCommand(0xAF);	//开启显示
 	
 	OLED_Clear();				//清空显存数组
+	memset(OLED_ShadowBuf, 0xFF, sizeof(OLED_ShadowBuf));	//屏幕内容未知，副本置为与显存全部不同
 	OLED_Update();				//更新显示，清屏，防止初始化后未显示内容时花屏
 }
 
@@ -401,6 +893,117 @@ uint8_t OLED_IsInAngle(int16_t X, int16_t Y, int16_t StartAngle, int16_t EndAngl
 	return 0;		//不满足以上条件，则判断判定指定点不在指定角度
 }
 
+/**
+  * 函    数：标记某页的一段列范围被改动
+  * 参    数：Page 页，范围：0~7
+  * 参    数：X0 X1 起始列和终止列，范围：0~127，X0 <= X1
+  * 返 回 值：无
+  */
+static void OLED_MarkDirty(uint8_t Page, uint8_t X0, uint8_t X1)
+{
+	if (X0 < OLED_DirtyX0[Page]) {OLED_DirtyX0[Page] = X0;}
+	if (X1 > OLED_DirtyX1[Page]) {OLED_DirtyX1[Page] = X1;}
+}
+
+/**
+  * 函    数：标记一个矩形区域被改动
+  * 参    数：X Y Width Height 区域，调用前需保证区域在屏幕范围内且宽高不为0
+  * 返 回 值：无
+  */
+static void OLED_MarkDirtyArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
+{
+	uint8_t j;
+	for (j = Y / 8; j <= (Y + Height - 1) / 8; j ++)
+	{
+		OLED_MarkDirty(j, X, X + Width - 1);
+	}
+}
+
+/**
+  * 函    数：计算本次更新需要发送的范围
+  * 参    数：X0 X1 限定的列范围，范围：0~127
+  * 参    数：Page0 Page1 限定的页范围，范围：0~7
+  * 返 回 值：需要发送的页数
+  * 说    明：在脏区与限定范围的交集内，找出与屏幕副本不同的第一个和最后一个字节，
+  *           结果写入OLED_SpanX/OLED_SpanWidth
+  *           限定范围覆盖了整页脏区时，清除该页的脏区记录
+  *           上一帧出错未发完的页先按上一帧的范围重新标记为脏
+  */
+static uint8_t OLED_CollectSpans(uint8_t X0, uint8_t X1, uint8_t Page0, uint8_t Page1)
+{
+	uint8_t j, Start, End, Count = 0;
+	
+#ifdef OLED_USE_HW_I2C
+	/*调用时没有帧在发送，OLED_TxRetry和上一帧的范围不会再被中断改写*/
+	if (OLED_TxRetry)
+	{
+		for (j = 0; j < 8; j ++)
+		{
+			if (OLED_TxRetry & (1 << j))
+			{
+				OLED_MarkDirty(j, OLED_SpanX[j], OLED_SpanX[j] + OLED_SpanWidth[j] - 1);
+			}
+		}
+		OLED_TxRetry = 0;
+	}
+#endif
+	
+	for (j = 0; j < 8; j ++)
+	{
+		OLED_SpanWidth[j] = 0;
+		
+		/*不在限定页范围内，或该页未改动*/
+		if (j < Page0 || j > Page1) {continue;}
+		if (OLED_DirtyX0[j] > OLED_DirtyX1[j]) {continue;}
+		
+		Start = OLED_DirtyX0[j] > X0 ? OLED_DirtyX0[j] : X0;
+		End = OLED_DirtyX1[j] < X1 ? OLED_DirtyX1[j] : X1;
+		
+		/*去掉两端与屏幕内容相同的字节*/
+		while (Start <= End && OLED_DisplayBuf[j][Start] == OLED_ShadowBuf[j][Start]) {Start ++;}
+		if (Start <= End)
+		{
+			while (OLED_DisplayBuf[j][End] == OLED_ShadowBuf[j][End]) {End --;}
+			OLED_SpanX[j] = Start;
+			OLED_SpanWidth[j] = End - Start + 1;
+			Count ++;
+		}
+		
+		if (X0 <= OLED_DirtyX0[j] && X1 >= OLED_DirtyX1[j])
+		{
+			OLED_DirtyX0[j] = 0xFF;
+			OLED_DirtyX1[j] = 0;
+		}
+	}
+	
+	return Count;
+}
+
+/**
+  * 函    数：发送OLED_CollectSpans计算出的范围
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：硬件I2C模式下启动异步发送后立即返回
+  */
+static void OLED_SendSpans(void)
+{
+#ifdef OLED_USE_HW_I2C
+	OLED_HW_StartFrame();
+#else
+	uint8_t j, X, Width;
+	for (j = 0; j < 8; j ++)
+	{
+		X = OLED_SpanX[j];
+		Width = OLED_SpanWidth[j];
+		if (Width == 0) {continue;}
+		
+		OLED_SetCursor(j, X);
+		OLED_WriteData(&OLED_DisplayBuf[j][X], Width);
+		memcpy(&OLED_ShadowBuf[j][X], &OLED_DisplayBuf[j][X], Width);
+	}
+#endif
+}
+
 /*********************工具函数*/
 
 
@@ -414,18 +1017,18 @@ uint8_t OLED_IsInAngle(int16_t X, int16_t Y, int16_t StartAngle, int16_t EndAngl
   *           随后调用OLED_Update函数或OLED_UpdateArea函数
   *           才会将显存数组的数据发送到OLED硬件，进行显示
   *           故调用显示函数后，要想真正地呈现在屏幕上，还需调用更新函数
+  * 说    明：只发送各页被改动过、且与屏幕当前内容不同的列，没有改动时不产生任何通信
   */
 void OLED_Update(void)
 {
-	uint8_t j;
-	/*遍历每一页*/
-	for (j = 0; j < 8; j ++)
-	{
-		/*设置光标位置为每一页的第一列*/
-		OLED_SetCursor(j, 0);
-		/*连续写入128个数据，将显存数组的数据写入到OLED硬件*/
-		OLED_WriteData(OLED_DisplayBuf[j], 128);
-	}
+#ifdef OLED_USE_HW_I2C
+	OLED_HW_WaitIdle();				//等待上一帧完成
+#endif
+	OLED_CollectSpans(0, 127, 0, 7);
+	OLED_SendSpans();
+#ifdef OLED_USE_HW_I2C
+	OLED_HW_WaitIdle();				//等待本帧发送完成
+#endif
 }
 
 /**
@@ -444,23 +1047,73 @@ void OLED_Update(void)
   */
 void OLED_UpdateArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
 {
-	uint8_t j;
-	
 	/*参数检查，保证指定区域不会超出屏幕范围*/
 	if (X > 127) {return;}
 	if (Y > 63) {return;}
 	if (X + Width > 128) {Width = 128 - X;}
 	if (Y + Height > 64) {Height = 64 - Y;}
+	if (Width == 0 || Height == 0) {return;}
 	
-	/*遍历指定区域涉及的相关页*/
-	/*(Y + Height - 1) / 8 + 1的目的是(Y + Height) / 8并向上取整*/
-	for (j = Y / 8; j < (Y + Height - 1) / 8 + 1; j ++)
-	{
-		/*设置光标位置为相关页的指定列*/
-		OLED_SetCursor(j, X);
-		/*连续写入Width个数据，将显存数组的数据写入到OLED硬件*/
-		OLED_WriteData(&OLED_DisplayBuf[j][X], Width);
-	}
+#ifdef OLED_USE_HW_I2C
+	OLED_HW_WaitIdle();				//等待上一帧完成
+#endif
+	/*只发送指定区域涉及的相关页中，被改动且与屏幕内容不同的列*/
+	OLED_CollectSpans(X, X + Width - 1, Y / 8, (Y + Height - 1) / 8);
+	OLED_SendSpans();
+#ifdef OLED_USE_HW_I2C
+	OLED_HW_WaitIdle();				//等待发送完成
+#endif
+}
+
+/**
+  * 函    数：启动一次非阻塞的整屏更新
+  * 参    数：无
+  * 返 回 值：0：已启动，1：上一帧尚未发送完成，本次未启动
+  * 说    明：与OLED_Update相同，只发送改动过的列
+  *           硬件I2C模式下立即返回，由DMA和中断在后台逐页发送
+  *           每页在开始发送时才从显存复制，调用后可以马上继续绘制下一帧
+  *           发送完成后OLED_IsBusy返回0，并调用OLED_SetDoneCallback设置的回调
+  *           上一帧超过OLED_TX_TIMEOUT_MS未完成时中止该帧并恢复总线，未发完的页下次重发
+  *           软件I2C模式下等同于OLED_Update，返回时已发送完成
+  */
+uint8_t OLED_UpdateAsync(void)
+{
+#ifdef OLED_USE_HW_I2C
+	if (OLED_HW_PollBusy(0)) {return 1;}
+	
+	OLED_CollectSpans(0, 127, 0, 7);
+	OLED_HW_StartFrame();
+#else
+	OLED_Update();
+	if (OLED_DoneCallback) {OLED_DoneCallback();}
+#endif
+	return 0;
+}
+
+/**
+  * 函    数：查询异步更新是否仍在进行
+  * 参    数：无
+  * 返 回 值：1：正在发送，0：空闲
+  * 说    明：硬件I2C模式下同时检查发送超时
+  */
+uint8_t OLED_IsBusy(void)
+{
+#ifdef OLED_USE_HW_I2C
+	return OLED_HW_PollBusy(0);
+#else
+	return 0;
+#endif
+}
+
+/**
+  * 函    数：设置异步更新完成回调
+  * 参    数：Callback 回调函数，传入0取消回调
+  * 返 回 值：无
+  * 说    明：硬件I2C模式下回调在中断中执行，应尽量简短
+  */
+void OLED_SetDoneCallback(void (*Callback)(void))
+{
+	OLED_DoneCallback = Callback;
 }
 
 /**
@@ -478,6 +1131,7 @@ void OLED_Clear(void)
 		{
 			OLED_DisplayBuf[j][i] = 0x00;	//将显存数组数据全部清零
 		}
+		OLED_MarkDirty(j, 0, 127);
 	}
 }
 
@@ -499,6 +1153,7 @@ void OLED_ClearArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
 	if (Y > 63) {return;}
 	if (X + Width > 128) {Width = 128 - X;}
 	if (Y + Height > 64) {Height = 64 - Y;}
+	if (Width == 0 || Height == 0) {return;}
 	
 	for (j = Y; j < Y + Height; j ++)		//遍历指定页
 	{
@@ -507,6 +1162,7 @@ void OLED_ClearArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
 			OLED_DisplayBuf[j / 8][i] &= ~(0x01 << (j % 8));	//将显存数组指定数据清零
 		}
 	}
+	OLED_MarkDirtyArea(X, Y, Width, Height);
 }
 
 /**
@@ -524,6 +1180,7 @@ void OLED_Reverse(void)
 		{
 			OLED_DisplayBuf[j][i] ^= 0xFF;	//将显存数组数据全部取反
 		}
+		OLED_MarkDirty(j, 0, 127);
 	}
 }
 	
@@ -545,6 +1202,7 @@ void OLED_ReverseArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
 	if (Y > 63) {return;}
 	if (X + Width > 128) {Width = 128 - X;}
 	if (Y + Height > 64) {Height = 64 - Y;}
+	if (Width == 0 || Height == 0) {return;}
 	
 	for (j = Y; j < Y + Height; j ++)		//遍历指定页
 	{
@@ -553,6 +1211,7 @@ void OLED_ReverseArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height)
 			OLED_DisplayBuf[j / 8][i] ^= 0x01 << (j % 8);	//将显存数组指定数据取反
 		}
 	}
+	OLED_MarkDirtyArea(X, Y, Width, Height);
 }
 
 /**
@@ -819,6 +1478,13 @@ void OLED_ShowImage(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height, const u
 			/*显示图像在下一页的内容*/
 			OLED_DisplayBuf[Y / 8 + j + 1][X + i] |= Image[j * Width + i] >> (8 - Y % 8);
 		}
+		
+		/*标记当前页和下一页被改动*/
+		if (Width > 0)
+		{
+			OLED_MarkDirty(Y / 8 + j, X, X + Width - 1 > 127 ? 127 : X + Width - 1);
+			if (Y / 8 + j + 1 <= 7) {OLED_MarkDirty(Y / 8 + j + 1, X, X + Width - 1 > 127 ? 127 : X + Width - 1);}
+		}
 	}
 }
 
@@ -859,6 +1525,7 @@ void OLED_DrawPoint(uint8_t X, uint8_t Y)
 	
 	/*将显存数组指定位置的一个Bit数据置1*/
 	OLED_DisplayBuf[Y / 8][X] |= 0x01 << (Y % 8);
+	OLED_MarkDirty(Y / 8, X, X);
 }
 
 /**
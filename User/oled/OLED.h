@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "OLED_Data.h"
+#include "kconfig.h"
 
 /*参数宏定义*********************/
 
@@ -26,6 +27,9 @@ void OLED_Init(void);
 /*更新函数*/
 void OLED_Update(void);
 void OLED_UpdateArea(uint8_t X, uint8_t Y, uint8_t Width, uint8_t Height);
+uint8_t OLED_UpdateAsync(void);
+uint8_t OLED_IsBusy(void);
+void OLED_SetDoneCallback(void (*Callback)(void));
 
 /*显存控制函数*/
 void OLED_Clear(void);
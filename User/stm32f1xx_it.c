@@ -9,6 +9,8 @@
 #include "stm32f10x.h"
 #include "stm32f10x_exti.h"
 #include "stm32f1xx_it.h" 
+#include "max30102.h"
+#include "module/irqstat/irqstat.h"
 
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -96,13 +98,19 @@ void SysTick_Handler(void)
 
 /**
   * @brief  This function handles EXTI9_5 interrupt.
+  * @note   MAX30102 FIFO将满，置标志由主循环突发读取（I2C不在中断中访问）
   */
 void EXTI9_5_IRQHandler(void)
 {
-    if(EXTI_GetITStatus(EXTI_Line5) != RESET)
+    IRQSTAT_ENTER();
+
+    if(EXTI_GetITStatus(MAX30102_INT_EXTI_Line) != RESET)
     {
-        EXTI_ClearITPendingBit(EXTI_Line5);
+        EXTI_ClearITPendingBit(MAX30102_INT_EXTI_Line);
+        max30102_fifo_flag = 1;
     }
+
+    IRQSTAT_EXIT(IRQSTAT_EXTI);
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -16,6 +16,7 @@ void DEBUG_USART_Config(void)
 {
     GPIO_InitTypeDef GPIO_InitStructure;
     USART_InitTypeDef USART_InitStructure;
+    DMA_InitTypeDef DMA_InitStructure;
 
     /* 使能GPIO时钟 */
     RCC_APB2PeriphClockCmd(DEBUG_USART_TX_GPIO_CLK | DEBUG_USART_RX_GPIO_CLK, ENABLE);
@@ -44,10 +45,59 @@ void DEBUG_USART_Config(void)
     
     USART_Init(DEBUG_USART, &USART_InitStructure);
     
+    /* DMA1通道4: 发送缓冲 -> USART1->DR，地址和长度在每次发送时设置 */
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DEBUG_USART_TX_DMA_CHANNEL);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&DEBUG_USART->DR;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryBaseAddr = 0;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 0;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_Init(DEBUG_USART_TX_DMA_CHANNEL, &DMA_InitStructure);
+    USART_DMACmd(DEBUG_USART, USART_DMAReq_Tx, ENABLE);
+    
     /* 使能USART1 */
     USART_Cmd(DEBUG_USART, ENABLE);
 }
 
+/**
+ * @brief  以DMA发送一段数据，立即返回
+ * @param  buf: 数据，发送完成前不可改写
+ * @param  len: 字节数
+ * @retval 0: 已启动, 1: 上一次发送未完成
+ * @note   与printf不可同时使用
+ */
+uint8_t Usart_SendDMA(const uint8_t *buf, uint16_t len)
+{
+    if (Usart_TxBusy())
+    {
+        return 1;
+    }
+    
+    DMA_Cmd(DEBUG_USART_TX_DMA_CHANNEL, DISABLE);
+    DEBUG_USART_TX_DMA_CHANNEL->CMAR = (uint32_t)buf;
+    DMA_SetCurrDataCounter(DEBUG_USART_TX_DMA_CHANNEL, len);
+    DMA_Cmd(DEBUG_USART_TX_DMA_CHANNEL, ENABLE);
+    return 0;
+}
+
+/**
+ * @brief  DMA发送是否未完成
+ * @retval 1: 发送中, 0: 空闲
+ * @note   DMA搬运完最后一个字节时它可能还在移位，对连续发送没有影响
+ */
+uint8_t Usart_TxBusy(void)
+{
+    return (DEBUG_USART_TX_DMA_CHANNEL->CCR & DMA_CCR1_EN) != 0
+        && DMA_GetCurrDataCounter(DEBUG_USART_TX_DMA_CHANNEL) != 0;
+}
+
 /*****************  发送字符串 **********************/
 void Usart_SendString(uint8_t *str)
 {
@@ -5,6 +5,7 @@
 #include "stm32f10x_usart.h"
 #include "stm32f10x_gpio.h"
 #include "stm32f10x_rcc.h"
+#include "stm32f10x_dma.h"
 #include <stdio.h>
 
 /* 串口参数 */
@@ -25,9 +26,13 @@
 
 #define DEBUG_USART_IRQHandler                  USART1_IRQHandler
 #define DEBUG_USART_IRQn                        USART1_IRQn
+
+#define DEBUG_USART_TX_DMA_CHANNEL              DMA1_Channel4
 /************************************************************/
 
 void Usart_SendString(uint8_t *str);
+uint8_t Usart_SendDMA(const uint8_t *buf, uint16_t len);
+uint8_t Usart_TxBusy(void);
 void DEBUG_USART_Config(void);
 int fputc(int ch, FILE *f);
 int fgetc(FILE *f);